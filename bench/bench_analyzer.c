@@ -0,0 +1,188 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Analyzer microbenchmark
+ *
+ * Times each analyzer kernel (window, peak search, level) at every
+ * instruction set level the CPU supports, per-frame against batched
+ * FFTs, then the whole streaming analysis of a WAV file.
+ *
+ * Usage: bench_analyzer [file.wav] [iterations]
+ */
+
+#include "audio/analyzer.h"
+#include "audio/analyzer_simd.h"
+#include "audio/wav_reader.h"
+#include "util/time_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define BENCH_FFT_SIZE 512
+#define DEFAULT_WAV "test_audio/long_tone.wav"
+#define DEFAULT_ITERATIONS 20000
+
+/* Keeps results live so the compiler cannot drop the work */
+static volatile uint64_t g_sink;
+
+static double bench_window(const vu_analyzer_kernels_t *k, const int16_t *pcm,
+                           const float *window, float *out, int iterations)
+{
+    double start = vu_time_monotonic_sec();
+    for (int i = 0; i < iterations; i++) {
+        k->window(out, pcm, window, BENCH_FFT_SIZE);
+        g_sink += (uint64_t)out[i % BENCH_FFT_SIZE];
+    }
+    return vu_time_monotonic_sec() - start;
+}
+
+static double bench_peak(const vu_analyzer_kernels_t *k, const float *spectrum, int iterations)
+{
+    double start = vu_time_monotonic_sec();
+    for (int i = 0; i < iterations; i++) {
+        float power;
+        g_sink += (uint64_t)k->peak_power(spectrum, 1, BENCH_FFT_SIZE / 2, &power);
+    }
+    return vu_time_monotonic_sec() - start;
+}
+
+static double bench_level(const vu_analyzer_kernels_t *k, const int16_t *pcm, int iterations)
+{
+    double start = vu_time_monotonic_sec();
+    for (int i = 0; i < iterations; i++) {
+        uint64_t sum;
+        int32_t peak;
+        k->level(pcm, BENCH_FFT_SIZE, &sum, &peak);
+        g_sink += sum + (uint64_t)peak;
+    }
+    return vu_time_monotonic_sec() - start;
+}
+
+/* Load one frame of PCM from the file, or synthesize a tone if unavailable */
+static void load_frame(const char *path, int16_t *pcm)
+{
+    vu_wav_reader_t *reader = vu_wav_reader_open(path);
+    const int16_t *data = reader ? vu_wav_reader_peek(reader, BENCH_FFT_SIZE) : NULL;
+
+    if (data) {
+        memcpy(pcm, data, BENCH_FFT_SIZE * sizeof(int16_t));
+    } else {
+        fprintf(stderr, "Using synthetic 1 kHz tone (could not read %s)\n", path);
+        for (int i = 0; i < BENCH_FFT_SIZE; i++) {
+            pcm[i] = (int16_t)(16000.0 * sin(2.0 * M_PI * 1000.0 * i / 8000.0));
+        }
+    }
+    vu_wav_reader_close(reader);
+}
+
+/* Per-frame detect_frequency against one batched call over the same frames */
+static void bench_batch(const int16_t *pcm, int iterations)
+{
+    enum { FRAMES = 64, HOP = BENCH_FFT_SIZE / 2 };
+    static int16_t signal[BENCH_FFT_SIZE + (FRAMES - 1) * HOP];
+    vu_freq_result_t results[FRAMES];
+
+    for (size_t i = 0; i < sizeof(signal) / sizeof(signal[0]); i++) {
+        signal[i] = pcm[i % BENCH_FFT_SIZE];
+    }
+
+    vu_analyzer_config_t config = vu_analyzer_default_config();
+    config.fft_size = BENCH_FFT_SIZE;
+    vu_analyzer_t *analyzer = vu_analyzer_create(&config);
+    if (!analyzer) return;
+
+    int rounds = iterations / FRAMES > 0 ? iterations / FRAMES : 1;
+
+    double start = vu_time_monotonic_sec();
+    for (int r = 0; r < rounds; r++) {
+        for (int f = 0; f < FRAMES; f++) {
+            vu_analyzer_detect_frequency(analyzer, signal + f * HOP, BENCH_FFT_SIZE, &results[f]);
+        }
+        g_sink += (uint64_t)results[r % FRAMES].frequency;
+    }
+    double single = vu_time_monotonic_sec() - start;
+
+    start = vu_time_monotonic_sec();
+    for (int r = 0; r < rounds; r++) {
+        vu_analyzer_detect_frequency_batch(analyzer, signal, HOP, FRAMES, results);
+        g_sink += (uint64_t)results[r % FRAMES].frequency;
+    }
+    double batched = vu_time_monotonic_sec() - start;
+
+    double frames = (double)rounds * FRAMES;
+    printf("\nFFT per frame: %.1f ns/frame, batched: %.1f ns/frame (%.2fx)\n",
+           single * 1e9 / frames, batched * 1e9 / frames, single / batched);
+
+    vu_analyzer_destroy(analyzer);
+}
+
+static bool count_frame(void *user_data, const vu_analysis_frame_t *frame)
+{
+    (void)frame;
+    (*(size_t *)user_data)++;
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = argc > 1 ? argv[1] : DEFAULT_WAV;
+    int iterations = argc > 2 ? atoi(argv[2]) : DEFAULT_ITERATIONS;
+    if (iterations <= 0) iterations = DEFAULT_ITERATIONS;
+
+    int16_t pcm[BENCH_FFT_SIZE];
+    float window[BENCH_FFT_SIZE];
+    float out[BENCH_FFT_SIZE];
+    float spectrum[BENCH_FFT_SIZE + 2];
+
+    load_frame(path, pcm);
+    for (int i = 0; i < BENCH_FFT_SIZE; i++) {
+        window[i] = 0.5f * (1.0f - cosf(2.0f * M_PI * i / (BENCH_FFT_SIZE - 1)));
+    }
+    srand(1);
+    for (int i = 0; i < BENCH_FFT_SIZE + 2; i++) {
+        spectrum[i] = (float)rand() / RAND_MAX - 0.5f;
+    }
+
+    printf("Analyzer kernels: %d x %d-sample frames (selected: %s)\n\n",
+           iterations, BENCH_FFT_SIZE, vu_analyzer_kernels()->name);
+    printf("%-8s %14s %14s %14s\n", "isa", "window ns", "peak ns", "level ns");
+
+    double base[3] = {0};
+    for (int level = VU_SIMD_SCALAR; level < VU_SIMD_COUNT; level++) {
+        const vu_analyzer_kernels_t *k = vu_analyzer_kernels_for((vu_simd_level_t)level);
+        if (!k) {
+            printf("%-8s %14s\n", level == VU_SIMD_SSE2 ? "sse2" : "avx2", "unsupported");
+            continue;
+        }
+
+        double t[3] = {
+            bench_window(k, pcm, window, out, iterations),
+            bench_peak(k, spectrum, iterations),
+            bench_level(k, pcm, iterations),
+        };
+
+        printf("%-8s", k->name);
+        for (int j = 0; j < 3; j++) {
+            if (level == VU_SIMD_SCALAR) base[j] = t[j];
+            printf(" %9.1f (%.1fx)", t[j] * 1e9 / iterations, base[j] / t[j]);
+        }
+        printf("\n");
+    }
+
+    bench_batch(pcm, iterations);
+
+    /* End to end: streaming analysis with the dispatched kernels */
+    size_t frames = 0;
+    double start = vu_time_monotonic_sec();
+    vu_analysis_summary_t summary;
+    vu_error_t err = vu_analyzer_analyze_file_stream(path, NULL, count_frame, &frames, &summary);
+    double elapsed = vu_time_monotonic_sec() - start;
+
+    if (err == VU_OK && elapsed > 0) {
+        printf("\n%s: %zu frames, %.2f s audio in %.2f ms (%.0fx realtime)\n",
+               path, frames, summary.duration_sec, elapsed * 1000.0,
+               summary.duration_sec / elapsed);
+    }
+
+    return 0;
+}
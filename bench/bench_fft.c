@@ -0,0 +1,160 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Real FFT benchmark: built-in against FFTW
+ *
+ * Times one real-to-complex transform at each analyzer frame size with
+ * the built-in FFT at every instruction set level the CPU supports and,
+ * in FFTW builds, with FFTW's estimated and measured plans. Also reports
+ * each transform's largest error against a double-precision DFT, relative
+ * to the spectrum's peak.
+ *
+ * Usage: bench_fft [iterations per size at 512 points]
+ */
+
+#include "audio/analyzer_simd.h"
+#include "audio/real_fft.h"
+#include "util/time_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#ifndef VU_FFT_BUILTIN
+#include <fftw3.h>
+#endif
+
+#define DEFAULT_ITERATIONS 200000
+#define MIN_SIZE 64
+#define MAX_SIZE 4096
+#define ROUNDS 5                   /* Best of, to ride out scheduler noise */
+
+/* Keeps results live so the compiler cannot drop the work */
+static volatile float g_sink;
+
+/* Largest |out - ref| over the spectrum, relative to the largest |ref| */
+static double relative_error(const float *out, const double *ref, int size)
+{
+    double worst = 0.0, peak = 0.0;
+    for (int i = 0; i < size + 2; i++) {
+        double diff = fabs(out[i] - ref[i]);
+        if (diff > worst) worst = diff;
+        if (fabs(ref[i]) > peak) peak = fabs(ref[i]);
+    }
+    return peak > 0.0 ? worst / peak : worst;
+}
+
+static void reference_dft(const float *in, double *ref, int size)
+{
+    for (int k = 0; k <= size / 2; k++) {
+        double re = 0.0, im = 0.0;
+        for (int i = 0; i < size; i++) {
+            double angle = 2.0 * M_PI * (double)(((long)k * i) % size) / size;
+            re += in[i] * cos(angle);
+            im -= in[i] * sin(angle);
+        }
+        ref[2 * k] = re;
+        ref[2 * k + 1] = im;
+    }
+}
+
+static double time_builtin(const vu_rfft_t *rfft, const float *in, float *out, int iterations)
+{
+    double best = 0.0;
+    for (int r = 0; r < ROUNDS; r++) {
+        double start = vu_time_monotonic_sec();
+        for (int i = 0; i < iterations; i++) {
+            vu_rfft_execute(rfft, in, out);
+            g_sink += out[2];
+        }
+        double elapsed = vu_time_monotonic_sec() - start;
+        if (r == 0 || elapsed < best) best = elapsed;
+    }
+    return best * 1e9 / iterations;
+}
+
+#ifndef VU_FFT_BUILTIN
+/* Time an FFTW plan and leave its spectrum of `in` in `out` */
+static double time_fftw(int size, unsigned flags, const float *in, float *out, int iterations)
+{
+    float *fin = fftwf_alloc_real(size);
+    fftwf_complex *fout = fftwf_alloc_complex(size / 2 + 1);
+    fftwf_plan plan = fftwf_plan_dft_r2c_1d(size, fin, fout, flags);
+    memcpy(fin, in, size * sizeof(float));
+
+    double best = 0.0;
+    for (int r = 0; r < ROUNDS; r++) {
+        double start = vu_time_monotonic_sec();
+        for (int i = 0; i < iterations; i++) {
+            fftwf_execute(plan);
+            g_sink += fout[1][0];
+        }
+        double elapsed = vu_time_monotonic_sec() - start;
+        if (r == 0 || elapsed < best) best = elapsed;
+    }
+    memcpy(out, fout, (size + 2) * sizeof(float));
+
+    fftwf_destroy_plan(plan);
+    fftwf_free(fout);
+    fftwf_free(fin);
+    return best * 1e9 / iterations;
+}
+#endif
+
+int main(int argc, char **argv)
+{
+    int base_iterations = argc > 1 ? atoi(argv[1]) : DEFAULT_ITERATIONS;
+    if (base_iterations <= 0) base_iterations = DEFAULT_ITERATIONS;
+
+    float *in = malloc(MAX_SIZE * sizeof(float));
+    float *out = malloc((MAX_SIZE + 2) * sizeof(float));
+    double *ref = malloc((MAX_SIZE + 2) * sizeof(double));
+    if (!in || !out || !ref) return 1;
+
+    /* Tone plus noise, the kind of frame the analyzer sees */
+    uint32_t seed = 12345;
+    for (int i = 0; i < MAX_SIZE; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        in[i] = 0.5f * sinf(2.0f * (float)M_PI * 1000.0f * i / 8000.0f) +
+                0.01f * ((float)(int32_t)seed / 2147483648.0f);
+    }
+
+    printf("Real FFT, ns per transform (relative error vs double DFT), best of %d\n\n", ROUNDS);
+    printf("%6s", "size");
+    for (int level = VU_SIMD_SCALAR; level < VU_SIMD_COUNT; level++) {
+        const vu_analyzer_kernels_t *k = vu_analyzer_kernels_for((vu_simd_level_t)level);
+        if (k) printf(" %20s", k->name);
+    }
+#ifndef VU_FFT_BUILTIN
+    printf(" %20s %20s", "fftw estimate", "fftw measure");
+#endif
+    printf("\n");
+
+    for (int size = MIN_SIZE; size <= MAX_SIZE; size *= 2) {
+        int iterations = (int)((long)base_iterations * 512 / size);
+        if (iterations < 1) iterations = 1;
+        reference_dft(in, ref, size);
+
+        printf("%6d", size);
+        for (int level = VU_SIMD_SCALAR; level < VU_SIMD_COUNT; level++) {
+            const vu_analyzer_kernels_t *k = vu_analyzer_kernels_for((vu_simd_level_t)level);
+            if (!k) continue;
+
+            vu_rfft_t *rfft = vu_rfft_create(size, k);
+            if (!rfft) return 1;
+            double ns = time_builtin(rfft, in, out, iterations);
+            printf(" %9.1f (%8.1e)", ns, relative_error(out, ref, size));
+            vu_rfft_destroy(rfft);
+        }
+#ifndef VU_FFT_BUILTIN
+        double ns = time_fftw(size, FFTW_ESTIMATE, in, out, iterations);
+        printf(" %9.1f (%8.1e)", ns, relative_error(out, ref, size));
+        ns = time_fftw(size, FFTW_MEASURE, in, out, iterations);
+        printf(" %9.1f (%8.1e)", ns, relative_error(out, ref, size));
+#endif
+        printf("\n");
+    }
+
+    free(ref);
+    free(out);
+    free(in);
+    return 0;
+}
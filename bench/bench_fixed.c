@@ -0,0 +1,137 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Floating-point against fixed-point analysis benchmark
+ *
+ * Runs the same frames through the float analyzer and through the integer
+ * window/FFT/peak kernels the fixed-point build uses, then reports the
+ * time per frame of each and how far their peaks disagree.
+ *
+ * Usage: bench_fixed [file.wav] [rounds]
+ */
+
+#include "audio/analyzer.h"
+#include "audio/fft_plan.h"
+#include "audio/fixed_dsp.h"
+#include "audio/wav_reader.h"
+#include "util/time_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define BENCH_FFT_SIZE 512
+#define BENCH_HOP (BENCH_FFT_SIZE / 2)
+#define MAX_FRAMES 4096
+#define DEFAULT_WAV "test_audio/long_tone.wav"
+#define DEFAULT_ROUNDS 20
+
+/* Keeps results live so the compiler cannot drop the work */
+static volatile uint64_t g_sink;
+
+/* Read up to MAX_FRAMES overlapping frames; returns the frame count */
+static size_t load_frames(const char *path, int16_t **pcm)
+{
+    vu_wav_reader_t *reader = vu_wav_reader_open(path);
+    if (!reader) return 0;
+
+    uint64_t samples = vu_wav_reader_get_info(reader)->sample_count;
+    size_t frames = samples >= BENCH_FFT_SIZE ?
+                    (size_t)((samples - BENCH_FFT_SIZE) / BENCH_HOP + 1) : 0;
+    if (frames > MAX_FRAMES) frames = MAX_FRAMES;
+
+    size_t count = frames > 0 ? BENCH_FFT_SIZE + (frames - 1) * BENCH_HOP : 0;
+    const int16_t *data = count > 0 ? vu_wav_reader_peek(reader, count) : NULL;
+    *pcm = data ? malloc(count * sizeof(int16_t)) : NULL;
+    if (*pcm) {
+        memcpy(*pcm, data, count * sizeof(int16_t));
+    } else {
+        frames = 0;
+    }
+
+    vu_wav_reader_close(reader);
+    return frames;
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = argc > 1 ? argv[1] : DEFAULT_WAV;
+    int rounds = argc > 2 ? atoi(argv[2]) : DEFAULT_ROUNDS;
+    if (rounds <= 0) rounds = DEFAULT_ROUNDS;
+
+    int16_t *pcm = NULL;
+    size_t frames = load_frames(path, &pcm);
+    if (frames == 0) {
+        fprintf(stderr, "Could not read frames from %s\n", path);
+        return 1;
+    }
+
+    /* Every frame through the FFT: no energy gate */
+    vu_analyzer_config_t config = vu_analyzer_default_config();
+    config.fft_size = BENCH_FFT_SIZE;
+    config.energy_gate = false;
+    vu_analyzer_t *analyzer = vu_analyzer_create(&config);
+    vu_fixed_fft_t *fft = vu_fixed_fft_create(BENCH_FFT_SIZE);
+    vu_freq_result_t *freqs = malloc(frames * sizeof(vu_freq_result_t));
+    vu_level_result_t *levels = malloc(frames * sizeof(vu_level_result_t));
+    int32_t *buffer = malloc((BENCH_FFT_SIZE + 2) * sizeof(int32_t));
+    int *bins = malloc(frames * sizeof(int));
+    float *dbs = malloc(frames * sizeof(float));
+    if (!analyzer || !fft || !freqs || !levels || !buffer || !bins || !dbs) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    double start = vu_time_monotonic_sec();
+    for (int r = 0; r < rounds; r++) {
+        vu_analyzer_analyze_batch(analyzer, pcm, BENCH_HOP, frames, freqs, levels);
+        g_sink += (uint64_t)freqs[r % frames].frequency;
+    }
+    double float_time = vu_time_monotonic_sec() - start;
+
+    start = vu_time_monotonic_sec();
+    for (int r = 0; r < rounds; r++) {
+        for (size_t f = 0; f < frames; f++) {
+            uint64_t sum, power, windowed;
+            int32_t peak;
+            vu_fixed_fft_window(fft, buffer, pcm + f * BENCH_HOP, BENCH_FFT_SIZE, &sum, &peak,
+                                &windowed);
+            vu_fixed_fft_execute(fft, buffer);
+            bins[f] = vu_fixed_peak_power(buffer, 1, BENCH_FFT_SIZE / 2, &power);
+            dbs[f] = 20.0f * log10f(sqrtf((float)power) / VU_FIXED_ONE + 1e-10f);
+        }
+        g_sink += (uint64_t)bins[r % frames];
+    }
+    double fixed_time = vu_time_monotonic_sec() - start;
+
+    /* Agreement, over frames above -100 dBFS */
+    float bin_width = (float)config.sample_rate / BENCH_FFT_SIZE;
+    float max_diff = 0.0f;
+    size_t compared = 0, bin_mismatch = 0;
+    for (size_t f = 0; f < frames; f++) {
+        if (freqs[f].magnitude_db < -100.0f) continue;
+        compared++;
+        if (bins[f] < 0 || (float)bins[f] * bin_width != freqs[f].frequency) bin_mismatch++;
+        float diff = fabsf(dbs[f] - freqs[f].magnitude_db);
+        if (diff > max_diff) max_diff = diff;
+    }
+
+    double total = (double)frames * rounds;
+    printf("%s: %zu x %d-point frames, %d rounds\n\n", path, frames, BENCH_FFT_SIZE, rounds);
+    char label[32];
+    snprintf(label, sizeof(label), "float (%s):", vu_fft_backend_name());
+    printf("%-14s %8.1f ns/frame\n", label, float_time * 1e9 / total);
+    printf("fixed (Q31):   %8.1f ns/frame (%.2fx)\n", fixed_time * 1e9 / total,
+           float_time / fixed_time);
+    printf("\nAgreement over %zu frames: max |dB difference| %.4f, peak bin mismatches %zu\n",
+           compared, max_diff, bin_mismatch);
+
+    free(dbs);
+    free(bins);
+    free(buffer);
+    free(levels);
+    free(freqs);
+    vu_fixed_fft_destroy(fft);
+    vu_analyzer_destroy(analyzer);
+    free(pcm);
+    return 0;
+}
@@ -0,0 +1,129 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Concurrent recording benchmark
+ *
+ * Records many calls at once, as a load run would: 20 ms frames of 8 kHz
+ * audio are written round-robin to every recording from one thread (the
+ * analysis worker's role). Runs once per available recorder backend and
+ * reports throughput in calls of real time, the CPU spent per second of
+ * wall time across all threads, and the deepest per-recorder queue.
+ *
+ * Usage: bench_recorders [dir] [calls] [seconds] [--keep]
+ */
+
+#include "audio/recorder.h"
+#include "util/log.h"
+#include "util/time_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define DEFAULT_DIR "bench_recordings"
+#define DEFAULT_CALLS 50
+#define DEFAULT_SECONDS 10
+#define BENCH_RATE 8000
+#define FRAME_SAMPLES (BENCH_RATE / 50)   /* 20 ms */
+
+static double cpu_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void recording_path(char *out, size_t size, const char *dir, int call)
+{
+    snprintf(out, size, "%s/call_%04d.wav", dir, call);
+}
+
+static int run(vu_recorder_backend_t backend, const char *dir, int calls, int seconds, bool keep)
+{
+    vu_recorder_t **recorders = calloc((size_t)calls, sizeof(vu_recorder_t *));
+    if (!recorders) return 1;
+
+    char path[512];
+    for (int c = 0; c < calls; c++) {
+        recording_path(path, sizeof(path), dir, c);
+        recorders[c] = vu_recorder_create(path, BENCH_RATE, 1);
+        if (!recorders[c]) {
+            fprintf(stderr, "Cannot create %s\n", path);
+            for (int i = 0; i < c; i++) vu_recorder_destroy(recorders[i]);
+            free(recorders);
+            return 1;
+        }
+    }
+
+    int16_t frame[FRAME_SAMPLES];
+    for (int i = 0; i < FRAME_SAMPLES; i++) {
+        frame[i] = (int16_t)(8000.0 * sin(2.0 * M_PI * 1000.0 * i / BENCH_RATE));
+    }
+
+    int frames = seconds * 50;
+    double start = vu_time_monotonic_sec();
+    double cpu_start = cpu_sec();
+    for (int f = 0; f < frames; f++) {
+        for (int c = 0; c < calls; c++) {
+            vu_recorder_write(recorders[c], frame, FRAME_SAMPLES);
+        }
+    }
+    double write_sec = vu_time_monotonic_sec() - start;
+
+    int max_depth = 0;
+    unsigned stalls = 0;
+    for (int c = 0; c < calls; c++) {
+        vu_recorder_stats_t stats;
+        vu_recorder_get_stats(recorders[c], &stats);
+        if (stats.max_queue_depth > max_depth) max_depth = stats.max_queue_depth;
+        stalls += stats.stalls;
+        vu_recorder_close_async(recorders[c]);
+    }
+    vu_recorder_shutdown();
+    double total_sec = vu_time_monotonic_sec() - start;
+    double cpu = cpu_sec() - cpu_start;
+
+    double audio_sec = (double)calls * seconds;
+    printf("  %-8s writes %.2f s, closed after %.2f s: %.0fx real time, "
+           "%.2f cores, queue depth <= %d, %u stall(s)\n",
+           backend == VU_RECORDER_BACKEND_IO_URING ? "io_uring" : "thread",
+           write_sec, total_sec, audio_sec / total_sec, cpu / total_sec, max_depth, stalls);
+
+    if (!keep) {
+        for (int c = 0; c < calls; c++) {
+            recording_path(path, sizeof(path), dir, c);
+            unlink(path);
+        }
+    }
+    free(recorders);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    const char *dir = argc > 1 ? argv[1] : DEFAULT_DIR;
+    int calls = argc > 2 ? atoi(argv[2]) : DEFAULT_CALLS;
+    int seconds = argc > 3 ? atoi(argv[3]) : DEFAULT_SECONDS;
+    bool keep = argc > 4 && strcmp(argv[4], "--keep") == 0;
+    if (calls <= 0) calls = DEFAULT_CALLS;
+    if (seconds <= 0) seconds = DEFAULT_SECONDS;
+
+    /* One "Saved WAV" line per recording would drown the results */
+    vu_log_set_level(VU_LOG_WARN);
+    mkdir(dir, 0755);
+    printf("Recording %d calls x %d s of %d Hz mono (%.0f MB) to %s/\n", calls, seconds,
+           BENCH_RATE, (double)calls * seconds * BENCH_RATE * 2 / 1048576.0, dir);
+
+    if (run(VU_RECORDER_BACKEND_THREAD, dir, calls, seconds, keep) != 0) return 1;
+
+    if (vu_recorder_set_backend(VU_RECORDER_BACKEND_IO_URING) == VU_OK) {
+        if (run(VU_RECORDER_BACKEND_IO_URING, dir, calls, seconds, keep) != 0) return 1;
+    } else {
+        printf("  io_uring backend unavailable (%s)\n", vu_get_last_error()->message);
+    }
+
+    if (!keep) rmdir(dir);
+    return 0;
+}
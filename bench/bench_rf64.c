@@ -0,0 +1,178 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Long recording benchmark across the 4 GB RIFF limit
+ *
+ * Records a stereo soak capture through the WAV recorder (which turns it
+ * into RF64 on close once past 4 GB), then streams it back through the
+ * analyzer on the right channel. Resident memory is sampled throughout:
+ * both sides should stay flat however long the recording is.
+ *
+ * Usage: bench_rf64 [file.wav] [gigabytes] [--keep]
+ * The file goes to $TMPDIR (or /tmp) and is removed afterwards, pass or
+ * fail, unless --keep is given. The default size is a quick check; give
+ * 4.5 GB or more to cross the RIFF limit.
+ */
+
+#include "audio/analyzer.h"
+#include "audio/recorder.h"
+#include "audio/wav_reader.h"
+#include "util/time_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#define DEFAULT_WAV "rf64_bench.wav"
+#define DEFAULT_GB 0.25
+#define BENCH_RATE 8000
+#define BENCH_CHANNELS 2
+#define BEEP_PERIOD_SEC 10         /* One 1 kHz beep on the right channel per period */
+#define RSS_SAMPLE_FRAMES 100000   /* Analysis frames between RSS samples */
+
+typedef struct {
+    size_t frames;
+    size_t valid;
+    long rss_min_kb;
+    long rss_max_kb;
+} analysis_stats_t;
+
+/* Current resident set size in KiB, from /proc (0 if unavailable) */
+static long resident_kb(void)
+{
+    long pages = 0, resident = 0;
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (!f) return 0;
+    if (fscanf(f, "%ld %ld", &pages, &resident) != 2) resident = 0;
+    fclose(f);
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static void track_rss(long *min_kb, long *max_kb)
+{
+    long rss = resident_kb();
+    if (*min_kb == 0 || rss < *min_kb) *min_kb = rss;
+    if (rss > *max_kb) *max_kb = rss;
+}
+
+/* One second of audio: quiet hum on the left, beep or silence on the right */
+static void make_second(int16_t *block, bool beep)
+{
+    for (int i = 0; i < BENCH_RATE; i++) {
+        double t = (double)i / BENCH_RATE;
+        block[2 * i] = (int16_t)(300.0 * sin(2.0 * M_PI * 60.0 * t));
+        block[2 * i + 1] = (beep && i < BENCH_RATE / 2) ?
+                           (int16_t)(12000.0 * sin(2.0 * M_PI * 1000.0 * t)) : 0;
+    }
+}
+
+static bool on_frame(void *user_data, const vu_analysis_frame_t *frame)
+{
+    analysis_stats_t *stats = user_data;
+
+    stats->frames++;
+    if (frame->freq.valid) stats->valid++;
+    if (stats->frames % RSS_SAMPLE_FRAMES == 1) {
+        track_rss(&stats->rss_min_kb, &stats->rss_max_kb);
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    char default_path[1024];
+    const char *path = argv[1];
+    if (argc < 2) {
+        const char *tmp = getenv("TMPDIR");
+        snprintf(default_path, sizeof(default_path), "%s/%s",
+                 tmp && tmp[0] ? tmp : "/tmp", DEFAULT_WAV);
+        path = default_path;
+    }
+
+    double gigabytes = DEFAULT_GB;
+    if (argc > 2) {
+        char *end;
+        gigabytes = strtod(argv[2], &end);
+        if (*end != '\0' || !(gigabytes > 0.0) || gigabytes > 1024.0) {
+            fprintf(stderr, "Invalid size: %s (gigabytes, up to 1024)\n", argv[2]);
+            return 1;
+        }
+    }
+    bool keep = argc > 3 && strcmp(argv[3], "--keep") == 0;
+
+    uint64_t target_bytes = (uint64_t)(gigabytes * 1024.0 * 1024.0 * 1024.0);
+    uint64_t seconds = target_bytes / (BENCH_RATE * BENCH_CHANNELS * sizeof(int16_t)) + 1;
+
+    static int16_t beep_second[BENCH_RATE * BENCH_CHANNELS];
+    static int16_t quiet_second[BENCH_RATE * BENCH_CHANNELS];
+    make_second(beep_second, true);
+    make_second(quiet_second, false);
+
+    printf("Recording %.2f GB (%.1f h of %d Hz stereo) to %s\n",
+           gigabytes, seconds / 3600.0, BENCH_RATE, path);
+
+    /* From here on the file is removed however the run ends */
+    bool covered = false;
+    vu_recorder_t *recorder = vu_recorder_create(path, BENCH_RATE, BENCH_CHANNELS);
+    if (!recorder) {
+        fprintf(stderr, "Cannot create %s\n", path);
+        goto done;
+    }
+
+    long rec_min = 0, rec_max = 0;
+    double start = vu_time_monotonic_sec();
+    for (uint64_t s = 0; s < seconds; s++) {
+        const int16_t *block = s % BEEP_PERIOD_SEC == 0 ? beep_second : quiet_second;
+        if (vu_recorder_write(recorder, block, BENCH_RATE * BENCH_CHANNELS) != VU_OK) {
+            fprintf(stderr, "Write failed after %llu s\n", (unsigned long long)s);
+            vu_recorder_destroy(recorder);
+            goto done;
+        }
+        if (s % 3600 == 0) track_rss(&rec_min, &rec_max);
+    }
+    vu_recorder_destroy(recorder);
+    double record_sec = vu_time_monotonic_sec() - start;
+
+    vu_wav_reader_t *reader = vu_wav_reader_open(path);
+    if (!reader) {
+        fprintf(stderr, "Cannot read back %s\n", path);
+        goto done;
+    }
+    const vu_wav_info_t *info = vu_wav_reader_get_info(reader);
+    uint64_t data_size = info->data_size;
+    uint64_t sample_count = info->sample_count;
+    vu_wav_reader_close(reader);
+
+    printf("  wrote %.2f GB in %.1f s (%.0f MB/s), RSS %ld-%ld KiB\n",
+           data_size / 1073741824.0, record_sec, data_size / 1048576.0 / record_sec,
+           rec_min, rec_max);
+    printf("  read back: %llu frames, %s\n", (unsigned long long)sample_count,
+           data_size > UINT32_MAX ? "past 4 GB (RF64)" : "under 4 GB (RIFF)");
+
+    vu_analyzer_config_t config = vu_analyzer_default_config();
+    config.channel = 1;
+    config.num_threads = VU_ANALYZER_THREADS_AUTO;
+
+    analysis_stats_t stats = {0};
+    vu_analysis_summary_t summary;
+    start = vu_time_monotonic_sec();
+    vu_error_t err = vu_analyzer_analyze_file_stream(path, &config, on_frame, &stats, &summary);
+    double analyze_sec = vu_time_monotonic_sec() - start;
+
+    /* Every beep must show up in at least one frame */
+    uint64_t beeps = (seconds + BEEP_PERIOD_SEC - 1) / BEEP_PERIOD_SEC;
+    printf("Analysis: %s, %zu frames (%.1f h) in %.1f s (%.0fx realtime)\n",
+           err == VU_OK ? "ok" : "FAILED", stats.frames, summary.duration_sec / 3600.0,
+           analyze_sec, summary.duration_sec / analyze_sec);
+    printf("  %zu tone frames for %llu beeps, RSS %ld-%ld KiB\n",
+           stats.valid, (unsigned long long)beeps, stats.rss_min_kb, stats.rss_max_kb);
+
+    covered = err == VU_OK &&
+              (uint64_t)summary.duration_sec + 1 >= seconds - 1 &&
+              stats.valid >= beeps;
+
+done:
+    if (!keep) unlink(path);
+    printf("%s\n", covered ? "PASS: whole recording analyzed" : "FAIL");
+    return covered ? 0 : 1;
+}
@@ -0,0 +1,452 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Persistent cache of file analysis results implementation
+ *
+ * An entry is <dir>/<content hash>-<config hash>.vac: a fixed header that
+ * repeats the full key, then one fixed-size record per frame. Frame index,
+ * time and sample rate are not stored; they follow from the header exactly
+ * as the analysis computes them. Stale entries are never read again (their
+ * key no longer matches anything) and can be deleted at any time.
+ *
+ * A replayed entry has its modification time refreshed, so after each store
+ * the least recently used entries are pruned until the directory fits its
+ * size cap.
+ */
+
+#include "audio/analysis_cache.h"
+#include "util/log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define CACHE_MAGIC   0x43415556u  /* "VUAC" little-endian */
+#define CACHE_VERSION 2u          /* Bump when an engine change alters results */
+
+#if defined(VU_FIXED_POINT)
+#define CACHE_ENGINE 2u
+#elif defined(VU_FFT_BUILTIN)
+#define CACHE_ENGINE 3u            /* Rounds differently from FFTW */
+#else
+#define CACHE_ENGINE 1u
+#endif
+
+#define HASH_SEED  0xcbf29ce484222325ull
+#define HASH_MUL   0x9e3779b97f4a7c15ull
+
+#define HASH_CHUNK    65536        /* Bytes read per call while hashing */
+#define REPLAY_FRAMES 256          /* Records read per call while replaying */
+
+#define STALE_TMP_SEC 3600         /* Age after which a temporary file is left over
+                                      from a run that died mid-store */
+
+#define FRAME_VALID   0x1u
+#define FRAME_SILENCE 0x2u
+
+/* On-disk header; fixed-width fields, no padding */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t content_hash;
+    uint64_t file_size;
+    uint64_t config_hash;
+    uint64_t frame_count;
+    uint64_t frame_size;
+    uint64_t hop_size;
+    uint32_t source_rate;
+    uint32_t sample_rate;
+} entry_header_t;
+
+/* On-disk frame record */
+typedef struct {
+    float frequency;
+    float magnitude_db;
+    float rms_db;
+    float peak_db;
+    uint32_t flags;
+} entry_frame_t;
+
+struct vu_analysis_cache_writer {
+    FILE *file;
+    entry_header_t header;
+    char path[PATH_MAX];
+    char tmp[PATH_MAX + 48];   /* path plus ".<pid>.<writer>.tmp" */
+};
+
+/* One entry found while pruning */
+typedef struct {
+    char name[NAME_MAX + 1];
+    struct timespec mtime;
+    uint64_t size;
+} cache_file_t;
+
+/* Set by vu_analysis_cache_init before any analysis; read-only after */
+static char *g_cache_dir;
+static uint64_t g_cache_max_bytes;
+
+/* Tells apart the temporary files of writers in one process */
+static atomic_uint g_writer_seq;
+
+void vu_analysis_cache_init(const char *dir, uint64_t max_bytes)
+{
+    free(g_cache_dir);
+    g_cache_dir = (dir && dir[0]) ? strdup(dir) : NULL;
+    g_cache_max_bytes = max_bytes;
+}
+
+void vu_analysis_cache_shutdown(void)
+{
+    free(g_cache_dir);
+    g_cache_dir = NULL;
+    g_cache_max_bytes = 0;
+}
+
+/* Word-at-a-time multiplicative hash: not cryptographic, but fast enough
+ * that hashing a recording costs far less than analyzing it */
+static uint64_t hash_mix(uint64_t h, uint64_t word)
+{
+    h ^= word;
+    h *= HASH_MUL;
+    return h ^ (h >> 29);
+}
+
+static uint64_t hash_bytes(uint64_t h, const void *data, size_t len)
+{
+    const unsigned char *p = data;
+
+    for (; len >= 8; p += 8, len -= 8) {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        h = hash_mix(h, word);
+    }
+    if (len > 0) {
+        uint64_t word = 0;
+        memcpy(&word, p, len);
+        h = hash_mix(h, word ^ ((uint64_t)len << 56));
+    }
+    return h;
+}
+
+static uint64_t hash_u32(uint64_t h, uint32_t value)
+{
+    return hash_mix(h, value);
+}
+
+static uint64_t hash_float(uint64_t h, float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return hash_mix(h, bits);
+}
+
+/*
+ * Hash every setting that can change a frame result. Not sample_rate
+ * (file analysis takes the file's) or num_threads (results are identical
+ * for any thread count).
+ */
+static uint64_t hash_config(const vu_analyzer_config_t *config)
+{
+    uint64_t h = HASH_SEED;
+
+    h = hash_u32(h, CACHE_VERSION);
+    h = hash_u32(h, CACHE_ENGINE);
+    h = hash_u32(h, (uint32_t)config->fft_size);
+    h = hash_float(h, config->min_level_db);
+    h = hash_float(h, config->freq_tolerance_hz);
+    h = hash_u32(h, (uint32_t)config->target_count);
+    for (int t = 0; t < config->target_count && t < VU_ANALYZER_MAX_TARGETS; t++) {
+        h = hash_float(h, config->target_freqs_hz[t]);
+    }
+    h = hash_u32(h, (uint32_t)config->interpolation);
+    h = hash_u32(h, config->energy_gate);
+    h = hash_float(h, config->hop_ms);
+    h = hash_u32(h, config->sliding_dft);
+    h = hash_float(h, config->band_min_hz);
+    h = hash_float(h, config->band_max_hz);
+    h = hash_u32(h, (uint32_t)config->analysis_rate);
+    h = hash_u32(h, (uint32_t)config->channel);
+    return h;
+}
+
+bool vu_analysis_cache_key(const char *path, const vu_analyzer_config_t *config,
+                           vu_analysis_cache_key_t *key)
+{
+    if (!g_cache_dir || !path || !config || !key) return false;
+
+    FILE *file = fopen(path, "rb");
+    if (!file) return false;
+
+    unsigned char *buffer = malloc(HASH_CHUNK);
+    if (!buffer) {
+        fclose(file);
+        return false;
+    }
+
+    /* Chunks are whole words, so the hash does not depend on where the
+     * reads split the file */
+    uint64_t h = HASH_SEED;
+    uint64_t size = 0;
+    size_t n;
+    while ((n = fread(buffer, 1, HASH_CHUNK, file)) > 0) {
+        h = hash_bytes(h, buffer, n);
+        size += n;
+        if (n < HASH_CHUNK) break;
+    }
+    bool ok = !ferror(file);
+
+    free(buffer);
+    fclose(file);
+    if (!ok) return false;
+
+    key->content_hash = h;
+    key->file_size = size;
+    key->config_hash = hash_config(config);
+    return true;
+}
+
+static void entry_path(const vu_analysis_cache_key_t *key, char *path, size_t size)
+{
+    snprintf(path, size, "%s/%016llx-%016llx.vac", g_cache_dir,
+             (unsigned long long)key->content_hash, (unsigned long long)key->config_hash);
+}
+
+bool vu_analysis_cache_replay(const vu_analysis_cache_key_t *key,
+                              vu_analysis_frame_cb_t callback, void *user_data,
+                              vu_analysis_summary_t *summary)
+{
+    if (!g_cache_dir || !key || !callback) return false;
+
+    char path[PATH_MAX];
+    entry_path(key, path, sizeof(path));
+
+    FILE *file = fopen(path, "rb");
+    if (!file) return false;
+
+    /* The whole key must match (the file name is only part of it), and
+     * the size must cover every record: anything else is ignored */
+    entry_header_t header;
+    struct stat st;
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        header.magic != CACHE_MAGIC || header.version != CACHE_VERSION ||
+        header.content_hash != key->content_hash || header.file_size != key->file_size ||
+        header.config_hash != key->config_hash || header.sample_rate == 0 ||
+        fstat(fileno(file), &st) != 0 ||
+        (uint64_t)st.st_size != sizeof(header) + header.frame_count * sizeof(entry_frame_t)) {
+        fclose(file);
+        return false;
+    }
+
+    /* Mark the entry recently used for pruning */
+    futimens(fileno(file), NULL);
+
+    entry_frame_t records[REPLAY_FRAMES];
+    uint64_t delivered = 0;
+    bool stop = false;
+    while (delivered < header.frame_count && !stop) {
+        size_t want = header.frame_count - delivered < REPLAY_FRAMES ?
+                      (size_t)(header.frame_count - delivered) : REPLAY_FRAMES;
+        size_t got = fread(records, sizeof(entry_frame_t), want, file);
+
+        for (size_t i = 0; i < got && !stop; i++) {
+            vu_analysis_frame_t frame;
+            memset(&frame, 0, sizeof(frame));
+            frame.index = (size_t)delivered;
+            frame.time_sec = (double)(frame.index * header.hop_size) / header.sample_rate;
+            frame.sample_rate = header.sample_rate;
+            frame.freq.frequency = records[i].frequency;
+            frame.freq.magnitude_db = records[i].magnitude_db;
+            frame.freq.valid = (records[i].flags & FRAME_VALID) != 0;
+            frame.level.rms_db = records[i].rms_db;
+            frame.level.peak_db = records[i].peak_db;
+            frame.level.is_silence = (records[i].flags & FRAME_SILENCE) != 0;
+
+            delivered++;
+            stop = !callback(user_data, &frame);
+        }
+        if (got < want) break;
+    }
+    fclose(file);
+
+    if (summary) {
+        memset(summary, 0, sizeof(*summary));
+        summary->source_rate = header.source_rate;
+        summary->sample_rate = header.sample_rate;
+        summary->frame_size = (size_t)header.frame_size;
+        summary->hop_size = (size_t)header.hop_size;
+        summary->frame_count = (size_t)delivered;
+        summary->duration_sec = delivered > 0 ?
+            (double)((delivered - 1) * header.hop_size + header.frame_size) /
+            header.sample_rate : 0;
+        summary->cached = true;
+    }
+
+    VU_LOG_DEBUG("Replayed %llu cached frames from %s", (unsigned long long)delivered, path);
+    return true;
+}
+
+vu_analysis_cache_writer_t *vu_analysis_cache_begin(const vu_analysis_cache_key_t *key)
+{
+    if (!g_cache_dir || !key) return NULL;
+
+    vu_analysis_cache_writer_t *writer = calloc(1, sizeof(vu_analysis_cache_writer_t));
+    if (!writer) return NULL;
+
+    /* Create the cache dir (and its parents) on first store */
+    char dir[PATH_MAX];
+    snprintf(dir, sizeof(dir), "%s/", g_cache_dir);
+    for (char *p = strchr(dir + 1, '/'); p; p = strchr(p + 1, '/')) {
+        *p = '\0';
+        mkdir(dir, 0755);
+        *p = '/';
+    }
+
+    entry_path(key, writer->path, sizeof(writer->path));
+    snprintf(writer->tmp, sizeof(writer->tmp), "%s.%ld.%u.tmp", writer->path, (long)getpid(),
+             atomic_fetch_add(&g_writer_seq, 1));
+
+    writer->file = fopen(writer->tmp, "wb");
+    if (!writer->file) {
+        VU_LOG_DEBUG("Analysis cache not writable: %s", writer->tmp);
+        free(writer);
+        return NULL;
+    }
+
+    writer->header.magic = CACHE_MAGIC;
+    writer->header.version = CACHE_VERSION;
+    writer->header.content_hash = key->content_hash;
+    writer->header.file_size = key->file_size;
+    writer->header.config_hash = key->config_hash;
+
+    /* Placeholder; the final header is written over it at the end */
+    fwrite(&writer->header, sizeof(writer->header), 1, writer->file);
+    return writer;
+}
+
+void vu_analysis_cache_add(vu_analysis_cache_writer_t *writer,
+                           const vu_analysis_frame_t *frame)
+{
+    if (!writer || !frame) return;
+
+    entry_frame_t record = {
+        .frequency = frame->freq.frequency,
+        .magnitude_db = frame->freq.magnitude_db,
+        .rms_db = frame->level.rms_db,
+        .peak_db = frame->level.peak_db,
+        .flags = (frame->freq.valid ? FRAME_VALID : 0) |
+                 (frame->level.is_silence ? FRAME_SILENCE : 0)
+    };
+    fwrite(&record, sizeof(record), 1, writer->file);
+    writer->header.frame_count++;
+}
+
+static bool has_suffix(const char *name, const char *suffix)
+{
+    size_t len = strlen(name);
+    size_t suffix_len = strlen(suffix);
+    return len > suffix_len && strcmp(name + len - suffix_len, suffix) == 0;
+}
+
+static int compare_mtime(const void *a, const void *b)
+{
+    const cache_file_t *fa = a;
+    const cache_file_t *fb = b;
+    if (fa->mtime.tv_sec != fb->mtime.tv_sec) {
+        return fa->mtime.tv_sec < fb->mtime.tv_sec ? -1 : 1;
+    }
+    return (fa->mtime.tv_nsec > fb->mtime.tv_nsec) - (fa->mtime.tv_nsec < fb->mtime.tv_nsec);
+}
+
+/*
+ * Delete the least recently used entries until the directory fits
+ * g_cache_max_bytes, and temporary files left behind by runs that died.
+ * Parallel runs may prune at once; a file already gone is simply skipped.
+ */
+static void prune_cache(void)
+{
+    if (g_cache_max_bytes == 0) return;
+
+    DIR *dir = opendir(g_cache_dir);
+    if (!dir) return;
+
+    cache_file_t *files = NULL;
+    size_t count = 0;
+    size_t capacity = 0;
+    uint64_t total = 0;
+    time_t now = time(NULL);
+    char path[PATH_MAX];
+    struct dirent *entry;
+
+    while ((entry = readdir(dir)) != NULL) {
+        bool is_entry = has_suffix(entry->d_name, ".vac");
+        if (!is_entry && !has_suffix(entry->d_name, ".tmp")) continue;
+
+        struct stat st;
+        snprintf(path, sizeof(path), "%s/%s", g_cache_dir, entry->d_name);
+        if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) continue;
+
+        if (!is_entry) {
+            if (now - st.st_mtime > STALE_TMP_SEC) unlink(path);
+            continue;
+        }
+
+        if (count == capacity) {
+            size_t grown = capacity ? capacity * 2 : 64;
+            cache_file_t *resized = realloc(files, grown * sizeof(cache_file_t));
+            if (!resized) break;
+            files = resized;
+            capacity = grown;
+        }
+        snprintf(files[count].name, sizeof(files[count].name), "%s", entry->d_name);
+        files[count].mtime = st.st_mtim;
+        files[count].size = (uint64_t)st.st_size;
+        total += files[count].size;
+        count++;
+    }
+    closedir(dir);
+
+    if (total > g_cache_max_bytes) {
+        qsort(files, count, sizeof(cache_file_t), compare_mtime);
+        size_t removed = 0;
+        for (size_t i = 0; i < count && total > g_cache_max_bytes; i++) {
+            snprintf(path, sizeof(path), "%s/%s", g_cache_dir, files[i].name);
+            if (unlink(path) == 0) removed++;
+            total -= files[i].size;
+        }
+        VU_LOG_DEBUG("Pruned %zu analysis cache entries, %llu bytes remain", removed,
+                     (unsigned long long)total);
+    }
+    free(files);
+}
+
+void vu_analysis_cache_end(vu_analysis_cache_writer_t *writer,
+                           const vu_analysis_summary_t *summary, bool complete)
+{
+    if (!writer) return;
+
+    bool ok = complete && summary && summary->frame_count == writer->header.frame_count;
+    if (ok) {
+        writer->header.frame_size = summary->frame_size;
+        writer->header.hop_size = summary->hop_size;
+        writer->header.source_rate = summary->source_rate;
+        writer->header.sample_rate = summary->sample_rate;
+
+        ok = fseek(writer->file, 0, SEEK_SET) == 0 &&
+             fwrite(&writer->header, sizeof(writer->header), 1, writer->file) == 1 &&
+             fflush(writer->file) == 0 && !ferror(writer->file);
+    }
+    ok = fclose(writer->file) == 0 && ok;
+
+    if (ok && rename(writer->tmp, writer->path) == 0) {
+        VU_LOG_DEBUG("Cached %llu analysis frames in %s",
+                     (unsigned long long)writer->header.frame_count, writer->path);
+        prune_cache();
+    } else {
+        unlink(writer->tmp);
+    }
+    free(writer);
+}
@@ -0,0 +1,83 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Persistent cache of file analysis results
+ *
+ * Per-frame results of vu_analyzer_analyze_file_stream are stored in a
+ * cache directory, one entry per (file content, analyzer config). An
+ * unchanged recording analyzed with the same settings is replayed from
+ * its entry instead of being decoded and transformed again; editing the
+ * file or changing any setting that affects the results keys a different
+ * entry. Entries are written to a temporary file and renamed into place,
+ * so parallel runs sharing a directory never see a half-written one. The
+ * directory is kept under a size cap by dropping least recently used
+ * entries.
+ */
+
+#ifndef VU_ANALYSIS_CACHE_H
+#define VU_ANALYSIS_CACHE_H
+
+#include "audio/analyzer.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Identity of one cache entry */
+typedef struct vu_analysis_cache_key {
+    uint64_t content_hash;    /* Hash of the file's bytes */
+    uint64_t file_size;
+    uint64_t config_hash;     /* Hash of the settings that shape the results */
+} vu_analysis_cache_key_t;
+
+/* Opaque entry being written */
+typedef struct vu_analysis_cache_writer vu_analysis_cache_writer_t;
+
+/*
+ * Configure the cache. Call before the first analysis.
+ * dir: cache directory, created on first store; NULL disables the cache.
+ * max_bytes: size the directory is pruned to after each store; 0 = no cap.
+ */
+void vu_analysis_cache_init(const char *dir, uint64_t max_bytes);
+
+/*
+ * Disable the cache and free its state
+ */
+void vu_analysis_cache_shutdown(void);
+
+/*
+ * Compute the cache key of analyzing `path` with `config`. Reads the
+ * whole file. Returns false if the cache is disabled or the file cannot
+ * be read.
+ */
+bool vu_analysis_cache_key(const char *path, const vu_analyzer_config_t *config,
+                           vu_analysis_cache_key_t *key);
+
+/*
+ * Replay a stored entry: deliver its frames to `callback` in order (until
+ * it returns false) and fill in `summary` (frame counts as stored, no
+ * FFTs run, `cached` set).
+ * Returns false, having called nothing, if there is no valid entry.
+ */
+bool vu_analysis_cache_replay(const vu_analysis_cache_key_t *key,
+                              vu_analysis_frame_cb_t callback, void *user_data,
+                              vu_analysis_summary_t *summary);
+
+/*
+ * Start storing an entry. Returns NULL if it cannot be created (the
+ * analysis then simply runs uncached).
+ */
+vu_analysis_cache_writer_t *vu_analysis_cache_begin(const vu_analysis_cache_key_t *key);
+
+/*
+ * Append the next frame of the entry
+ */
+void vu_analysis_cache_add(vu_analysis_cache_writer_t *writer,
+                           const vu_analysis_frame_t *frame);
+
+/*
+ * Finish the entry with the run's summary and move it into place.
+ * complete: false if the analysis failed or stopped early; the partial
+ * entry is discarded.
+ */
+void vu_analysis_cache_end(vu_analysis_cache_writer_t *writer,
+                           const vu_analysis_summary_t *summary, bool complete);
+
+#endif /* VU_ANALYSIS_CACHE_H */
@@ -0,0 +1,214 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Live analysis worker pool implementation
+ */
+
+#include "audio/analysis_pool.h"
+#include "util/log.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+struct vu_analysis_source {
+    vu_analysis_drain_fn drain;
+    void *user_data;
+    struct pool_worker *worker;
+    struct vu_analysis_source *next;
+};
+
+/* A worker holds its mutex while draining, so detaching a source waits
+ * for the drain to finish */
+typedef struct pool_worker {
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t wake;       /* Signalled on stop */
+    vu_analysis_source_t *sources;
+    int source_count;
+    bool stop;
+    bool initialized;
+} pool_worker_t;
+
+static struct {
+    pthread_mutex_t mutex;     /* Guards starting, stopping and source counts */
+    pool_worker_t workers[VU_ANALYSIS_POOL_MAX_WORKERS];
+    int count;                 /* Workers running */
+    int requested;             /* Workers to start (0 = one per CPU) */
+    size_t queue_frames;
+} g_pool = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .queue_frames = VU_ANALYSIS_POOL_DEFAULT_QUEUE
+};
+
+static void *worker_run(void *arg)
+{
+    pool_worker_t *w = arg;
+
+    pthread_mutex_lock(&w->mutex);
+    while (!w->stop) {
+        for (vu_analysis_source_t *s = w->sources; s; s = s->next) {
+            s->drain(s->user_data);
+        }
+
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_nsec += VU_ANALYSIS_POOL_TICK_MS * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&w->wake, &w->mutex, &deadline);
+    }
+    pthread_mutex_unlock(&w->mutex);
+    return NULL;
+}
+
+/* Worker state lives as long as the process: sources may be detached
+ * after a shutdown */
+static bool worker_init(pool_worker_t *w)
+{
+    if (w->initialized) return true;
+
+    pthread_condattr_t attr;
+    if (pthread_condattr_init(&attr) != 0) return false;
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    bool ok = pthread_cond_init(&w->wake, &attr) == 0;
+    pthread_condattr_destroy(&attr);
+    if (!ok) return false;
+
+    if (pthread_mutex_init(&w->mutex, NULL) != 0) {
+        pthread_cond_destroy(&w->wake);
+        return false;
+    }
+    w->initialized = true;
+    return true;
+}
+
+static void stop_workers(int count)
+{
+    for (int i = 0; i < count; i++) {
+        pool_worker_t *w = &g_pool.workers[i];
+        pthread_mutex_lock(&w->mutex);
+        w->stop = true;
+        pthread_cond_signal(&w->wake);
+        pthread_mutex_unlock(&w->mutex);
+    }
+    for (int i = 0; i < count; i++) {
+        pthread_join(g_pool.workers[i].thread, NULL);
+    }
+}
+
+/* Start the configured workers (g_pool.mutex held) */
+static vu_error_t start_locked(void)
+{
+    if (g_pool.count > 0) return VU_OK;
+
+    int workers = g_pool.requested;
+    if (workers <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = cpus > 0 ? (int)cpus : 1;
+    }
+    if (workers > VU_ANALYSIS_POOL_MAX_WORKERS) workers = VU_ANALYSIS_POOL_MAX_WORKERS;
+
+    for (int i = 0; i < workers; i++) {
+        pool_worker_t *w = &g_pool.workers[i];
+        w->stop = false;
+        if (!worker_init(w) || pthread_create(&w->thread, NULL, worker_run, w) != 0) {
+            stop_workers(i);
+            VU_SET_ERROR(VU_ERR_NO_MEMORY, "Failed to start analysis worker %d", i);
+            return VU_ERR_NO_MEMORY;
+        }
+    }
+
+    g_pool.count = workers;
+    VU_LOG_DEBUG("Analysis pool started: %d worker(s)", workers);
+    return VU_OK;
+}
+
+void vu_analysis_pool_init(int workers, size_t queue_frames)
+{
+    pthread_mutex_lock(&g_pool.mutex);
+    g_pool.requested = workers > 0 ? workers : 0;
+    g_pool.queue_frames = queue_frames > 0 ? queue_frames : VU_ANALYSIS_POOL_DEFAULT_QUEUE;
+    pthread_mutex_unlock(&g_pool.mutex);
+}
+
+size_t vu_analysis_pool_queue_frames(void)
+{
+    pthread_mutex_lock(&g_pool.mutex);
+    size_t frames = g_pool.queue_frames;
+    pthread_mutex_unlock(&g_pool.mutex);
+    return frames;
+}
+
+void vu_analysis_pool_shutdown(void)
+{
+    pthread_mutex_lock(&g_pool.mutex);
+    if (g_pool.count > 0) {
+        stop_workers(g_pool.count);
+        for (int i = 0; i < g_pool.count; i++) {
+            if (g_pool.workers[i].source_count > 0) {
+                VU_LOG_WARN("Analysis pool stopped with %d source(s) attached",
+                            g_pool.workers[i].source_count);
+            }
+        }
+        g_pool.count = 0;
+        VU_LOG_DEBUG("Analysis pool stopped");
+    }
+    pthread_mutex_unlock(&g_pool.mutex);
+}
+
+vu_analysis_source_t *vu_analysis_pool_attach(vu_analysis_drain_fn drain, void *user_data)
+{
+    if (!drain) return NULL;
+
+    vu_analysis_source_t *source = calloc(1, sizeof(vu_analysis_source_t));
+    if (!source) return NULL;
+    source->drain = drain;
+    source->user_data = user_data;
+
+    pthread_mutex_lock(&g_pool.mutex);
+    if (start_locked() != VU_OK) {
+        pthread_mutex_unlock(&g_pool.mutex);
+        free(source);
+        return NULL;
+    }
+
+    /* Least loaded worker */
+    pool_worker_t *w = &g_pool.workers[0];
+    for (int i = 1; i < g_pool.count; i++) {
+        if (g_pool.workers[i].source_count < w->source_count) w = &g_pool.workers[i];
+    }
+
+    pthread_mutex_lock(&w->mutex);
+    source->worker = w;
+    source->next = w->sources;
+    w->sources = source;
+    w->source_count++;
+    pthread_mutex_unlock(&w->mutex);
+    pthread_mutex_unlock(&g_pool.mutex);
+    return source;
+}
+
+void vu_analysis_pool_detach(vu_analysis_source_t *source)
+{
+    if (!source) return;
+
+    pool_worker_t *w = source->worker;
+    pthread_mutex_lock(&g_pool.mutex);
+    pthread_mutex_lock(&w->mutex);
+    for (vu_analysis_source_t **p = &w->sources; *p; p = &(*p)->next) {
+        if (*p == source) {
+            *p = source->next;
+            w->source_count--;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&w->mutex);
+    pthread_mutex_unlock(&g_pool.mutex);
+
+    /* The worker no longer consumes, so this thread may */
+    source->drain(source->user_data);
+    free(source);
+}
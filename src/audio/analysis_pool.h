@@ -0,0 +1,65 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Process-wide pool of live analysis workers
+ *
+ * Live audio sources (one per analyzed call) queue frames from the media
+ * clock thread and register a drain function here. Each source is served
+ * by exactly one worker, which calls its drain function every tick, so a
+ * source's queue always has a single consumer and per-source state needs
+ * no locking against other workers. Sources are spread over the workers
+ * by count.
+ */
+
+#ifndef VU_ANALYSIS_POOL_H
+#define VU_ANALYSIS_POOL_H
+
+#include "util/error.h"
+#include <stddef.h>
+
+/* Most workers the pool runs */
+#define VU_ANALYSIS_POOL_MAX_WORKERS 16
+
+/* How often a worker drains its sources */
+#define VU_ANALYSIS_POOL_TICK_MS 10
+
+/* Default frames a source may queue: 1 s of 20 ms frames */
+#define VU_ANALYSIS_POOL_DEFAULT_QUEUE 50
+
+/* Consume whatever the source has queued (called on a worker thread) */
+typedef void (*vu_analysis_drain_fn)(void *user_data);
+
+/* Opaque registration of one source */
+typedef struct vu_analysis_source vu_analysis_source_t;
+
+/*
+ * Configure the pool. Call before the first attach; the workers only
+ * start with the first source.
+ * workers: threads to run (0 = one per CPU)
+ * queue_frames: frames each source may queue (0 = default)
+ */
+void vu_analysis_pool_init(int workers, size_t queue_frames);
+
+/*
+ * Get the configured per-source queue depth in frames
+ */
+size_t vu_analysis_pool_queue_frames(void);
+
+/*
+ * Stop the workers. Detach all sources first; any still attached are
+ * only drained by their final detach.
+ */
+void vu_analysis_pool_shutdown(void);
+
+/*
+ * Register a source, starting the workers if needed
+ * Returns NULL on failure.
+ */
+vu_analysis_source_t *vu_analysis_pool_attach(vu_analysis_drain_fn drain, void *user_data);
+
+/*
+ * Unregister a source. Waits for a drain in progress, then drains the
+ * source once more on the calling thread so nothing queued is lost.
+ */
+void vu_analysis_pool_detach(vu_analysis_source_t *source);
+
+#endif /* VU_ANALYSIS_POOL_H */
@@ -1,41 +1,60 @@
 /*
  * voip-utility - SIP VoIP Testing Utility
- * FFT-based audio analyzer implementation
+ * FFT-based audio analyzer implementation (floating point, FFTW)
  */
 
 #include "audio/analyzer.h"
+#include "audio/analyzer_simd.h"
+#include "audio/fft_plan.h"
+#include "audio/goertzel_tone.h"
+#include "audio/peak_interp.h"
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
-#include <fftw3.h>
 
-#define SILENCE_THRESHOLD_DB -60.0f
+/* Headroom on the energy gate's bound for float rounding in the FFT and
+ * the level sums */
+#define GATE_SAFETY_DB 0.5f
 
 struct vu_analyzer {
     vu_analyzer_config_t config;
-    float *window;             /* Hann window coefficients */
+    const float *window;       /* Shared Hann window coefficients */
     float *input_buffer;       /* FFT input buffer */
-    fftwf_complex *output;     /* FFT output */
-    fftwf_plan plan;           /* FFTW plan */
+    float *output;             /* FFT output (interleaved re/im) */
+    const vu_fft_plan_t *plan; /* Shared FFT plan (NULL in Goertzel mode) */
+
+    /* Multi-frame batches (allocated on first batch call) */
+    const vu_fft_plan_t *batch_plan;
+    float *batch_input;        /* VU_ANALYZER_BATCH_FRAMES windowed frames */
+    float *batch_output;       /* Their spectra, vu_fft_spectrum_stride apart */
+    const vu_analyzer_kernels_t *kernels;  /* Inner loops for this CPU */
+
+    /* Energy gate: no bin's magnitude_db exceeds rms_db + gate_margin_db */
+    float gate_margin_db;
+    vu_analyzer_stats_t stats;
+
+    /* Goertzel filter bank (target_count > 0) */
+    vu_goertzel_target_t goertzel[VU_ANALYZER_MAX_TARGETS];
+    float goertzel_coeff[VU_ANALYZER_MAX_TARGETS];  /* 2*cos(w) */
+    float tone_norm;           /* A pure tone's power at its bin and the two beside,
+                                * over its windowed energy, times this is 1 */
 };
 
-/* Create Hann window */
-static void create_hann_window(float *window, int size)
+/*
+ * A tone x = A cos(wn) windowed by w[n] has energy A^2/2 sum(w^2) and
+ * |X|^2 = A^2/4 |W(d)|^2 at d bins from it, W the window's transform, so
+ * its bin and the two beside hold A^2/4 (|W(0)|^2 + 2 |W(1)|^2)
+ */
+static float tone_norm(const float *window, int size, double window_energy)
 {
+    double w0 = 0.0, w1_re = 0.0, w1_im = 0.0;
     for (int i = 0; i < size; i++) {
-        window[i] = 0.5f * (1.0f - cosf(2.0f * M_PI * i / (size - 1)));
+        w0 += window[i];
+        w1_re += window[i] * cos(2.0 * M_PI * i / size);
+        w1_im -= window[i] * sin(2.0 * M_PI * i / size);
     }
-}
-
-vu_analyzer_config_t vu_analyzer_default_config(void)
-{
-    vu_analyzer_config_t config = {
-        .sample_rate = 8000,
-        .fft_size = 512,
-        .min_level_db = -40.0f,
-        .freq_tolerance_hz = 50.0f
-    };
-    return config;
+    double lobe = w0 * w0 + 2.0 * (w1_re * w1_re + w1_im * w1_im);
+    return lobe > 0.0 ? (float)(2.0 * window_energy / lobe) : 0.0f;
 }
 
 vu_analyzer_t *vu_analyzer_create(const vu_analyzer_config_t *config)
@@ -46,35 +65,61 @@ vu_analyzer_t *vu_analyzer_create(const vu_analyzer_config_t *config)
     if ((config->fft_size & (config->fft_size - 1)) != 0) {
         return NULL;
     }
+    if (config->target_count < 0 || config->target_count > VU_ANALYZER_MAX_TARGETS) {
+        return NULL;
+    }
 
     vu_analyzer_t *analyzer = calloc(1, sizeof(vu_analyzer_t));
     if (!analyzer) return NULL;
 
     analyzer->config = *config;
+    analyzer->kernels = vu_analyzer_kernels();
 
-    /* Allocate buffers */
-    analyzer->window = fftwf_alloc_real(config->fft_size);
-    analyzer->input_buffer = fftwf_alloc_real(config->fft_size);
-    analyzer->output = fftwf_alloc_complex(config->fft_size / 2 + 1);
+    /* Allocate buffers; the window is shared by all analyzers of this size */
+    analyzer->window = vu_fft_window_get(config->fft_size);
+    analyzer->input_buffer = vu_fft_alloc(config->fft_size);
+    if (!analyzer->window || !analyzer->input_buffer) {
+        vu_analyzer_destroy(analyzer);
+        return NULL;
+    }
 
-    if (!analyzer->window || !analyzer->input_buffer || !analyzer->output) {
+    /*
+     * Cauchy-Schwarz: |X[k]| <= sqrt(sum x^2) * sqrt(sum w^2) for any bin or
+     * Goertzel target, so with magnitude = |X| / (N/2) and rms^2 = sum x^2 / n
+     * (n <= N samples), magnitude <= rms * sqrt(N * sum w^2) / (N/2).
+     * For a Hann window this is rms_db + 1.76 dB.
+     */
+    double window_energy = 0.0;
+    for (int i = 0; i < config->fft_size; i++) {
+        window_energy += (double)analyzer->window[i] * analyzer->window[i];
+    }
+    double half = config->fft_size / 2.0;
+    analyzer->gate_margin_db = (float)(10.0 * log10(config->fft_size * window_energy / (half * half))) +
+                               GATE_SAFETY_DB;
+
+    if (config->target_count > 0) {
+        /* Goertzel mode: no FFT needed */
+        analyzer->tone_norm = tone_norm(analyzer->window, config->fft_size, window_energy);
+        for (int t = 0; t < config->target_count; t++) {
+            vu_goertzel_target_init(&analyzer->goertzel[t], config, t);
+            analyzer->goertzel_coeff[t] = 2.0f * analyzer->goertzel[t].cos_w[VU_GOERTZEL_FILTER(0)];
+        }
+        return analyzer;
+    }
+
+    analyzer->output = vu_fft_alloc(2 * (config->fft_size / 2 + 1));
+    if (!analyzer->output) {
         vu_analyzer_destroy(analyzer);
         return NULL;
     }
 
-    /* Create FFTW plan */
-    analyzer->plan = fftwf_plan_dft_r2c_1d(config->fft_size,
-                                            analyzer->input_buffer,
-                                            analyzer->output,
-                                            FFTW_ESTIMATE);
+    /* Shared plan from the process-wide cache (planned once per size) */
+    analyzer->plan = vu_fft_plan_get(config->fft_size);
     if (!analyzer->plan) {
         vu_analyzer_destroy(analyzer);
         return NULL;
     }
 
-    /* Initialize Hann window */
-    create_hann_window(analyzer->window, config->fft_size);
-
     return analyzer;
 }
 
@@ -82,53 +127,258 @@ void vu_analyzer_destroy(vu_analyzer_t *analyzer)
 {
     if (!analyzer) return;
 
-    if (analyzer->plan) {
-        fftwf_destroy_plan(analyzer->plan);
-    }
-    if (analyzer->window) fftwf_free(analyzer->window);
-    if (analyzer->input_buffer) fftwf_free(analyzer->input_buffer);
-    if (analyzer->output) fftwf_free(analyzer->output);
+    vu_fft_free(analyzer->input_buffer);
+    vu_fft_free(analyzer->output);
+    vu_fft_free(analyzer->batch_input);
+    vu_fft_free(analyzer->batch_output);
 
     free(analyzer);
 }
 
-bool vu_analyzer_detect_frequency(vu_analyzer_t *analyzer,
-                                   const int16_t *samples, size_t count,
-                                   vu_freq_result_t *result)
+/*
+ * Goertzel filter bank: evaluate the windowed frame's spectrum only at the
+ * configured target frequencies. Costs one multiply-add per sample per
+ * target instead of a full FFT and bin scan. Magnitudes are scaled like the
+ * FFT path so min_level_db means the same in both modes.
+ * input: the zero-padded windowed frame (fft_size samples)
+ * magnitudes: |X| / (N/2) of each target
+ * bins: each target's aligned X (re/im pairs)
+ */
+static void goertzel_magnitudes(const vu_analyzer_t *analyzer, const float *input,
+                                float *magnitudes, float *bins)
 {
-    if (!analyzer || !samples || !result) return false;
+    int targets = analyzer->config.target_count;
+    float s1[VU_ANALYZER_MAX_TARGETS] = {0};
+    float s2[VU_ANALYZER_MAX_TARGETS] = {0};
+
+    for (int i = 0; i < analyzer->config.fft_size; i++) {
+        float x = input[i];
+        for (int t = 0; t < targets; t++) {
+            float s0 = x + analyzer->goertzel_coeff[t] * s1[t] - s2[t];
+            s2[t] = s1[t];
+            s1[t] = s0;
+        }
+    }
 
-    memset(result, 0, sizeof(*result));
+    for (int t = 0; t < targets; t++) {
+        vu_goertzel_bin(&analyzer->goertzel[t], VU_GOERTZEL_FILTER(0), s1[t], s2[t],
+                        bins + 2 * t);
+        magnitudes[t] = sqrtf(vu_goertzel_power(bins + 2 * t)) / (analyzer->config.fft_size / 2);
+    }
+}
 
-    int fft_size = analyzer->config.fft_size;
-    size_t samples_to_use = (count < (size_t)fft_size) ? count : (size_t)fft_size;
+/* Aligned X of one more filter of target t, `offset` bins from it */
+static void goertzel_at(const vu_analyzer_t *analyzer, const float *input, int t, int offset,
+                        float *bin)
+{
+    const vu_goertzel_target_t *target = &analyzer->goertzel[t];
+    int filter = VU_GOERTZEL_FILTER(offset);
+    float coeff = 2.0f * target->cos_w[filter];
+    float s1 = 0.0f, s2 = 0.0f;
+    for (int i = 0; i < analyzer->config.fft_size; i++) {
+        float s0 = input[i] + coeff * s1 - s2;
+        s2 = s1;
+        s1 = s0;
+    }
+    vu_goertzel_bin(target, filter, s1, s2, bin);
+}
 
-    /* Apply window and convert to float */
-    for (size_t i = 0; i < samples_to_use; i++) {
-        analyzer->input_buffer[i] = (samples[i] / 32768.0f) * analyzer->window[i];
+/* X at target t and one FFT bin either side, as vu_peak_interpolate takes
+ * them; `at` is the target filter's own bin */
+static void goertzel_neighbours(const vu_analyzer_t *analyzer, const float *input, int t,
+                                const float *at, float *bins)
+{
+    const vu_goertzel_target_t *target = &analyzer->goertzel[t];
+    float coeff_lo = 2.0f * target->cos_w[VU_GOERTZEL_FILTER(-1)];
+    float coeff_hi = 2.0f * target->cos_w[VU_GOERTZEL_FILTER(1)];
+    float lo1 = 0.0f, lo2 = 0.0f, hi1 = 0.0f, hi2 = 0.0f;
+
+    for (int i = 0; i < analyzer->config.fft_size; i++) {
+        float lo0 = input[i] + coeff_lo * lo1 - lo2;
+        float hi0 = input[i] + coeff_hi * hi1 - hi2;
+        lo2 = lo1;
+        lo1 = lo0;
+        hi2 = hi1;
+        hi1 = hi0;
     }
-    /* Zero-pad if necessary */
-    for (size_t i = samples_to_use; i < (size_t)fft_size; i++) {
-        analyzer->input_buffer[i] = 0.0f;
+
+    vu_goertzel_bin(target, VU_GOERTZEL_FILTER(-1), lo1, lo2, bins);
+    bins[2] = at[0];
+    bins[3] = at[1];
+    vu_goertzel_bin(target, VU_GOERTZEL_FILTER(1), hi1, hi2, bins + 4);
+}
+
+/*
+ * Target t's frequency, measured from its neighbours `bins`. A tone
+ * nearer a neighbour than the target is located around that neighbour,
+ * with one more filter beyond it.
+ */
+static float goertzel_frequency(const vu_analyzer_t *analyzer, const float *input, int t,
+                                const float *bins)
+{
+    int centre = vu_goertzel_centre(bins);
+    float beyond[2];
+    if (centre != 0) goertzel_at(analyzer, input, t, 2 * centre, beyond);
+    return vu_goertzel_frequency(&analyzer->config, t, bins, centre, beyond);
+}
+
+/* Energy of the `count` windowed samples, for vu_goertzel_is_tone */
+static double frame_energy(const float *input, size_t count)
+{
+    double energy = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        energy += (double)input[i] * input[i];
     }
+    return energy;
+}
 
-    /* Execute FFT */
-    fftwf_execute(analyzer->plan);
+static void detect_goertzel(const vu_analyzer_t *analyzer,
+                            const float *input, size_t count,
+                            vu_freq_result_t *result)
+{
+    float magnitudes[VU_ANALYZER_MAX_TARGETS];
+    float outputs[2 * VU_ANALYZER_MAX_TARGETS];
+    goertzel_magnitudes(analyzer, input, magnitudes, outputs);
 
-    /* Find peak magnitude and frequency */
     float max_magnitude = 0.0f;
-    int max_bin = 0;
-    int num_bins = fft_size / 2;
+    int max_target = 0;
+
+    for (int t = 0; t < analyzer->config.target_count; t++) {
+        if (magnitudes[t] > max_magnitude) {
+            max_magnitude = magnitudes[t];
+            max_target = t;
+        }
+    }
+
+    float magnitude_db = 20.0f * log10f(max_magnitude + 1e-10f);
 
-    for (int i = 1; i < num_bins; i++) {
-        float real = analyzer->output[i][0];
-        float imag = analyzer->output[i][1];
-        float magnitude = sqrtf(real * real + imag * imag);
+    /* The configured target is not a measurement: frequency stays 0 unless
+     * a tone is found there */
+    result->frequency = 0.0f;
+    result->magnitude_db = magnitude_db;
+    result->valid = false;
+    if (magnitude_db <= analyzer->config.min_level_db) return;
+
+    float bins[6];
+    goertzel_neighbours(analyzer, input, max_target, outputs + 2 * max_target, bins);
+    if (vu_goertzel_is_tone(bins, analyzer->tone_norm, frame_energy(input, count))) {
+        result->frequency = goertzel_frequency(analyzer, input, max_target, bins);
+        result->valid = true;
+    }
+}
+
+/* Goertzel mode peaks: the targets above min_level_db that are local
+ * maxima of the spectrum, strongest first, at their measured frequency */
+static int goertzel_peaks(const vu_analyzer_t *analyzer, const float *input,
+                          vu_peak_t *peaks, int max_peaks)
+{
+    float magnitudes[VU_ANALYZER_MAX_TARGETS];
+    float outputs[2 * VU_ANALYZER_MAX_TARGETS];
+    goertzel_magnitudes(analyzer, input, magnitudes, outputs);
+
+    int found = 0;
+    for (int t = 0; t < analyzer->config.target_count; t++) {
+        float magnitude_db = 20.0f * log10f(magnitudes[t] + 1e-10f);
+        if (magnitude_db <= analyzer->config.min_level_db) continue;
+
+        float bins[6];
+        goertzel_neighbours(analyzer, input, t, outputs + 2 * t, bins);
+        float at = vu_goertzel_power(bins + 2);
+        if (at < vu_goertzel_power(bins) || at < vu_goertzel_power(bins + 4)) {
+            continue;
+        }
+        float frequency = goertzel_frequency(analyzer, input, t, bins);
 
-        if (magnitude > max_magnitude) {
-            max_magnitude = magnitude;
-            max_bin = i;
+        int i = found < max_peaks ? found++ : max_peaks;
+        for (; i > 0 && peaks[i - 1].magnitude_db < magnitude_db; i--) {
+            if (i < max_peaks) peaks[i] = peaks[i - 1];
         }
+        if (i < max_peaks) {
+            peaks[i].frequency = frequency;
+            peaks[i].magnitude_db = magnitude_db;
+        }
+    }
+    return found;
+}
+
+/*
+ * Top-N local maxima of one r2c spectrum in a single pass: each bin's
+ * power is computed once, compared with its neighbours and, if it beats
+ * the weakest peak kept so far, insertion-sorted into the short list.
+ * Only the winners are interpolated.
+ */
+static int spectrum_peaks(const vu_analyzer_t *analyzer, const float *spectrum,
+                          vu_peak_t *peaks, int max_peaks)
+{
+    int fft_size = analyzer->config.fft_size;
+    int last = fft_size / 2;
+    float half = fft_size / 2.0f;
+    if (max_peaks <= 0 || last < 2) return 0;
+
+    /* min_level_db as a power: magnitude = sqrt(power) / (N/2) */
+    float threshold = powf(10.0f, analyzer->config.min_level_db / 10.0f) * half * half;
+
+    int bins[VU_ANALYZER_MAX_PEAKS];
+    float powers[VU_ANALYZER_MAX_PEAKS];
+    int found = 0;
+
+    float prev = spectrum[0] * spectrum[0] + spectrum[1] * spectrum[1];
+    float cur = spectrum[2] * spectrum[2] + spectrum[3] * spectrum[3];
+    for (int k = 1; k < last; k++) {
+        float next = spectrum[2 * k + 2] * spectrum[2 * k + 2] +
+                     spectrum[2 * k + 3] * spectrum[2 * k + 3];
+
+        if (cur > threshold && cur > prev && cur >= next &&
+            (found < max_peaks || cur > powers[found - 1])) {
+            int i = found < max_peaks ? found++ : found - 1;
+            for (; i > 0 && powers[i - 1] < cur; i--) {
+                powers[i] = powers[i - 1];
+                bins[i] = bins[i - 1];
+            }
+            powers[i] = cur;
+            bins[i] = k;
+        }
+
+        prev = cur;
+        cur = next;
+    }
+
+    float bin_width = (float)analyzer->config.sample_rate / fft_size;
+    float scale_db = 20.0f * log10f(half);
+    for (int i = 0; i < found; i++) {
+        float offset, peak_db;
+        vu_peak_interpolate(VU_PEAK_INTERP_PARABOLIC, spectrum + 2 * (bins[i] - 1),
+                            &offset, &peak_db);
+        peaks[i].frequency = (bins[i] + offset) * bin_width;
+        peaks[i].magnitude_db = peak_db - scale_db;
+    }
+
+    /* Interpolation can reorder close peaks */
+    for (int i = 1; i < found; i++) {
+        vu_peak_t p = peaks[i];
+        int j = i;
+        for (; j > 0 && peaks[j - 1].magnitude_db < p.magnitude_db; j--) peaks[j] = peaks[j - 1];
+        peaks[j] = p;
+    }
+    return found;
+}
+
+/* Dominant frequency from one r2c spectrum (fft_size/2 + 1 re/im pairs) */
+static void spectrum_peak(const vu_analyzer_t *analyzer, const float *spectrum,
+                          vu_freq_result_t *result)
+{
+    int fft_size = analyzer->config.fft_size;
+
+    /* Find peak bin by squared magnitude (skip DC); sqrt only the winner */
+    float max_power;
+    int max_bin = analyzer->kernels->peak_power(spectrum, 1, fft_size / 2, &max_power);
+    float max_magnitude = 0.0f;
+    if (max_bin < 0) {
+        max_bin = 0;
+    } else {
+        float real = spectrum[2 * max_bin];
+        float imag = spectrum[2 * max_bin + 1];
+        max_magnitude = sqrtf(real * real + imag * imag);
     }
 
     /* Convert to dB */
@@ -138,183 +388,317 @@ bool vu_analyzer_detect_frequency(vu_analyzer_t *analyzer,
     float bin_width = (float)analyzer->config.sample_rate / fft_size;
     float frequency = max_bin * bin_width;
 
+    /* Between bins: bins max_bin - 1 .. max_bin + 1 always exist, DC and
+     * Nyquist included */
+    if (analyzer->config.interpolation != VU_PEAK_INTERP_NONE && max_magnitude > 0.0f) {
+        float offset, peak_db;
+        vu_peak_interpolate(analyzer->config.interpolation, spectrum + 2 * (max_bin - 1),
+                            &offset, &peak_db);
+        frequency = (max_bin + offset) * bin_width;
+        magnitude_db = peak_db - 20.0f * log10f(fft_size / 2.0f);
+    }
+
     result->frequency = frequency;
     result->magnitude_db = magnitude_db;
     result->valid = (magnitude_db > analyzer->config.min_level_db);
-
-    return true;
 }
 
-bool vu_analyzer_calculate_level(vu_analyzer_t *analyzer,
-                                  const int16_t *samples, size_t count,
-                                  vu_level_result_t *result)
+/* Window `count` samples into `out`; with `level`, measure them in the
+ * same pass */
+static void window_frame(const vu_analyzer_t *analyzer, float *out,
+                         const int16_t *samples, size_t count,
+                         vu_level_result_t *level)
 {
-    if (!analyzer || !samples || !result || count == 0) return false;
-
-    float sum_squares = 0.0f;
-    int16_t peak = 0;
+    if (!level) {
+        analyzer->kernels->window(out, samples, analyzer->window, count);
+        return;
+    }
 
-    for (size_t i = 0; i < count; i++) {
-        int16_t sample = samples[i];
-        float normalized = sample / 32768.0f;
-        sum_squares += normalized * normalized;
+    uint64_t sum_pcm;
+    int32_t peak;
+    analyzer->kernels->window_level(out, samples, analyzer->window, count, &sum_pcm, &peak);
+    vu_analyzer_level_from_sums(sum_pcm, peak, count, level);
+}
 
-        int16_t abs_sample = (sample < 0) ? -sample : sample;
-        if (abs_sample > peak) peak = abs_sample;
-    }
+/* Batch buffers and plan are only needed for offline analysis, so they
+ * are set up on first use rather than in every live analyzer */
+static bool ensure_batch(vu_analyzer_t *analyzer)
+{
+    if (analyzer->batch_plan) return true;
 
-    float rms = sqrtf(sum_squares / count);
-    float peak_normalized = peak / 32768.0f;
+    /* Frames in the block must stay SIMD-aligned for FFTW */
+    int fft_size = analyzer->config.fft_size;
+    if (fft_size < 16) return false;
 
-    result->rms_db = 20.0f * log10f(rms + 1e-10f);
-    result->peak_db = 20.0f * log10f(peak_normalized + 1e-10f);
-    result->is_silence = (result->rms_db < SILENCE_THRESHOLD_DB);
+    analyzer->batch_input = vu_fft_alloc((size_t)fft_size * VU_ANALYZER_BATCH_FRAMES);
+    analyzer->batch_output = vu_fft_alloc(vu_fft_spectrum_stride(fft_size) * VU_ANALYZER_BATCH_FRAMES);
+    if (analyzer->batch_input && analyzer->batch_output) {
+        analyzer->batch_plan = vu_fft_plan_get_batch(fft_size, VU_ANALYZER_BATCH_FRAMES);
+    }
 
+    if (!analyzer->batch_plan) {
+        vu_fft_free(analyzer->batch_input);
+        vu_fft_free(analyzer->batch_output);
+        analyzer->batch_input = NULL;
+        analyzer->batch_output = NULL;
+        return false;
+    }
     return true;
 }
 
-bool vu_analyzer_freq_matches(const vu_analyzer_t *analyzer,
-                               float detected, float target)
+/* True if the frame is too quiet for any bin to reach min_level_db; the
+ * result is then filled in without running the transform */
+static bool gate_frame(vu_analyzer_t *analyzer, const vu_level_result_t *level,
+                       vu_freq_result_t *freq)
 {
-    if (!analyzer) return false;
-    float diff = fabsf(detected - target);
-    return diff <= analyzer->config.freq_tolerance_hz;
+    float bound_db = level->rms_db + analyzer->gate_margin_db;
+    if (bound_db >= analyzer->config.min_level_db) {
+        return false;
+    }
+
+    memset(freq, 0, sizeof(*freq));
+    freq->magnitude_db = bound_db;
+    analyzer->stats.ffts_skipped++;
+    return true;
 }
 
-/* WAV chunk header */
-typedef struct {
-    char id[4];
-    uint32_t size;
-} wav_chunk_t;
-
-/* WAV format chunk data */
-typedef struct {
-    uint16_t audio_format;
-    uint16_t num_channels;
-    uint32_t sample_rate;
-    uint32_t byte_rate;
-    uint16_t block_align;
-    uint16_t bits_per_sample;
-} wav_fmt_t;
-
-vu_freq_result_t *vu_analyzer_analyze_file(const char *path,
-                                            const vu_analyzer_config_t *config,
-                                            size_t *count)
+/* One frame: frequency, plus the level when `level` is non-NULL */
+static void analyze_one(vu_analyzer_t *analyzer, const int16_t *samples, size_t count,
+                        vu_freq_result_t *freq, vu_level_result_t *level)
 {
-    if (!path || !count) return NULL;
+    int fft_size = analyzer->config.fft_size;
+    size_t samples_to_use = (count < (size_t)fft_size) ? count : (size_t)fft_size;
 
-    *count = 0;
+    /* The gate needs the level, which the windowing pass measures anyway */
+    vu_level_result_t gate_level;
+    if (!level && analyzer->config.energy_gate && samples_to_use > 0) level = &gate_level;
 
-    FILE *f = fopen(path, "rb");
-    if (!f) return NULL;
+    memset(freq, 0, sizeof(*freq));
+    if (level) memset(level, 0, sizeof(*level));
 
-    /* Read RIFF header */
-    wav_chunk_t riff;
-    char wave[4];
-    if (fread(&riff, sizeof(riff), 1, f) != 1 ||
-        fread(wave, 4, 1, f) != 1) {
-        fclose(f);
-        return NULL;
+    /* Apply window and convert to float */
+    window_frame(analyzer, analyzer->input_buffer, samples, samples_to_use, level);
+
+    if (analyzer->config.energy_gate && samples_to_use > 0 &&
+        gate_frame(analyzer, level, freq)) {
+        return;
     }
+    analyzer->stats.ffts_run++;
 
-    /* Validate RIFF/WAVE */
-    if (memcmp(riff.id, "RIFF", 4) != 0 || memcmp(wave, "WAVE", 4) != 0) {
-        fclose(f);
-        return NULL;
+    /* Zero-pad if necessary */
+    memset(analyzer->input_buffer + samples_to_use, 0,
+           (fft_size - samples_to_use) * sizeof(float));
+
+    if (analyzer->config.target_count > 0) {
+        detect_goertzel(analyzer, analyzer->input_buffer, samples_to_use, freq);
+        return;
     }
 
-    /* Scan for fmt and data chunks */
-    wav_fmt_t fmt = {0};
-    uint32_t data_size = 0;
-    long data_offset = 0;
-    bool found_fmt = false, found_data = false;
+    /* Execute FFT */
+    vu_fft_execute(analyzer->plan, analyzer->input_buffer, analyzer->output);
 
-    while (!found_fmt || !found_data) {
-        wav_chunk_t chunk;
-        if (fread(&chunk, sizeof(chunk), 1, f) != 1) break;
+    spectrum_peak(analyzer, analyzer->output, freq);
+}
 
-        if (memcmp(chunk.id, "fmt ", 4) == 0) {
-            if (fread(&fmt, sizeof(fmt), 1, f) != 1) break;
-            /* Skip any extra fmt bytes */
-            if (chunk.size > sizeof(fmt)) {
-                fseek(f, chunk.size - sizeof(fmt), SEEK_CUR);
-            }
-            found_fmt = true;
-        } else if (memcmp(chunk.id, "data", 4) == 0) {
-            data_size = chunk.size;
-            data_offset = ftell(f);
-            found_data = true;
-        } else {
-            /* Skip unknown chunk */
-            fseek(f, chunk.size, SEEK_CUR);
+/* Transform the first `slots` frames of the batch block and store each
+ * peak in freqs[slot_frame[slot]], and its spectrum in spectra[...] when
+ * `spectra` is non-NULL */
+static void transform_slots(vu_analyzer_t *analyzer, size_t slots,
+                            const size_t *slot_frame, vu_freq_result_t *freqs,
+                            vu_spectrum_t *spectra)
+{
+    size_t fft_size = (size_t)analyzer->config.fft_size;
+    size_t stride = vu_fft_spectrum_stride(analyzer->config.fft_size);
+
+    if (slots == VU_ANALYZER_BATCH_FRAMES) {
+        vu_fft_execute(analyzer->batch_plan, analyzer->batch_input, analyzer->batch_output);
+    } else {
+        /* Partial block: one single-frame FFT each */
+        for (size_t s = 0; s < slots; s++) {
+            vu_fft_execute(analyzer->plan, analyzer->batch_input + s * fft_size,
+                           analyzer->batch_output + s * stride);
         }
     }
 
-    if (!found_fmt || !found_data || fmt.bits_per_sample == 0) {
-        fclose(f);
-        return NULL;
+    for (size_t s = 0; s < slots; s++) {
+        vu_freq_result_t *freq = &freqs[slot_frame[s]];
+        memset(freq, 0, sizeof(*freq));
+        spectrum_peak(analyzer, analyzer->batch_output + s * stride, freq);
+        if (spectra) spectra[slot_frame[s]].bins = analyzer->batch_output + s * stride;
     }
+    analyzer->stats.ffts_run += slots;
+}
 
-    /* Create analyzer with file's sample rate or config */
-    vu_analyzer_config_t file_config = config ? *config : vu_analyzer_default_config();
-    file_config.sample_rate = fmt.sample_rate;
+/* Frames `hop` apart: frequency, plus levels when `levels` is non-NULL and
+ * spectra when `spectra` is (frame_count <= VU_ANALYZER_BATCH_FRAMES, so
+ * no slot is reused) */
+static void analyze_batch(vu_analyzer_t *analyzer, const int16_t *samples, size_t hop,
+                          size_t frame_count, vu_freq_result_t *freqs,
+                          vu_level_result_t *levels, vu_spectrum_t *spectra)
+{
+    size_t fft_size = (size_t)analyzer->config.fft_size;
+
+    for (size_t f = 0; spectra && f < frame_count; f++) {
+        spectra[f] = (vu_spectrum_t){
+            .bins = NULL,
+            .bin_count = (int)fft_size / 2 + 1,
+            .bin_hz = (float)analyzer->config.sample_rate / fft_size,
+            .scale = 2.0f / fft_size
+        };
+    }
 
-    vu_analyzer_t *analyzer = vu_analyzer_create(&file_config);
-    if (!analyzer) {
-        fclose(f);
-        return NULL;
+    /* Goertzel mode has no FFT to batch */
+    if (analyzer->config.target_count > 0 || !ensure_batch(analyzer)) {
+        for (size_t f = 0; f < frame_count; f++) {
+            analyze_one(analyzer, samples + f * hop, fft_size, &freqs[f],
+                        levels ? &levels[f] : NULL);
+        }
+        return;
     }
 
-    /* Calculate number of frames */
-    int frame_size = file_config.fft_size;
-    int hop_size = frame_size / 2;  /* 50% overlap */
-    int num_samples = data_size / (fmt.bits_per_sample / 8) / fmt.num_channels;
-    int num_frames = (num_samples - frame_size) / hop_size + 1;
+    /* Window each frame into the next free slot of the contiguous block.
+     * Gated frames leave their slot to be overwritten, so only frames that
+     * need a spectrum reach the FFT and full blocks stay batched. */
+    size_t slot_frame[VU_ANALYZER_BATCH_FRAMES];
+    size_t slots = 0;
 
-    if (num_frames <= 0) {
-        vu_analyzer_destroy(analyzer);
-        fclose(f);
-        return NULL;
+    for (size_t f = 0; f < frame_count; f++) {
+        vu_level_result_t gate_level;
+        vu_level_result_t *level = levels ? &levels[f] :
+                                   analyzer->config.energy_gate ? &gate_level : NULL;
+
+        window_frame(analyzer, analyzer->batch_input + slots * fft_size,
+                     samples + f * hop, fft_size, level);
+
+        if (analyzer->config.energy_gate && gate_frame(analyzer, level, &freqs[f])) {
+            continue;
+        }
+
+        slot_frame[slots++] = f;
+        if (slots == VU_ANALYZER_BATCH_FRAMES) {
+            transform_slots(analyzer, slots, slot_frame, freqs, spectra);
+            slots = 0;
+        }
     }
 
-    vu_freq_result_t *results = calloc(num_frames, sizeof(vu_freq_result_t));
-    if (!results) {
-        vu_analyzer_destroy(analyzer);
-        fclose(f);
-        return NULL;
+    if (slots > 0) {
+        transform_slots(analyzer, slots, slot_frame, freqs, spectra);
     }
+}
 
-    /* Read and analyze each frame */
-    int16_t *samples = malloc(frame_size * sizeof(int16_t));
-    if (!samples) {
-        free(results);
-        vu_analyzer_destroy(analyzer);
-        fclose(f);
-        return NULL;
+bool vu_analyzer_detect_frequency(vu_analyzer_t *analyzer,
+                                   const int16_t *samples, size_t count,
+                                   vu_freq_result_t *result)
+{
+    if (!analyzer || !samples || !result) return false;
+
+    analyze_one(analyzer, samples, count, result, NULL);
+    return true;
+}
+
+bool vu_analyzer_analyze_frame(vu_analyzer_t *analyzer,
+                                const int16_t *samples, size_t count,
+                                vu_freq_result_t *freq,
+                                vu_level_result_t *level)
+{
+    if (!analyzer || !samples || !freq || !level || count == 0) return false;
+
+    analyze_one(analyzer, samples, count, freq, level);
+    return true;
+}
+
+bool vu_analyzer_detect_peaks(vu_analyzer_t *analyzer,
+                              const int16_t *samples, size_t count,
+                              vu_peak_t *peaks, int max_peaks, int *peak_count)
+{
+    if (!analyzer || !samples || !peaks || !peak_count || max_peaks < 0) return false;
+
+    *peak_count = 0;
+    if (max_peaks > VU_ANALYZER_MAX_PEAKS) max_peaks = VU_ANALYZER_MAX_PEAKS;
+
+    int fft_size = analyzer->config.fft_size;
+    size_t samples_to_use = (count < (size_t)fft_size) ? count : (size_t)fft_size;
+    bool gate = analyzer->config.energy_gate && samples_to_use > 0;
+
+    vu_level_result_t level;
+    window_frame(analyzer, analyzer->input_buffer, samples, samples_to_use,
+                 gate ? &level : NULL);
+
+    /* A gated frame has no bin above min_level_db, so no peaks */
+    vu_freq_result_t gated;
+    if (gate && gate_frame(analyzer, &level, &gated)) {
+        return true;
     }
+    analyzer->stats.ffts_run++;
 
-    int result_count = 0;
-    for (int frame = 0; frame < num_frames && result_count < num_frames; frame++) {
-        long file_offset = data_offset + frame * hop_size * sizeof(int16_t);
-        fseek(f, file_offset, SEEK_SET);
+    memset(analyzer->input_buffer + samples_to_use, 0,
+           (fft_size - samples_to_use) * sizeof(float));
 
-        size_t samples_read = fread(samples, sizeof(int16_t), frame_size, f);
-        if (samples_read < (size_t)frame_size / 2) break;
+    if (analyzer->config.target_count > 0) {
+        *peak_count = goertzel_peaks(analyzer, analyzer->input_buffer, peaks, max_peaks);
+        return true;
+    }
 
-        if (vu_analyzer_detect_frequency(analyzer, samples, samples_read, &results[result_count])) {
-            result_count++;
-        }
+    vu_fft_execute(analyzer->plan, analyzer->input_buffer, analyzer->output);
+
+    *peak_count = spectrum_peaks(analyzer, analyzer->output, peaks, max_peaks);
+    return true;
+}
+
+bool vu_analyzer_detect_frequency_batch(vu_analyzer_t *analyzer,
+                                         const int16_t *samples, size_t hop,
+                                         size_t frame_count,
+                                         vu_freq_result_t *results)
+{
+    if (!analyzer || !samples || !results || hop == 0) return false;
+
+    analyze_batch(analyzer, samples, hop, frame_count, results, NULL, NULL);
+    return true;
+}
+
+bool vu_analyzer_analyze_batch(vu_analyzer_t *analyzer,
+                                const int16_t *samples, size_t hop,
+                                size_t frame_count,
+                                vu_freq_result_t *freqs,
+                                vu_level_result_t *levels)
+{
+    if (!analyzer || !samples || !freqs || !levels || hop == 0) return false;
+
+    analyze_batch(analyzer, samples, hop, frame_count, freqs, levels, NULL);
+    return true;
+}
+
+bool vu_analyzer_analyze_spectra(vu_analyzer_t *analyzer,
+                                 const int16_t *samples, size_t hop,
+                                 size_t frame_count,
+                                 vu_freq_result_t *freqs,
+                                 vu_level_result_t *levels,
+                                 vu_spectrum_t *spectra)
+{
+    if (!analyzer || !samples || !freqs || !levels || !spectra || hop == 0 ||
+        frame_count > VU_ANALYZER_BATCH_FRAMES) {
+        return false;
     }
 
-    free(samples);
-    vu_analyzer_destroy(analyzer);
-    fclose(f);
+    analyze_batch(analyzer, samples, hop, frame_count, freqs, levels, spectra);
+    return true;
+}
+
+void vu_analyzer_get_stats(const vu_analyzer_t *analyzer, vu_analyzer_stats_t *stats)
+{
+    if (!stats) return;
 
-    *count = result_count;
-    return results;
+    if (analyzer) {
+        *stats = analyzer->stats;
+    } else {
+        memset(stats, 0, sizeof(*stats));
+    }
 }
 
-void vu_analyzer_free_results(vu_freq_result_t *results)
+bool vu_analyzer_freq_matches(const vu_analyzer_t *analyzer,
+                               float detected, float target)
 {
-    free(results);
+    if (!analyzer) return false;
+    float diff = fabsf(detected - target);
+    return diff <= analyzer->config.freq_tolerance_hz;
 }
@@ -1,21 +1,110 @@
 /*
  * voip-utility - SIP VoIP Testing Utility
  * FFT-based audio analyzer for frequency detection
+ *
+ * Two engines implement this interface: floating point on FFTW
+ * (analyzer.c, the default) and Q15/Q31 fixed point with no FFTW
+ * dependency (analyzer_fixed.c, meson -Dfixed_point=true).
  */
 
 #ifndef VU_ANALYZER_H
 #define VU_ANALYZER_H
 
+#include "util/error.h"
 #include <stdbool.h>
 #include <stdint.h>
 #include <stddef.h>
 
+/* Maximum target frequencies for the Goertzel filter bank */
+#define VU_ANALYZER_MAX_TARGETS 8
+
+/* Frames transformed together by vu_analyzer_analyze_batch; batches of
+ * this many frames get the full benefit */
+#define VU_ANALYZER_BATCH_FRAMES 32
+
+/* Goertzel mode: least share of a frame's energy the strongest target
+ * must carry to count as a tone (a pure tone at the target carries 1) */
+#define VU_ANALYZER_MIN_TONE_SHARE 0.5f
+
+/* Most peaks vu_analyzer_detect_peaks reports per frame */
+#define VU_ANALYZER_MAX_PEAKS 16
+
+/* num_threads value: one file analysis worker per online CPU */
+#define VU_ANALYZER_THREADS_AUTO (-1)
+
+/* channel value: analyze the mean of all channels */
+#define VU_ANALYZER_CHANNEL_MIX (-1)
+
+/* Sub-bin refinement of the FFT peak */
+typedef enum {
+    VU_PEAK_INTERP_NONE = 0,  /* Bin centre: frequency = bin * sample_rate / fft_size */
+    VU_PEAK_INTERP_PARABOLIC, /* Parabola through the dB magnitudes of three bins */
+    VU_PEAK_INTERP_JACOBSEN   /* Jacobsen's estimator on the complex bins,
+                               * corrected for the Hann window */
+} vu_peak_interp_t;
+
 /* Analyzer configuration */
 typedef struct vu_analyzer_config {
     int sample_rate;          /* Audio sample rate (e.g., 8000, 16000) */
     int fft_size;             /* FFT window size (power of 2, e.g., 512, 1024) */
     float min_level_db;       /* Minimum level to consider as signal (e.g., -40) */
     float freq_tolerance_hz;  /* Frequency detection tolerance (e.g., 50 Hz) */
+
+    /* Goertzel mode: when target_count > 0, only these frequencies are
+     * evaluated (one Goertzel filter each) instead of a full FFT scan. A
+     * frame is valid when the strongest target is above min_level_db and
+     * carries VU_ANALYZER_MIN_TONE_SHARE of the frame's energy; its
+     * frequency is then measured from filters one bin either side
+     * (interpolation, parabolic if none), else reported as 0. */
+    float target_freqs_hz[VU_ANALYZER_MAX_TARGETS];
+    int target_count;
+
+    /* FFT mode: refine the dominant frequency and its magnitude between
+     * bins. Either method is within a few hundredths of a bin on a clean
+     * tone, so a 128- or 256-point FFT locates it as precisely as a
+     * 512-point one without, at a quarter of the frame length. */
+    vu_peak_interp_t interpolation;
+
+    /* File analysis worker threads (0 or 1 = serial,
+     * VU_ANALYZER_THREADS_AUTO = one per CPU). Results are identical
+     * to the serial path and still delivered in frame order. */
+    int num_threads;
+
+    /* Skip the FFT on frames whose energy proves no bin can reach
+     * min_level_db. Gated frames come back invalid with frequency 0 and
+     * magnitude_db set to that energy bound; `valid` never differs from
+     * the ungated result. */
+    bool energy_gate;
+
+    /* File analysis frame step in milliseconds (0 = half a frame) */
+    float hop_ms;
+
+    /* File analysis: update the spectrum sample by sample with a sliding
+     * DFT instead of transforming every frame. Costs O(bins) per sample
+     * however short the hop, so fine hops (e.g. 1 ms for beep edges) stay
+     * cheap. Tracks the targets, or the bins between band_min_hz and
+     * band_max_hz; runs on one thread. */
+    bool sliding_dft;
+    float band_min_hz;        /* Sliding DFT band (e.g., 300) */
+    float band_max_hz;        /* (e.g., 3400) */
+
+    /* File analysis: convert faster input to this rate in the reader
+     * (e.g., 8000: 16 kHz by one half-band stage, 44.1 kHz by two and a
+     * polyphase resampler), scaling fft_size to the nearest power of two
+     * so frames keep about their duration. Files at or below this rate,
+     * or with a target above the telephony passband, are analyzed at
+     * their own rate. 0 = always the file rate. */
+    int analysis_rate;
+
+    /* File analysis: channel of a multi-channel file to analyze (0-based),
+     * or VU_ANALYZER_CHANNEL_MIX for the mean of all channels */
+    int channel;
+
+    /* File analysis: hand each frame's FFT spectrum to the callback
+     * (vu_analysis_frame_t.spectrum) so several detectors can share one
+     * transform. Runs on one thread and bypasses the result cache, which
+     * only stores the per-frame results. */
+    bool keep_spectrum;
 } vu_analyzer_config_t;
 
 /* Frequency detection result */
@@ -25,6 +114,12 @@ typedef struct vu_freq_result {
     bool valid;               /* True if valid frequency detected above threshold */
 } vu_freq_result_t;
 
+/* One spectral peak (vu_analyzer_detect_peaks) */
+typedef struct vu_peak {
+    float frequency;          /* Peak frequency in Hz, between bins */
+    float magnitude_db;       /* Peak magnitude in dB, scaled as magnitude_db above */
+} vu_peak_t;
+
 /* Audio level result */
 typedef struct vu_level_result {
     float rms_db;             /* RMS level in dB */
@@ -32,6 +127,51 @@ typedef struct vu_level_result {
     bool is_silence;          /* True if below threshold */
 } vu_level_result_t;
 
+/* Spectrum of one Hann-windowed frame, shared read-only by its consumers */
+typedef struct vu_spectrum {
+    const float *bins;        /* bin_count interleaved re/im pairs, or NULL if the
+                               * frame was not transformed (gated, Goertzel mode) */
+    int bin_count;            /* fft_size / 2 + 1 */
+    float bin_hz;             /* Bin spacing in Hz */
+    float scale;              /* |bin| * scale is on magnitude_db's scale */
+} vu_spectrum_t;
+
+/* Per-frame result delivered by the streaming file analysis */
+typedef struct vu_analysis_frame {
+    size_t index;             /* Frame number (0-based) */
+    double time_sec;          /* Frame start time in seconds */
+    uint32_t sample_rate;     /* Rate the frame was analyzed at */
+    vu_freq_result_t freq;    /* Dominant frequency */
+    vu_level_result_t level;  /* RMS/peak level of the frame */
+    const vu_spectrum_t *spectrum;  /* With config->keep_spectrum, else NULL */
+} vu_analysis_frame_t;
+
+/* Summary of a streaming file analysis run */
+typedef struct vu_analysis_summary {
+    uint32_t source_rate;     /* Sample rate of the file */
+    uint32_t sample_rate;     /* Sample rate analyzed (see analysis_rate) */
+    size_t frame_size;        /* Samples per frame */
+    size_t hop_size;          /* Samples between frame starts */
+    size_t frame_count;       /* Frames delivered to the callback */
+    double duration_sec;      /* Audio duration covered by the frames */
+    uint64_t ffts_run;        /* Frames whose spectrum was computed */
+    uint64_t ffts_skipped;    /* Frames rejected by the energy gate */
+    bool cached;              /* Frames replayed from the result cache */
+} vu_analysis_summary_t;
+
+/* Work counters of one analyzer (Goertzel evaluations count as FFTs) */
+typedef struct vu_analyzer_stats {
+    uint64_t ffts_run;        /* Frames whose spectrum was computed */
+    uint64_t ffts_skipped;    /* Frames rejected by the energy gate */
+} vu_analyzer_stats_t;
+
+/*
+ * Frame callback for streaming analysis.
+ * The frame is only valid for the duration of the call.
+ * Return false to stop the analysis early.
+ */
+typedef bool (*vu_analysis_frame_cb_t)(void *user_data, const vu_analysis_frame_t *frame);
+
 /* Opaque analyzer context */
 typedef struct vu_analyzer vu_analyzer_t;
 
@@ -62,6 +202,71 @@ bool vu_analyzer_detect_frequency(vu_analyzer_t *analyzer,
                                    const int16_t *samples, size_t count,
                                    vu_freq_result_t *result);
 
+/*
+ * Fused analysis: dominant frequency and RMS/peak level of a frame in one
+ * pass over the samples (the level covers the same first fft_size samples
+ * the frequency is taken from).
+ * Returns true on success.
+ */
+bool vu_analyzer_analyze_frame(vu_analyzer_t *analyzer,
+                                const int16_t *samples, size_t count,
+                                vu_freq_result_t *freq,
+                                vu_level_result_t *level);
+
+/*
+ * Analyze `frame_count` frames of fft_size samples starting `hop` samples
+ * apart (frame i at samples + i * hop). Frames are windowed into one
+ * contiguous block and transformed together; results are identical to
+ * calling vu_analyzer_detect_frequency on each frame.
+ * results: output array of frame_count entries
+ * Returns true on success.
+ */
+bool vu_analyzer_detect_frequency_batch(vu_analyzer_t *analyzer,
+                                         const int16_t *samples, size_t hop,
+                                         size_t frame_count,
+                                         vu_freq_result_t *results);
+
+/*
+ * Fused batch: frequencies and levels of `frame_count` frames laid out as
+ * for vu_analyzer_detect_frequency_batch.
+ * freqs, levels: output arrays of frame_count entries
+ * Returns true on success.
+ */
+bool vu_analyzer_analyze_batch(vu_analyzer_t *analyzer,
+                                const int16_t *samples, size_t hop,
+                                size_t frame_count,
+                                vu_freq_result_t *freqs,
+                                vu_level_result_t *levels);
+
+/*
+ * vu_analyzer_analyze_batch that also returns each frame's spectrum.
+ * frame_count is at most VU_ANALYZER_BATCH_FRAMES. The spectra point
+ * into the analyzer and stay valid until its next call.
+ * spectra: output array of frame_count entries
+ * Returns true on success.
+ */
+bool vu_analyzer_analyze_spectra(vu_analyzer_t *analyzer,
+                                 const int16_t *samples, size_t hop,
+                                 size_t frame_count,
+                                 vu_freq_result_t *freqs,
+                                 vu_level_result_t *levels,
+                                 vu_spectrum_t *spectra);
+
+/*
+ * Find up to `max_peaks` (at most VU_ANALYZER_MAX_PEAKS) spectral peaks
+ * of a frame, strongest first: the local maxima above min_level_db,
+ * chosen in one pass over the same FFT vu_analyzer_detect_frequency
+ * uses. Frequency and magnitude are refined by fitting a parabola to the
+ * dB magnitudes of the peak bin and its neighbours. In Goertzel mode the
+ * peaks are the targets above min_level_db, at their exact frequencies.
+ * peaks: output array of max_peaks entries
+ * peak_count: number of peaks found
+ * Returns true on success.
+ */
+bool vu_analyzer_detect_peaks(vu_analyzer_t *analyzer,
+                              const int16_t *samples, size_t count,
+                              vu_peak_t *peaks, int max_peaks, int *peak_count);
+
 /*
  * Calculate audio level (RMS and peak)
  */
@@ -69,6 +274,31 @@ bool vu_analyzer_calculate_level(vu_analyzer_t *analyzer,
                                   const int16_t *samples, size_t count,
                                   vu_level_result_t *result);
 
+/*
+ * Convert exact PCM sums over `count` samples (sum of squares, largest
+ * absolute sample) to RMS/peak levels in dBFS
+ */
+void vu_analyzer_level_from_sums(uint64_t sum_squares, int32_t peak, size_t count,
+                                 vu_level_result_t *result);
+
+/*
+ * Power of one spectrum bin, |X|^2 on magnitude_db's scale (0 if the
+ * frame was not transformed or the bin is out of range)
+ */
+float vu_spectrum_power(const vu_spectrum_t *spectrum, int bin);
+
+/*
+ * Level in dB at `freq_hz`: the stronger of the two bins either side of
+ * it, on magnitude_db's scale (-200 if the frame was not transformed or
+ * the frequency is out of range)
+ */
+float vu_spectrum_level_db(const vu_spectrum_t *spectrum, float freq_hz);
+
+/*
+ * Get the analyzer's work counters since it was created
+ */
+void vu_analyzer_get_stats(const vu_analyzer_t *analyzer, vu_analyzer_stats_t *stats);
+
 /*
  * Check if frequency matches target within tolerance
  */
@@ -84,6 +314,25 @@ vu_freq_result_t *vu_analyzer_analyze_file(const char *path,
                                             const vu_analyzer_config_t *config,
                                             size_t *count);
 
+/*
+ * Analyze WAV file, delivering each frame's result to a callback as it is
+ * produced. Memory use is bounded by the frame size regardless of the
+ * recording length.
+ * With config->num_threads > 1 the file is split into time ranges analyzed
+ * by worker threads; the callback is still invoked from the calling thread,
+ * in frame order.
+ * When the result cache is enabled (vu_analysis_cache_init), results of
+ * an unchanged file analyzed with the same settings are replayed from it,
+ * and a complete run that missed is stored.
+ * summary: optional, filled in on return
+ * Returns VU_OK on success (including early stop by the callback).
+ */
+vu_error_t vu_analyzer_analyze_file_stream(const char *path,
+                                           const vu_analyzer_config_t *config,
+                                           vu_analysis_frame_cb_t callback,
+                                           void *user_data,
+                                           vu_analysis_summary_t *summary);
+
 /*
  * Free results from analyze_file
  */
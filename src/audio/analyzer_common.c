@@ -0,0 +1,603 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Analyzer code shared by the floating-point and fixed-point engines:
+ * defaults, levels and file analysis
+ */
+
+#include "audio/analyzer.h"
+#include "audio/analysis_cache.h"
+#include "audio/analyzer_simd.h"
+#include "audio/decimator.h"
+#include "audio/sliding_dft.h"
+#include "audio/wav_reader.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#define SILENCE_THRESHOLD_DB -60.0f
+
+/* Parallel file analysis: frames per worker per round (bounds memory and
+ * callback latency), and the least work worth a thread */
+#define PARALLEL_BATCH_FRAMES 2048
+#define PARALLEL_MIN_FRAMES   512
+#define PARALLEL_MAX_THREADS  64
+
+/* Samples fed to the sliding DFT per reader peek */
+#define SLIDING_READ_CHUNK 4096
+
+/* Shortest frame after converting to analysis_rate */
+#define CONVERT_MIN_FFT 64
+
+vu_analyzer_config_t vu_analyzer_default_config(void)
+{
+    vu_analyzer_config_t config = {
+        .sample_rate = 8000,
+        .fft_size = 512,
+        .min_level_db = -40.0f,
+        .freq_tolerance_hz = 50.0f,
+        .target_count = 0,
+        .interpolation = VU_PEAK_INTERP_NONE,
+        .num_threads = 1,
+        .energy_gate = true,
+        .hop_ms = 0.0f,
+        .sliding_dft = false,
+        .band_min_hz = 300.0f,
+        .band_max_hz = 3400.0f,
+        .analysis_rate = 0,
+        .channel = 0,
+        .keep_spectrum = false
+    };
+    return config;
+}
+
+void vu_analyzer_level_from_sums(uint64_t sum_squares, int32_t peak, size_t count,
+                                 vu_level_result_t *result)
+{
+    float mean_square = (float)(sum_squares / (32768.0 * 32768.0));
+    float rms = sqrtf(mean_square / count);
+    float peak_normalized = peak / 32768.0f;
+
+    result->rms_db = 20.0f * log10f(rms + 1e-10f);
+    result->peak_db = 20.0f * log10f(peak_normalized + 1e-10f);
+    result->is_silence = (result->rms_db < SILENCE_THRESHOLD_DB);
+}
+
+bool vu_analyzer_calculate_level(vu_analyzer_t *analyzer,
+                                  const int16_t *samples, size_t count,
+                                  vu_level_result_t *result)
+{
+    if (!analyzer || !samples || !result || count == 0) return false;
+
+    /* Exact integer accumulation: no float drift on long frames, and
+     * -32768 no longer overflows the peak */
+    uint64_t sum_pcm;
+    int32_t peak;
+    vu_analyzer_kernels()->level(samples, count, &sum_pcm, &peak);
+    vu_analyzer_level_from_sums(sum_pcm, peak, count, result);
+
+    return true;
+}
+
+float vu_spectrum_power(const vu_spectrum_t *spectrum, int bin)
+{
+    if (!spectrum || !spectrum->bins || bin < 0 || bin >= spectrum->bin_count) return 0.0f;
+
+    float re = spectrum->bins[2 * bin] * spectrum->scale;
+    float im = spectrum->bins[2 * bin + 1] * spectrum->scale;
+    return re * re + im * im;
+}
+
+float vu_spectrum_level_db(const vu_spectrum_t *spectrum, float freq_hz)
+{
+    if (!spectrum || !spectrum->bins || freq_hz < 0.0f) return -200.0f;
+
+    int below = (int)(freq_hz / spectrum->bin_hz);
+    if (below >= spectrum->bin_count) return -200.0f;
+
+    float power = vu_spectrum_power(spectrum, below);
+    float above = vu_spectrum_power(spectrum, below + 1);
+    if (above > power) power = above;
+    return 10.0f * log10f(power + 1e-20f);
+}
+
+/*
+ * Analyze up to `max` frames from the reader's position, one FFT batch per
+ * peek: a batch of n frames spans frame_size + (n - 1) * hop samples.
+ * With `spectra` (max at most VU_ANALYZER_BATCH_FRAMES, so one batch),
+ * frame i's spectrum is spectra[i], valid until the next call.
+ * Returns the number of frames produced (fewer than max at end of data).
+ */
+static size_t analyze_frames(vu_analyzer_t *analyzer, vu_wav_reader_t *reader,
+                             size_t frame_size, size_t hop_size, size_t first_index,
+                             size_t max, vu_analysis_frame_t *frames,
+                             vu_spectrum_t *spectra)
+{
+    const vu_wav_info_t *info = vu_wav_reader_get_info(reader);
+    vu_freq_result_t freqs[VU_ANALYZER_BATCH_FRAMES];
+    vu_level_result_t levels[VU_ANALYZER_BATCH_FRAMES];
+    size_t done = 0;
+
+    while (done < max) {
+        uint64_t left = info->sample_count - vu_wav_reader_tell(reader);
+        if (left < frame_size) break;
+
+        size_t n = max - done;
+        if (n > VU_ANALYZER_BATCH_FRAMES) n = VU_ANALYZER_BATCH_FRAMES;
+        if ((left - frame_size) / hop_size + 1 < n) n = (size_t)((left - frame_size) / hop_size + 1);
+
+        const int16_t *samples = vu_wav_reader_peek(reader, frame_size + (n - 1) * hop_size);
+        if (!samples) break;
+
+        if (spectra) {
+            vu_analyzer_analyze_spectra(analyzer, samples, hop_size, n, freqs, levels,
+                                        spectra + done);
+        } else {
+            vu_analyzer_analyze_batch(analyzer, samples, hop_size, n, freqs, levels);
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            vu_analysis_frame_t *frame = &frames[done + i];
+            memset(frame, 0, sizeof(*frame));
+            frame->index = first_index + done + i;
+            frame->time_sec = (double)(frame->index * hop_size) / info->sample_rate;
+            frame->sample_rate = info->sample_rate;
+            frame->freq = freqs[i];
+            frame->level = levels[i];
+            if (spectra) frame->spectrum = &spectra[done + i];
+        }
+
+        vu_wav_reader_advance(reader, n * hop_size);
+        done += n;
+    }
+
+    return done;
+}
+
+/*
+ * Open `path` reading `channel` at `rate` (0 = the file's rate).
+ * Returns NULL on failure, with the error set.
+ */
+static vu_wav_reader_t *open_reader(const char *path, int channel, uint32_t rate)
+{
+    vu_wav_reader_t *reader = vu_wav_reader_open(path);
+    if (!reader) return NULL;
+
+    const vu_wav_info_t *info = vu_wav_reader_get_info(reader);
+    int wav_channel = channel == VU_ANALYZER_CHANNEL_MIX ? VU_WAV_CHANNEL_MIX : channel;
+    if (!vu_wav_reader_set_channel(reader, wav_channel)) {
+        VU_SET_ERROR(VU_ERR_INVALID_ARG, "No channel %d in %s (%u channels)",
+                     channel, path, info->num_channels);
+        vu_wav_reader_close(reader);
+        return NULL;
+    }
+
+    if (rate != 0 && rate != info->source_rate &&
+        !vu_wav_reader_set_output_rate(reader, rate)) {
+        VU_SET_ERROR(VU_ERR_NO_MEMORY, "Failed to set up conversion from %u to %u Hz",
+                     info->source_rate, rate);
+        vu_wav_reader_close(reader);
+        return NULL;
+    }
+    return reader;
+}
+
+/* One worker of the parallel file analysis: a private reader and analyzer */
+typedef struct {
+    vu_wav_reader_t *reader;
+    vu_analyzer_t *analyzer;
+    size_t frame_size;
+    size_t hop_size;
+
+    /* Current round */
+    size_t first;                 /* First frame index */
+    size_t count;                 /* Frames requested */
+    size_t done;                  /* Frames produced */
+    vu_analysis_frame_t *frames;
+} analysis_worker_t;
+
+static void *analysis_worker_run(void *arg)
+{
+    analysis_worker_t *w = arg;
+
+    vu_wav_reader_seek(w->reader, (uint64_t)w->first * w->hop_size);
+    w->done = analyze_frames(w->analyzer, w->reader, w->frame_size, w->hop_size,
+                             w->first, w->count, w->frames, NULL);
+    return NULL;
+}
+
+static int resolve_thread_count(int requested, size_t total_frames)
+{
+    int threads = requested;
+    if (threads == VU_ANALYZER_THREADS_AUTO) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+    if (threads > PARALLEL_MAX_THREADS) threads = PARALLEL_MAX_THREADS;
+
+    size_t useful = total_frames / PARALLEL_MIN_FRAMES;
+    if ((size_t)threads > useful) threads = (int)useful;
+    return threads > 1 ? threads : 1;
+}
+
+/*
+ * Parallel path: each round hands consecutive runs of frames to the
+ * workers, then delivers the results in order from this thread. Frames
+ * are independent, so workers overlap at range boundaries simply by
+ * reading their first frame from before the boundary, and the output
+ * matches the serial path exactly.
+ */
+static vu_error_t analyze_parallel(const char *path, vu_wav_reader_t *reader,
+                                   vu_analyzer_t *analyzer, const vu_analyzer_config_t *config,
+                                   int threads, size_t total_frames, size_t frame_size,
+                                   size_t hop_size, vu_analysis_frame_cb_t callback,
+                                   void *user_data, size_t *frame_count,
+                                   vu_analyzer_stats_t *worker_stats)
+{
+    analysis_worker_t *workers = calloc((size_t)threads, sizeof(analysis_worker_t));
+    pthread_t *tids = calloc((size_t)threads, sizeof(pthread_t));
+    vu_analysis_frame_t *frames = malloc((size_t)threads * PARALLEL_BATCH_FRAMES *
+                                         sizeof(vu_analysis_frame_t));
+    vu_error_t err = VU_OK;
+
+    if (!workers || !tids || !frames) {
+        VU_SET_ERROR(VU_ERR_NO_MEMORY, "Failed to allocate analysis workers");
+        err = VU_ERR_NO_MEMORY;
+        goto done;
+    }
+
+    /* Worker 0 reuses the caller's reader and analyzer; the others get
+     * their own buffers but share the cached plan */
+    for (int i = 0; i < threads; i++) {
+        analysis_worker_t *w = &workers[i];
+        w->reader = i == 0 ? reader : open_reader(path, config->channel,
+                                                  vu_wav_reader_get_info(reader)->sample_rate);
+        w->analyzer = i == 0 ? analyzer : vu_analyzer_create(config);
+        w->frame_size = frame_size;
+        w->hop_size = hop_size;
+        w->frames = frames + (size_t)i * PARALLEL_BATCH_FRAMES;
+
+        if (!w->reader || !w->analyzer) {
+            VU_SET_ERROR(VU_ERR_NO_MEMORY, "Failed to create analysis worker %d", i);
+            err = VU_ERR_NO_MEMORY;
+            goto done;
+        }
+    }
+
+    size_t next = 0;
+    bool stop = false;
+    while (next < total_frames && !stop) {
+        int active = 0;
+        for (; active < threads && next < total_frames; active++) {
+            analysis_worker_t *w = &workers[active];
+            w->first = next;
+            w->count = total_frames - next < PARALLEL_BATCH_FRAMES ?
+                       total_frames - next : PARALLEL_BATCH_FRAMES;
+            next += w->count;
+        }
+
+        /* Run worker 0 here; fall back to running inline if a thread
+         * cannot be started */
+        bool started[PARALLEL_MAX_THREADS] = {false};
+        for (int i = 1; i < active; i++) {
+            started[i] = pthread_create(&tids[i], NULL, analysis_worker_run, &workers[i]) == 0;
+        }
+        analysis_worker_run(&workers[0]);
+        for (int i = 1; i < active; i++) {
+            if (started[i]) {
+                pthread_join(tids[i], NULL);
+            } else {
+                analysis_worker_run(&workers[i]);
+            }
+        }
+
+        /* Stitch: deliver in frame order, stopping at the first gap */
+        for (int i = 0; i < active && !stop; i++) {
+            analysis_worker_t *w = &workers[i];
+            for (size_t f = 0; f < w->done && !stop; f++) {
+                (*frame_count)++;
+                stop = !callback(user_data, &w->frames[f]);
+            }
+            if (w->done < w->count) stop = true;
+        }
+    }
+
+done:
+    if (workers) {
+        for (int i = 1; i < threads; i++) {
+            /* Worker 0's counters stay in the caller's analyzer */
+            vu_analyzer_stats_t stats;
+            vu_analyzer_get_stats(workers[i].analyzer, &stats);
+            worker_stats->ffts_run += stats.ffts_run;
+            worker_stats->ffts_skipped += stats.ffts_skipped;
+            vu_analyzer_destroy(workers[i].analyzer);
+            vu_wav_reader_close(workers[i].reader);
+        }
+    }
+    free(frames);
+    free(tids);
+    free(workers);
+    return err;
+}
+
+/*
+ * Sliding DFT path: every sample goes through the DFT once, in order, and
+ * a frame is taken each time the window has moved on by a hop.
+ */
+static vu_error_t analyze_sliding(vu_wav_reader_t *reader, const vu_analyzer_config_t *config,
+                                  size_t frame_size, size_t hop_size,
+                                  vu_analysis_frame_cb_t callback, void *user_data,
+                                  size_t *frame_count)
+{
+    const vu_wav_info_t *info = vu_wav_reader_get_info(reader);
+    vu_sdft_t *sdft = vu_sdft_create(config);
+    if (!sdft) {
+        VU_SET_ERROR(VU_ERR_INVALID_ARG, "Invalid sliding DFT band (%.0f-%.0f Hz)",
+                     config->band_min_hz, config->band_max_hz);
+        return VU_ERR_INVALID_ARG;
+    }
+
+    uint64_t pushed = 0;
+    bool stop = false;
+    while (!stop) {
+        /* Window of frame i: samples [i * hop, i * hop + frame_size) */
+        uint64_t end = (uint64_t)*frame_count * hop_size + frame_size;
+        if (end > info->sample_count) break;
+
+        while (pushed < end) {
+            size_t n = end - pushed < SLIDING_READ_CHUNK ? (size_t)(end - pushed) : SLIDING_READ_CHUNK;
+            const int16_t *samples = vu_wav_reader_peek(reader, n);
+            if (!samples) {
+                stop = true;
+                break;
+            }
+            vu_sdft_push(sdft, samples, n);
+            vu_wav_reader_advance(reader, n);
+            pushed += n;
+        }
+        if (stop) break;
+
+        vu_analysis_frame_t frame;
+        memset(&frame, 0, sizeof(frame));
+        frame.index = *frame_count;
+        frame.time_sec = (double)(frame.index * hop_size) / info->sample_rate;
+        frame.sample_rate = info->sample_rate;
+        vu_sdft_result(sdft, &frame.freq, &frame.level);
+
+        (*frame_count)++;
+        stop = !callback(user_data, &frame);
+    }
+
+    vu_sdft_destroy(sdft);
+    return VU_OK;
+}
+
+/* Passes frames on to the caller's callback, storing them in the result
+ * cache on the way */
+typedef struct {
+    vu_analysis_frame_cb_t callback;
+    void *user_data;
+    vu_analysis_cache_writer_t *writer;
+    bool stopped;                 /* The callback asked to stop */
+} cache_tee_t;
+
+static bool cache_tee_frame(void *user_data, const vu_analysis_frame_t *frame)
+{
+    cache_tee_t *tee = user_data;
+
+    vu_analysis_cache_add(tee->writer, frame);
+    tee->stopped = !tee->callback(tee->user_data, frame);
+    return !tee->stopped;
+}
+
+/*
+ * Rate to analyze a file at: analysis_rate when the file is faster and
+ * every frequency of interest fits the converted band, else the file's
+ * own rate (converting up would add work, not information)
+ */
+static uint32_t choose_rate(const vu_analyzer_config_t *config, uint32_t file_rate)
+{
+    if (config->analysis_rate <= 0 || (uint32_t)config->analysis_rate >= file_rate) {
+        return file_rate;
+    }
+
+    float passband = VU_HALFBAND_PASSBAND * config->analysis_rate;
+    if (config->sliding_dft && config->target_count == 0 && config->band_max_hz > passband) {
+        return file_rate;
+    }
+    for (int t = 0; t < config->target_count; t++) {
+        if (config->target_freqs_hz[t] > passband) return file_rate;
+    }
+    return (uint32_t)config->analysis_rate;
+}
+
+/* fft_size scaled by `ratio`, to the nearest power of two */
+static int scale_fft_size(int fft_size, double ratio)
+{
+    double want = fft_size * ratio;
+    int size = CONVERT_MIN_FFT;
+    while (size * M_SQRT2 < want) size *= 2;
+    return size;
+}
+
+vu_error_t vu_analyzer_analyze_file_stream(const char *path,
+                                           const vu_analyzer_config_t *config,
+                                           vu_analysis_frame_cb_t callback,
+                                           void *user_data,
+                                           vu_analysis_summary_t *summary)
+{
+    if (summary) memset(summary, 0, sizeof(*summary));
+
+    if (!path || !callback) {
+        VU_SET_ERROR(VU_ERR_INVALID_ARG, "Invalid arguments");
+        return VU_ERR_INVALID_ARG;
+    }
+
+    vu_analyzer_config_t file_config = config ? *config : vu_analyzer_default_config();
+
+    /* Unchanged file and settings: replay the stored results. On a miss,
+     * the frames are stored on their way to the callback. The cache has
+     * no spectra to replay. */
+    vu_analysis_cache_key_t cache_key;
+    cache_tee_t tee = {.callback = callback, .user_data = user_data};
+    if (!file_config.keep_spectrum && vu_analysis_cache_key(path, &file_config, &cache_key)) {
+        if (vu_analysis_cache_replay(&cache_key, callback, user_data, summary)) {
+            return VU_OK;
+        }
+        tee.writer = vu_analysis_cache_begin(&cache_key);
+        if (tee.writer) {
+            callback = cache_tee_frame;
+            user_data = &tee;
+        }
+    }
+
+    vu_wav_reader_t *reader = open_reader(path, file_config.channel, 0);
+    if (!reader) {
+        vu_analysis_cache_end(tee.writer, NULL, false);
+        return vu_get_last_error()->code;
+    }
+
+    const vu_wav_info_t *info = vu_wav_reader_get_info(reader);
+
+    /* Convert to analysis_rate in the reader, scaling the frame to keep
+     * about the same duration; frequencies and times stay in Hz and
+     * seconds */
+    uint32_t rate = choose_rate(&file_config, info->source_rate);
+    if (rate != info->source_rate) {
+        if (!vu_wav_reader_set_output_rate(reader, rate)) {
+            vu_wav_reader_close(reader);
+            vu_analysis_cache_end(tee.writer, NULL, false);
+            VU_SET_ERROR(VU_ERR_NO_MEMORY, "Failed to set up conversion from %u to %u Hz",
+                         info->source_rate, rate);
+            return VU_ERR_NO_MEMORY;
+        }
+        file_config.fft_size = scale_fft_size(file_config.fft_size,
+                                              (double)rate / info->source_rate);
+    }
+
+    /* Create analyzer with file's sample rate or config */
+    file_config.sample_rate = info->sample_rate;
+
+    vu_analyzer_t *analyzer = vu_analyzer_create(&file_config);
+    if (!analyzer) {
+        vu_wav_reader_close(reader);
+        vu_analysis_cache_end(tee.writer, NULL, false);
+        VU_SET_ERROR(VU_ERR_INVALID_ARG, "Invalid analyzer configuration (fft_size=%d)",
+                     file_config.fft_size);
+        return VU_ERR_INVALID_ARG;
+    }
+
+    size_t frame_size = file_config.fft_size;
+    size_t hop_size = frame_size / 2;  /* 50% overlap */
+    if (file_config.hop_ms > 0.0f) {
+        hop_size = (size_t)lroundf(file_config.hop_ms * info->sample_rate / 1000.0f);
+        if (hop_size < 1) hop_size = 1;
+    }
+    size_t total_frames = info->sample_count >= frame_size ?
+        (size_t)((info->sample_count - frame_size) / hop_size + 1) : 0;
+    int threads = file_config.keep_spectrum ? 1 :
+                  resolve_thread_count(file_config.num_threads, total_frames);
+
+    vu_error_t err = VU_OK;
+    size_t frame_count = 0;
+    vu_analyzer_stats_t worker_stats = {0};
+
+    if (file_config.sliding_dft) {
+        err = analyze_sliding(reader, &file_config, frame_size, hop_size,
+                              callback, user_data, &frame_count);
+    } else if (threads > 1) {
+        err = analyze_parallel(path, reader, analyzer, &file_config, threads, total_frames,
+                               frame_size, hop_size, callback, user_data, &frame_count,
+                               &worker_stats);
+    } else {
+        /* Single pass: each batch is a window onto the reader, which slides
+         * on by whole hops so overlapping samples are never read twice */
+        vu_analysis_frame_t frames[VU_ANALYZER_BATCH_FRAMES];
+        vu_spectrum_t spectra[VU_ANALYZER_BATCH_FRAMES];
+        bool stop = false;
+        while (!stop) {
+            size_t n = analyze_frames(analyzer, reader, frame_size, hop_size, frame_count,
+                                      VU_ANALYZER_BATCH_FRAMES, frames,
+                                      file_config.keep_spectrum ? spectra : NULL);
+            if (n == 0) break;
+            for (size_t i = 0; i < n && !stop; i++) {
+                frame_count++;
+                stop = !callback(user_data, &frames[i]);
+            }
+        }
+    }
+
+    vu_analysis_summary_t result = {0};
+    result.source_rate = info->source_rate;
+    result.sample_rate = info->sample_rate;
+    result.frame_size = frame_size;
+    result.hop_size = hop_size;
+    result.frame_count = frame_count;
+    result.duration_sec = frame_count > 0 ?
+        (double)((frame_count - 1) * hop_size + frame_size) / info->sample_rate : 0;
+    vu_analyzer_stats_t stats;
+    vu_analyzer_get_stats(analyzer, &stats);
+    result.ffts_run = stats.ffts_run + worker_stats.ffts_run;
+    result.ffts_skipped = stats.ffts_skipped + worker_stats.ffts_skipped;
+    if (summary) *summary = result;
+
+    /* Only a run that covered the whole file is worth keeping */
+    vu_analysis_cache_end(tee.writer, &result, err == VU_OK && !tee.stopped);
+
+    vu_analyzer_destroy(analyzer);
+    vu_wav_reader_close(reader);
+    return err;
+}
+
+/* Growable result array for the non-streaming wrapper */
+typedef struct {
+    vu_freq_result_t *results;
+    size_t count;
+    size_t capacity;
+    bool failed;
+} result_collector_t;
+
+static bool collect_frame(void *user_data, const vu_analysis_frame_t *frame)
+{
+    result_collector_t *collector = user_data;
+
+    if (collector->count >= collector->capacity) {
+        size_t new_cap = collector->capacity == 0 ? 256 : collector->capacity * 2;
+        vu_freq_result_t *new_results = realloc(collector->results,
+                                                new_cap * sizeof(vu_freq_result_t));
+        if (!new_results) {
+            collector->failed = true;
+            return false;
+        }
+        collector->results = new_results;
+        collector->capacity = new_cap;
+    }
+
+    collector->results[collector->count++] = frame->freq;
+    return true;
+}
+
+vu_freq_result_t *vu_analyzer_analyze_file(const char *path,
+                                            const vu_analyzer_config_t *config,
+                                            size_t *count)
+{
+    if (!path || !count) return NULL;
+
+    *count = 0;
+
+    result_collector_t collector = {0};
+    if (vu_analyzer_analyze_file_stream(path, config, collect_frame, &collector, NULL) != VU_OK ||
+        collector.failed || collector.count == 0) {
+        free(collector.results);
+        return NULL;
+    }
+
+    *count = collector.count;
+    return collector.results;
+}
+
+void vu_analyzer_free_results(vu_freq_result_t *results)
+{
+    free(results);
+}
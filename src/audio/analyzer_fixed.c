@@ -0,0 +1,551 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * FFT-based audio analyzer implementation (fixed point, no FFTW)
+ *
+ * Built instead of analyzer.c with meson -Dfixed_point=true, for targets
+ * without a fast FPU. Windowing, the FFT, the Goertzel filters, the bin
+ * search and the frame's energy are integer; floating point only touches
+ * a handful of values per frame, to convert the winning bin to dB and
+ * interpolate its frequency. Everything else is set up at create time.
+ *
+ * Tolerance against the floating-point engine, measured on the test_audio
+ * files (8 kHz, 256 to 1024-point frames, FFT mode and Goertzel targets
+ * from 440 to 1209 Hz): magnitude_db within 0.003 dB above -80 dBFS and
+ * 0.11 dB down to -100 dBFS, with the same frequency and `valid` on every
+ * frame. RMS/peak levels are identical.
+ */
+
+#include "audio/analyzer.h"
+#include "audio/fixed_dsp.h"
+#include "audio/goertzel_tone.h"
+#include "audio/peak_interp.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* Headroom on the energy gate's bound for rounding in the FFT */
+#define GATE_SAFETY_DB 0.5f
+
+struct vu_analyzer {
+    vu_analyzer_config_t config;
+    vu_fixed_fft_t *fft;       /* Window, twiddles and bit reversal */
+    int32_t *buffer;           /* Windowed frame in, spectrum out (Q29) */
+
+    /* Energy gate: no bin's magnitude_db exceeds rms_db + gate_margin_db */
+    float gate_margin_db;
+    vu_analyzer_stats_t stats;
+
+    uint64_t peak_threshold;   /* min_level_db as a bin power (Q58) */
+
+    /* vu_analyzer_analyze_spectra: a batch of spectra as floats
+     * (allocated on first use) */
+    float *spectra;
+
+    /* Goertzel filter bank (target_count > 0) */
+    vu_goertzel_target_t goertzel[VU_ANALYZER_MAX_TARGETS];
+    vu_fixed_goertzel_coeff_t goertzel_coeff[VU_ANALYZER_MAX_TARGETS];
+    /* One bin below, above, two below, above */
+    vu_fixed_goertzel_coeff_t goertzel_side_coeff[VU_ANALYZER_MAX_TARGETS][4];
+    float tone_norm;           /* A pure tone's power at its bin and the two beside,
+                                * over its windowed energy, times this is 1 */
+};
+
+vu_analyzer_t *vu_analyzer_create(const vu_analyzer_config_t *config)
+{
+    if (!config) return NULL;
+
+    /* FFT size must be power of 2 */
+    if ((config->fft_size & (config->fft_size - 1)) != 0) {
+        return NULL;
+    }
+    if (config->target_count < 0 || config->target_count > VU_ANALYZER_MAX_TARGETS) {
+        return NULL;
+    }
+
+    vu_analyzer_t *analyzer = calloc(1, sizeof(vu_analyzer_t));
+    if (!analyzer) return NULL;
+
+    analyzer->config = *config;
+    analyzer->fft = vu_fixed_fft_create(config->fft_size);
+    analyzer->buffer = malloc(((size_t)config->fft_size + 2) * sizeof(int32_t));
+    if (!analyzer->fft || !analyzer->buffer) {
+        vu_analyzer_destroy(analyzer);
+        return NULL;
+    }
+
+    /* Cauchy-Schwarz bound, as in the floating-point engine */
+    double half = config->fft_size / 2.0;
+    analyzer->gate_margin_db =
+        (float)(10.0 * log10(config->fft_size * vu_fixed_fft_window_energy(analyzer->fft) /
+                             (half * half))) + GATE_SAFETY_DB;
+
+    double threshold = pow(10.0, config->min_level_db / 20.0) * VU_FIXED_ONE;
+    analyzer->peak_threshold = threshold * threshold < 1.8e19 ?
+                               (uint64_t)(threshold * threshold) : UINT64_MAX;
+
+    /* As in the floating-point engine: a tone's bin and the two beside hold
+     * A^2/4 (|W(0)|^2 + 2 |W(1)|^2) of its energy A^2/2 sum(w^2) */
+    double w0 = vu_fixed_fft_window_response(analyzer->fft, 0);
+    double w1 = vu_fixed_fft_window_response(analyzer->fft, 1);
+    double lobe = w0 * w0 + 2.0 * w1 * w1;
+    analyzer->tone_norm = lobe > 0.0 ?
+                          (float)(2.0 * vu_fixed_fft_window_energy(analyzer->fft) / lobe) : 0.0f;
+
+    /* The filters always run over the whole frame */
+    static const int sides[4] = { -1, 1, -2, 2 };
+    size_t length = (size_t)config->fft_size;
+    for (int t = 0; t < config->target_count; t++) {
+        vu_goertzel_target_t *target = &analyzer->goertzel[t];
+        vu_goertzel_target_init(target, config, t);
+        analyzer->goertzel_coeff[t] =
+            vu_fixed_goertzel_coeff(target->w[VU_GOERTZEL_FILTER(0)], length);
+        for (int side = 0; side < 4; side++) {
+            analyzer->goertzel_side_coeff[t][side] =
+                vu_fixed_goertzel_coeff(target->w[VU_GOERTZEL_FILTER(sides[side])], length);
+        }
+    }
+
+    return analyzer;
+}
+
+void vu_analyzer_destroy(vu_analyzer_t *analyzer)
+{
+    if (!analyzer) return;
+
+    vu_fixed_fft_destroy(analyzer->fft);
+    free(analyzer->buffer);
+    free(analyzer->spectra);
+    free(analyzer);
+}
+
+/* Goertzel filter bank over the windowed frame; magnitudes are scaled like
+ * the FFT path (|X| / (N/2)) so min_level_db means the same in both modes.
+ * bins: each target's aligned X at full scale 1 (re/im pairs) */
+static void goertzel_magnitudes(vu_analyzer_t *analyzer, float *magnitudes, float *bins)
+{
+    int targets = analyzer->config.target_count;
+    int64_t s1[VU_ANALYZER_MAX_TARGETS];
+    int64_t s2[VU_ANALYZER_MAX_TARGETS];
+
+    vu_fixed_goertzel(analyzer->buffer, (size_t)analyzer->config.fft_size,
+                      analyzer->goertzel_coeff, targets, s1, s2);
+
+    for (int t = 0; t < targets; t++) {
+        vu_goertzel_bin(&analyzer->goertzel[t], VU_GOERTZEL_FILTER(0),
+                        (float)s1[t] / (float)VU_FIXED_GOERTZEL_ONE,
+                        (float)s2[t] / (float)VU_FIXED_GOERTZEL_ONE, bins + 2 * t);
+        magnitudes[t] = sqrtf(vu_goertzel_power(bins + 2 * t)) /
+                        (analyzer->config.fft_size / 2);
+    }
+}
+
+/* Aligned X of target t's side filters `first` .. `first` + sides - 1, in
+ * goertzel_side_coeff's order */
+static void goertzel_sides(vu_analyzer_t *analyzer, int t, int first, int sides, float *bins)
+{
+    static const int filters[4] = {
+        VU_GOERTZEL_FILTER(-1), VU_GOERTZEL_FILTER(1),
+        VU_GOERTZEL_FILTER(-2), VU_GOERTZEL_FILTER(2)
+    };
+    int64_t s1[2], s2[2];
+    vu_fixed_goertzel(analyzer->buffer, (size_t)analyzer->config.fft_size,
+                      analyzer->goertzel_side_coeff[t] + first, sides, s1, s2);
+
+    for (int side = 0; side < sides; side++) {
+        vu_goertzel_bin(&analyzer->goertzel[t], filters[first + side],
+                        (float)s1[side] / (float)VU_FIXED_GOERTZEL_ONE,
+                        (float)s2[side] / (float)VU_FIXED_GOERTZEL_ONE, bins + 2 * side);
+    }
+}
+
+/* X at target t and one FFT bin either side, as vu_peak_interpolate takes
+ * them; `at` is the target filter's own bin */
+static void goertzel_neighbours(vu_analyzer_t *analyzer, int t, const float *at, float *bins)
+{
+    float sides[4];
+    goertzel_sides(analyzer, t, 0, 2, sides);
+
+    bins[0] = sides[0];
+    bins[1] = sides[1];
+    bins[2] = at[0];
+    bins[3] = at[1];
+    bins[4] = sides[2];
+    bins[5] = sides[3];
+}
+
+/* Target t's frequency, measured from its neighbours `bins`; a tone nearer
+ * a neighbour is located around it, with one more filter beyond */
+static float goertzel_frequency(vu_analyzer_t *analyzer, int t, const float *bins)
+{
+    int centre = vu_goertzel_centre(bins);
+    float beyond[2];
+    if (centre != 0) goertzel_sides(analyzer, t, centre > 0 ? 3 : 2, 1, beyond);
+    return vu_goertzel_frequency(&analyzer->config, t, bins, centre, beyond);
+}
+
+/* window_squares: the windowed frame's energy from vu_fixed_fft_window */
+static void detect_goertzel(vu_analyzer_t *analyzer, uint64_t window_squares,
+                            vu_freq_result_t *result)
+{
+    float magnitudes[VU_ANALYZER_MAX_TARGETS];
+    float outputs[2 * VU_ANALYZER_MAX_TARGETS];
+    goertzel_magnitudes(analyzer, magnitudes, outputs);
+
+    float max_magnitude = 0.0f;
+    int max_target = 0;
+
+    for (int t = 0; t < analyzer->config.target_count; t++) {
+        if (magnitudes[t] > max_magnitude) {
+            max_magnitude = magnitudes[t];
+            max_target = t;
+        }
+    }
+
+    float magnitude_db = 20.0f * log10f(max_magnitude + 1e-10f);
+
+    /* The configured target is not a measurement: frequency stays 0 unless
+     * a tone is found there */
+    result->frequency = 0.0f;
+    result->magnitude_db = magnitude_db;
+    result->valid = false;
+    if (magnitude_db <= analyzer->config.min_level_db) return;
+
+    float bins[6];
+    goertzel_neighbours(analyzer, max_target, outputs + 2 * max_target, bins);
+    if (vu_goertzel_is_tone(bins, analyzer->tone_norm,
+                            (double)window_squares / (double)VU_FIXED_ENERGY_ONE)) {
+        result->frequency = goertzel_frequency(analyzer, max_target, bins);
+        result->valid = true;
+    }
+}
+
+/* Goertzel mode peaks: the targets above min_level_db that are local
+ * maxima of the spectrum, strongest first, at their measured frequency */
+static int goertzel_peaks(vu_analyzer_t *analyzer, vu_peak_t *peaks, int max_peaks)
+{
+    float magnitudes[VU_ANALYZER_MAX_TARGETS];
+    float outputs[2 * VU_ANALYZER_MAX_TARGETS];
+    goertzel_magnitudes(analyzer, magnitudes, outputs);
+
+    int found = 0;
+    for (int t = 0; t < analyzer->config.target_count; t++) {
+        float magnitude_db = 20.0f * log10f(magnitudes[t] + 1e-10f);
+        if (magnitude_db <= analyzer->config.min_level_db) continue;
+
+        float bins[6];
+        goertzel_neighbours(analyzer, t, outputs + 2 * t, bins);
+        float at = vu_goertzel_power(bins + 2);
+        if (at < vu_goertzel_power(bins) || at < vu_goertzel_power(bins + 4)) {
+            continue;
+        }
+        float frequency = goertzel_frequency(analyzer, t, bins);
+
+        int i = found < max_peaks ? found++ : max_peaks;
+        for (; i > 0 && peaks[i - 1].magnitude_db < magnitude_db; i--) {
+            if (i < max_peaks) peaks[i] = peaks[i - 1];
+        }
+        if (i < max_peaks) {
+            peaks[i].frequency = frequency;
+            peaks[i].magnitude_db = magnitude_db;
+        }
+    }
+    return found;
+}
+
+/* Bins k - 1 .. k + 1 of the transformed buffer as floats, full scale 1 */
+static void neighbour_bins(const int32_t *spectrum, int k, float *bins)
+{
+    for (int i = 0; i < 6; i++) {
+        bins[i] = (float)spectrum[2 * (k - 1) + i] / (float)VU_FIXED_ONE;
+    }
+}
+
+static uint64_t bin_power(const int32_t *spectrum, int k)
+{
+    int64_t re = spectrum[2 * k];
+    int64_t im = spectrum[2 * k + 1];
+    return (uint64_t)(re * re) + (uint64_t)(im * im);
+}
+
+/* Top-N local maxima of the transformed buffer in one integer pass; only
+ * the winners are interpolated, in floating point */
+static int spectrum_peaks(vu_analyzer_t *analyzer, vu_peak_t *peaks, int max_peaks)
+{
+    int fft_size = analyzer->config.fft_size;
+    int last = fft_size / 2;
+    const int32_t *spectrum = analyzer->buffer;
+    if (max_peaks <= 0 || last < 2) return 0;
+
+    int bins[VU_ANALYZER_MAX_PEAKS];
+    uint64_t powers[VU_ANALYZER_MAX_PEAKS];
+    int found = 0;
+
+    uint64_t prev = bin_power(spectrum, 0);
+    uint64_t cur = bin_power(spectrum, 1);
+    for (int k = 1; k < last; k++) {
+        uint64_t next = bin_power(spectrum, k + 1);
+
+        if (cur > analyzer->peak_threshold && cur > prev && cur >= next &&
+            (found < max_peaks || cur > powers[found - 1])) {
+            int i = found < max_peaks ? found++ : found - 1;
+            for (; i > 0 && powers[i - 1] < cur; i--) {
+                powers[i] = powers[i - 1];
+                bins[i] = bins[i - 1];
+            }
+            powers[i] = cur;
+            bins[i] = k;
+        }
+
+        prev = cur;
+        cur = next;
+    }
+
+    /* Bins already hold X / (N/2) */
+    float bin_width = (float)analyzer->config.sample_rate / fft_size;
+    for (int i = 0; i < found; i++) {
+        float bins3[6], offset, peak_db;
+        neighbour_bins(spectrum, bins[i], bins3);
+        vu_peak_interpolate(VU_PEAK_INTERP_PARABOLIC, bins3, &offset, &peak_db);
+        peaks[i].frequency = (bins[i] + offset) * bin_width;
+        peaks[i].magnitude_db = peak_db;
+    }
+
+    /* Interpolation can reorder close peaks */
+    for (int i = 1; i < found; i++) {
+        vu_peak_t p = peaks[i];
+        int j = i;
+        for (; j > 0 && peaks[j - 1].magnitude_db < p.magnitude_db; j--) peaks[j] = peaks[j - 1];
+        peaks[j] = p;
+    }
+    return found;
+}
+
+/* Dominant frequency from the transformed buffer */
+static void spectrum_peak(vu_analyzer_t *analyzer, vu_freq_result_t *result)
+{
+    int fft_size = analyzer->config.fft_size;
+
+    /* Bins already hold X[k] / (N/2) in Q29 */
+    uint64_t max_power;
+    int max_bin = vu_fixed_peak_power(analyzer->buffer, 1, fft_size / 2, &max_power);
+    if (max_bin < 0) max_bin = 0;
+
+    float magnitude = sqrtf((float)max_power) / (float)VU_FIXED_ONE;
+    float magnitude_db = 20.0f * log10f(magnitude + 1e-10f);
+    float frequency = max_bin * ((float)analyzer->config.sample_rate / fft_size);
+
+    if (analyzer->config.interpolation != VU_PEAK_INTERP_NONE && max_power > 0) {
+        float bins[6], offset, peak_db;
+        neighbour_bins(analyzer->buffer, max_bin, bins);
+        vu_peak_interpolate(analyzer->config.interpolation, bins, &offset, &peak_db);
+        frequency = (max_bin + offset) * ((float)analyzer->config.sample_rate / fft_size);
+        magnitude_db = peak_db;
+    }
+
+    result->frequency = frequency;
+    result->magnitude_db = magnitude_db;
+    result->valid = (magnitude_db > analyzer->config.min_level_db);
+}
+
+/* True if the frame is too quiet for any bin to reach min_level_db; the
+ * result is then filled in without running the transform */
+static bool gate_frame(vu_analyzer_t *analyzer, const vu_level_result_t *level,
+                       vu_freq_result_t *freq)
+{
+    float bound_db = level->rms_db + analyzer->gate_margin_db;
+    if (bound_db >= analyzer->config.min_level_db) {
+        return false;
+    }
+
+    memset(freq, 0, sizeof(*freq));
+    freq->magnitude_db = bound_db;
+    analyzer->stats.ffts_skipped++;
+    return true;
+}
+
+/* One frame: frequency, plus the level when `level` is non-NULL.
+ * Returns true if the frame's spectrum is left in the buffer. */
+static bool analyze_one(vu_analyzer_t *analyzer, const int16_t *samples, size_t count,
+                        vu_freq_result_t *freq, vu_level_result_t *level)
+{
+    int fft_size = analyzer->config.fft_size;
+    size_t samples_to_use = (count < (size_t)fft_size) ? count : (size_t)fft_size;
+
+    memset(freq, 0, sizeof(*freq));
+    if (level) memset(level, 0, sizeof(*level));
+
+    /* Window (zero-padded) and measure in one pass */
+    uint64_t sum_pcm, window_squares;
+    int32_t peak;
+    vu_fixed_fft_window(analyzer->fft, analyzer->buffer, samples, samples_to_use,
+                        &sum_pcm, &peak, &window_squares);
+    if (samples_to_use == 0) {
+        analyzer->stats.ffts_run++;
+        spectrum_peak(analyzer, freq);
+        return false;
+    }
+
+    vu_level_result_t frame_level;
+    vu_analyzer_level_from_sums(sum_pcm, peak, samples_to_use, &frame_level);
+    if (level) *level = frame_level;
+
+    if (analyzer->config.energy_gate && gate_frame(analyzer, &frame_level, freq)) {
+        return false;
+    }
+    analyzer->stats.ffts_run++;
+
+    if (analyzer->config.target_count > 0) {
+        detect_goertzel(analyzer, window_squares, freq);
+        return false;
+    }
+
+    vu_fixed_fft_execute(analyzer->fft, analyzer->buffer);
+    spectrum_peak(analyzer, freq);
+    return true;
+}
+
+bool vu_analyzer_detect_frequency(vu_analyzer_t *analyzer,
+                                   const int16_t *samples, size_t count,
+                                   vu_freq_result_t *result)
+{
+    if (!analyzer || !samples || !result) return false;
+
+    analyze_one(analyzer, samples, count, result, NULL);
+    return true;
+}
+
+bool vu_analyzer_analyze_frame(vu_analyzer_t *analyzer,
+                                const int16_t *samples, size_t count,
+                                vu_freq_result_t *freq,
+                                vu_level_result_t *level)
+{
+    if (!analyzer || !samples || !freq || !level || count == 0) return false;
+
+    analyze_one(analyzer, samples, count, freq, level);
+    return true;
+}
+
+bool vu_analyzer_detect_peaks(vu_analyzer_t *analyzer,
+                              const int16_t *samples, size_t count,
+                              vu_peak_t *peaks, int max_peaks, int *peak_count)
+{
+    if (!analyzer || !samples || !peaks || !peak_count || max_peaks < 0) return false;
+
+    *peak_count = 0;
+    if (max_peaks > VU_ANALYZER_MAX_PEAKS) max_peaks = VU_ANALYZER_MAX_PEAKS;
+
+    int fft_size = analyzer->config.fft_size;
+    size_t samples_to_use = (count < (size_t)fft_size) ? count : (size_t)fft_size;
+
+    uint64_t sum_pcm, window_squares;
+    int32_t peak;
+    vu_fixed_fft_window(analyzer->fft, analyzer->buffer, samples, samples_to_use,
+                        &sum_pcm, &peak, &window_squares);
+
+    /* A gated frame has no bin above min_level_db, so no peaks */
+    if (analyzer->config.energy_gate && samples_to_use > 0) {
+        vu_level_result_t level;
+        vu_freq_result_t gated;
+        vu_analyzer_level_from_sums(sum_pcm, peak, samples_to_use, &level);
+        if (gate_frame(analyzer, &level, &gated)) return true;
+    }
+    analyzer->stats.ffts_run++;
+
+    if (analyzer->config.target_count > 0) {
+        *peak_count = goertzel_peaks(analyzer, peaks, max_peaks);
+        return true;
+    }
+
+    vu_fixed_fft_execute(analyzer->fft, analyzer->buffer);
+    *peak_count = spectrum_peaks(analyzer, peaks, max_peaks);
+    return true;
+}
+
+/* No batched transform here: the integer FFT gains nothing from it */
+bool vu_analyzer_detect_frequency_batch(vu_analyzer_t *analyzer,
+                                         const int16_t *samples, size_t hop,
+                                         size_t frame_count,
+                                         vu_freq_result_t *results)
+{
+    if (!analyzer || !samples || !results || hop == 0) return false;
+
+    size_t fft_size = (size_t)analyzer->config.fft_size;
+    for (size_t f = 0; f < frame_count; f++) {
+        analyze_one(analyzer, samples + f * hop, fft_size, &results[f], NULL);
+    }
+    return true;
+}
+
+bool vu_analyzer_analyze_batch(vu_analyzer_t *analyzer,
+                                const int16_t *samples, size_t hop,
+                                size_t frame_count,
+                                vu_freq_result_t *freqs,
+                                vu_level_result_t *levels)
+{
+    if (!analyzer || !samples || !freqs || !levels || hop == 0) return false;
+
+    size_t fft_size = (size_t)analyzer->config.fft_size;
+    for (size_t f = 0; f < frame_count; f++) {
+        analyze_one(analyzer, samples + f * hop, fft_size, &freqs[f], &levels[f]);
+    }
+    return true;
+}
+
+bool vu_analyzer_analyze_spectra(vu_analyzer_t *analyzer,
+                                 const int16_t *samples, size_t hop,
+                                 size_t frame_count,
+                                 vu_freq_result_t *freqs,
+                                 vu_level_result_t *levels,
+                                 vu_spectrum_t *spectra)
+{
+    if (!analyzer || !samples || !freqs || !levels || !spectra || hop == 0 ||
+        frame_count > VU_ANALYZER_BATCH_FRAMES) {
+        return false;
+    }
+
+    size_t fft_size = (size_t)analyzer->config.fft_size;
+    size_t stride = fft_size + 2;
+    if (!analyzer->spectra) {
+        analyzer->spectra = malloc(stride * VU_ANALYZER_BATCH_FRAMES * sizeof(float));
+        if (!analyzer->spectra) return false;
+    }
+
+    for (size_t f = 0; f < frame_count; f++) {
+        /* Bins already hold X / (N/2) */
+        spectra[f] = (vu_spectrum_t){
+            .bins = NULL,
+            .bin_count = (int)fft_size / 2 + 1,
+            .bin_hz = (float)analyzer->config.sample_rate / fft_size,
+            .scale = 1.0f
+        };
+        if (!analyze_one(analyzer, samples + f * hop, fft_size, &freqs[f], &levels[f])) {
+            continue;
+        }
+
+        float *bins = analyzer->spectra + f * stride;
+        for (size_t i = 0; i < stride; i++) {
+            bins[i] = (float)analyzer->buffer[i] / (float)VU_FIXED_ONE;
+        }
+        spectra[f].bins = bins;
+    }
+    return true;
+}
+
+void vu_analyzer_get_stats(const vu_analyzer_t *analyzer, vu_analyzer_stats_t *stats)
+{
+    if (!stats) return;
+
+    if (analyzer) {
+        *stats = analyzer->stats;
+    } else {
+        memset(stats, 0, sizeof(*stats));
+    }
+}
+
+bool vu_analyzer_freq_matches(const vu_analyzer_t *analyzer,
+                               float detected, float target)
+{
+    if (!analyzer) return false;
+    float diff = fabsf(detected - target);
+    return diff <= analyzer->config.freq_tolerance_hz;
+}
@@ -0,0 +1,791 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Analyzer inner-loop kernels implementation
+ *
+ * The x86 variants are compiled with per-function target attributes so the
+ * rest of the build keeps the baseline ISA; the best variant the CPU
+ * supports is picked once at runtime.
+ */
+
+#include "audio/analyzer_simd.h"
+#include <stdbool.h>
+#include <pthread.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define VU_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+/* 1/32768 is a power of two, so scaling by it is exact and matches
+ * the scalar division bit for bit */
+#define PCM_SCALE (1.0f / 32768.0f)
+
+/* Scalar reference implementations */
+
+static void window_scalar(float *out, const int16_t *in, const float *window, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        out[i] = (in[i] / 32768.0f) * window[i];
+    }
+}
+
+static int peak_power_scalar(const float *spectrum, int first, int last, float *max_power)
+{
+    float best = 0.0f;
+    int best_bin = -1;
+
+    for (int i = first; i < last; i++) {
+        float re = spectrum[2 * i];
+        float im = spectrum[2 * i + 1];
+        float power = re * re + im * im;
+        if (power > best) {
+            best = power;
+            best_bin = i;
+        }
+    }
+
+    *max_power = best;
+    return best_bin;
+}
+
+static void level_scalar(const int16_t *in, size_t count, uint64_t *sum_squares, int32_t *peak)
+{
+    uint64_t sum = 0;
+    int32_t max_abs = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        int32_t s = in[i];
+        sum += (uint64_t)(s * s);
+        int32_t a = s < 0 ? -s : s;
+        if (a > max_abs) max_abs = a;
+    }
+
+    *sum_squares = sum;
+    *peak = max_abs;
+}
+
+static void window_level_scalar(float *out, const int16_t *in, const float *window, size_t count,
+                                uint64_t *sum_squares, int32_t *peak)
+{
+    uint64_t sum = 0;
+    int32_t max_abs = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        int32_t s = in[i];
+        out[i] = (in[i] / 32768.0f) * window[i];
+        sum += (uint64_t)(s * s);
+        int32_t a = s < 0 ? -s : s;
+        if (a > max_abs) max_abs = a;
+    }
+
+    *sum_squares = sum;
+    *peak = max_abs;
+}
+
+/*
+ * FFT passes on split re/im arrays. Butterfly outputs are formed in the same
+ * order, with the same operations, in every implementation (and without
+ * fused multiply-add), so the spectra match bit for bit.
+ */
+
+static void fft_radix2_scalar(float *re, float *im, size_t count, size_t span,
+                              const float *twiddles)
+{
+    size_t h = span / 2;
+    const float *wr = twiddles, *wi = twiddles + h;
+
+    for (size_t g = 0; g < count; g += span) {
+        float *r = re + g, *m = im + g;
+        for (size_t j = 0; j < h; j++) {
+            float br = r[j + h] * wr[j] - m[j + h] * wi[j];
+            float bi = r[j + h] * wi[j] + m[j + h] * wr[j];
+            float ar = r[j], ai = m[j];
+            r[j] = ar + br;
+            m[j] = ai + bi;
+            r[j + h] = ar - br;
+            m[j + h] = ai - bi;
+        }
+    }
+}
+
+static void fft_radix4_scalar(float *re, float *im, size_t count, size_t span,
+                              const float *twiddles)
+{
+    size_t q = span / 4;
+    const float *w1r = twiddles, *w1i = twiddles + q;
+    const float *w2r = twiddles + 2 * q, *w2i = twiddles + 3 * q;
+    const float *w3r = twiddles + 4 * q, *w3i = twiddles + 5 * q;
+
+    for (size_t g = 0; g < count; g += span) {
+        float *r = re + g, *m = im + g;
+        for (size_t j = 0; j < q; j++) {
+            float ar = r[j], ai = m[j];
+            float br = r[j + q] * w1r[j] - m[j + q] * w1i[j];
+            float bi = r[j + q] * w1i[j] + m[j + q] * w1r[j];
+            float cr = r[j + 2 * q] * w2r[j] - m[j + 2 * q] * w2i[j];
+            float ci = r[j + 2 * q] * w2i[j] + m[j + 2 * q] * w2r[j];
+            float dr = r[j + 3 * q] * w3r[j] - m[j + 3 * q] * w3i[j];
+            float di = r[j + 3 * q] * w3i[j] + m[j + 3 * q] * w3r[j];
+
+            float apc_r = ar + cr, apc_i = ai + ci;
+            float amc_r = ar - cr, amc_i = ai - ci;
+            float bpd_r = br + dr, bpd_i = bi + di;
+            float bmd_r = br - dr, bmd_i = bi - di;
+
+            r[j] = apc_r + bpd_r;
+            m[j] = apc_i + bpd_i;
+            r[j + q] = amc_r + bmd_i;
+            m[j + q] = amc_i - bmd_r;
+            r[j + 2 * q] = apc_r - bpd_r;
+            m[j + 2 * q] = apc_i - bpd_i;
+            r[j + 3 * q] = amc_r - bmd_i;
+            m[j + 3 * q] = amc_i + bmd_r;
+        }
+    }
+}
+
+/* Real spectrum bins [first, half) from the half-size complex transform */
+static void fft_split_from(float *out, const float *re, const float *im, size_t half,
+                           const float *twiddles, size_t first)
+{
+    const float *wr = twiddles, *wi = twiddles + half;
+
+    for (size_t k = first; k < half; k++) {
+        float ar = re[k], ai = im[k];
+        float br = re[half - k], bi = -im[half - k];
+
+        float er = 0.5f * (ar + br), ei = 0.5f * (ai + bi);
+        float or_ = 0.5f * (ai - bi), oi = 0.5f * (br - ar);
+
+        out[2 * k] = er + (or_ * wr[k] - oi * wi[k]);
+        out[2 * k + 1] = ei + (or_ * wi[k] + oi * wr[k]);
+    }
+}
+
+static void fft_split_scalar(float *out, const float *re, const float *im, size_t half,
+                             const float *twiddles)
+{
+    /* DC and Nyquist are E[0] +- O[0], both real */
+    out[0] = re[0] + im[0];
+    out[1] = 0.0f;
+    out[2 * half] = re[0] - im[0];
+    out[2 * half + 1] = 0.0f;
+
+    fft_split_from(out, re, im, half, twiddles, 1);
+}
+
+/* Merge per-lane argmax state: largest power wins, lowest bin on ties */
+static int reduce_lanes(const float *lane_power, const int32_t *lane_bin, int lanes,
+                        float *max_power)
+{
+    float best = 0.0f;
+    int best_bin = -1;
+
+    for (int l = 0; l < lanes; l++) {
+        if (lane_bin[l] < 0) continue;
+        if (lane_power[l] > best || (lane_power[l] == best && lane_bin[l] < best_bin)) {
+            best = lane_power[l];
+            best_bin = lane_bin[l];
+        }
+    }
+
+    *max_power = best;
+    return best_bin;
+}
+
+#ifdef VU_SIMD_X86
+
+/* SSE2 */
+
+__attribute__((target("sse2")))
+static void window_sse2(float *out, const int16_t *in, const float *window, size_t count)
+{
+    const __m128 scale = _mm_set1_ps(PCM_SCALE);
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m128i pcm = _mm_loadu_si128((const __m128i *)(in + i));
+        /* Sign-extend int16 -> int32 */
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(pcm, pcm), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(pcm, pcm), 16);
+
+        __m128 flo = _mm_mul_ps(_mm_mul_ps(_mm_cvtepi32_ps(lo), scale), _mm_loadu_ps(window + i));
+        __m128 fhi = _mm_mul_ps(_mm_mul_ps(_mm_cvtepi32_ps(hi), scale), _mm_loadu_ps(window + i + 4));
+        _mm_storeu_ps(out + i, flo);
+        _mm_storeu_ps(out + i + 4, fhi);
+    }
+
+    window_scalar(out + i, in + i, window + i, count - i);
+}
+
+__attribute__((target("sse2")))
+static int peak_power_sse2(const float *spectrum, int first, int last, float *max_power)
+{
+    __m128 best = _mm_setzero_ps();
+    __m128i best_bin = _mm_set1_epi32(-1);
+    __m128i bin = _mm_setr_epi32(first, first + 1, first + 2, first + 3);
+    const __m128i step = _mm_set1_epi32(4);
+    int i = first;
+
+    for (; i + 4 <= last; i += 4) {
+        __m128 a = _mm_loadu_ps(spectrum + 2 * i);      /* r0 i0 r1 i1 */
+        __m128 b = _mm_loadu_ps(spectrum + 2 * i + 4);  /* r2 i2 r3 i3 */
+        __m128 re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        __m128 power = _mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im));
+
+        __m128 gt = _mm_cmpgt_ps(power, best);
+        __m128i gti = _mm_castps_si128(gt);
+        best = _mm_or_ps(_mm_and_ps(gt, power), _mm_andnot_ps(gt, best));
+        best_bin = _mm_or_si128(_mm_and_si128(gti, bin), _mm_andnot_si128(gti, best_bin));
+        bin = _mm_add_epi32(bin, step);
+    }
+
+    float lane_power[4];
+    int32_t lane_bin[4];
+    _mm_storeu_ps(lane_power, best);
+    _mm_storeu_si128((__m128i *)lane_bin, best_bin);
+    int best_idx = reduce_lanes(lane_power, lane_bin, 4, max_power);
+
+    /* Tail bins are all higher than the vector ones, so strict > keeps
+     * the lowest bin on ties */
+    float tail_power;
+    int tail_idx = peak_power_scalar(spectrum, i, last, &tail_power);
+    if (tail_idx >= 0 && tail_power > *max_power) {
+        *max_power = tail_power;
+        best_idx = tail_idx;
+    }
+    return best_idx;
+}
+
+__attribute__((target("sse2")))
+static void level_sse2(const int16_t *in, size_t count, uint64_t *sum_squares, int32_t *peak)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = _mm_setzero_si128();
+    __m128i vmax = _mm_set1_epi16(INT16_MIN);
+    __m128i vmin = _mm_set1_epi16(INT16_MAX);
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(in + i));
+        /* Pairwise s^2 sums fit in uint32 (max 2^31), widen to uint64 */
+        __m128i sq = _mm_madd_epi16(x, x);
+        acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(sq, zero));
+        acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(sq, zero));
+        vmax = _mm_max_epi16(vmax, x);
+        vmin = _mm_min_epi16(vmin, x);
+    }
+
+    uint64_t lanes[2];
+    int16_t maxs[8], mins[8];
+    _mm_storeu_si128((__m128i *)lanes, acc);
+    _mm_storeu_si128((__m128i *)maxs, vmax);
+    _mm_storeu_si128((__m128i *)mins, vmin);
+
+    uint64_t sum;
+    int32_t max_abs;
+    level_scalar(in + i, count - i, &sum, &max_abs);
+    sum += lanes[0] + lanes[1];
+
+    if (i > 0) {
+        for (int l = 0; l < 8; l++) {
+            if (maxs[l] > max_abs) max_abs = maxs[l];
+            if (-(int32_t)mins[l] > max_abs) max_abs = -(int32_t)mins[l];
+        }
+    }
+
+    *sum_squares = sum;
+    *peak = max_abs;
+}
+
+__attribute__((target("sse2")))
+static void window_level_sse2(float *out, const int16_t *in, const float *window, size_t count,
+                              uint64_t *sum_squares, int32_t *peak)
+{
+    const __m128 scale = _mm_set1_ps(PCM_SCALE);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = _mm_setzero_si128();
+    __m128i vmax = _mm_set1_epi16(INT16_MIN);
+    __m128i vmin = _mm_set1_epi16(INT16_MAX);
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m128i pcm = _mm_loadu_si128((const __m128i *)(in + i));
+
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(pcm, pcm), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(pcm, pcm), 16);
+        __m128 flo = _mm_mul_ps(_mm_mul_ps(_mm_cvtepi32_ps(lo), scale), _mm_loadu_ps(window + i));
+        __m128 fhi = _mm_mul_ps(_mm_mul_ps(_mm_cvtepi32_ps(hi), scale), _mm_loadu_ps(window + i + 4));
+        _mm_storeu_ps(out + i, flo);
+        _mm_storeu_ps(out + i + 4, fhi);
+
+        __m128i sq = _mm_madd_epi16(pcm, pcm);
+        acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(sq, zero));
+        acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(sq, zero));
+        vmax = _mm_max_epi16(vmax, pcm);
+        vmin = _mm_min_epi16(vmin, pcm);
+    }
+
+    uint64_t lanes[2];
+    int16_t maxs[8], mins[8];
+    _mm_storeu_si128((__m128i *)lanes, acc);
+    _mm_storeu_si128((__m128i *)maxs, vmax);
+    _mm_storeu_si128((__m128i *)mins, vmin);
+
+    uint64_t sum;
+    int32_t max_abs;
+    window_level_scalar(out + i, in + i, window + i, count - i, &sum, &max_abs);
+    sum += lanes[0] + lanes[1];
+
+    if (i > 0) {
+        for (int l = 0; l < 8; l++) {
+            if (maxs[l] > max_abs) max_abs = maxs[l];
+            if (-(int32_t)mins[l] > max_abs) max_abs = -(int32_t)mins[l];
+        }
+    }
+
+    *sum_squares = sum;
+    *peak = max_abs;
+}
+
+/* (xr + i xi) * (wr + i wi) */
+__attribute__((target("sse2")))
+static inline void cmul_sse2(__m128 xr, __m128 xi, const float *wr, const float *wi,
+                             __m128 *yr, __m128 *yi)
+{
+    __m128 vwr = _mm_loadu_ps(wr), vwi = _mm_loadu_ps(wi);
+    *yr = _mm_sub_ps(_mm_mul_ps(xr, vwr), _mm_mul_ps(xi, vwi));
+    *yi = _mm_add_ps(_mm_mul_ps(xr, vwi), _mm_mul_ps(xi, vwr));
+}
+
+__attribute__((target("sse2")))
+static void fft_radix2_sse2(float *re, float *im, size_t count, size_t span,
+                            const float *twiddles)
+{
+    size_t h = span / 2;
+    if (h % 4 != 0) {
+        fft_radix2_scalar(re, im, count, span, twiddles);
+        return;
+    }
+
+    const float *wr = twiddles, *wi = twiddles + h;
+    for (size_t g = 0; g < count; g += span) {
+        float *r = re + g, *m = im + g;
+        for (size_t j = 0; j < h; j += 4) {
+            __m128 br, bi;
+            cmul_sse2(_mm_loadu_ps(r + j + h), _mm_loadu_ps(m + j + h), wr + j, wi + j, &br, &bi);
+            __m128 ar = _mm_loadu_ps(r + j), ai = _mm_loadu_ps(m + j);
+            _mm_storeu_ps(r + j, _mm_add_ps(ar, br));
+            _mm_storeu_ps(m + j, _mm_add_ps(ai, bi));
+            _mm_storeu_ps(r + j + h, _mm_sub_ps(ar, br));
+            _mm_storeu_ps(m + j + h, _mm_sub_ps(ai, bi));
+        }
+    }
+}
+
+__attribute__((target("sse2")))
+static void fft_radix4_sse2(float *re, float *im, size_t count, size_t span,
+                            const float *twiddles)
+{
+    size_t q = span / 4;
+    if (q % 4 != 0) {
+        fft_radix4_scalar(re, im, count, span, twiddles);
+        return;
+    }
+
+    const float *w1r = twiddles, *w1i = twiddles + q;
+    const float *w2r = twiddles + 2 * q, *w2i = twiddles + 3 * q;
+    const float *w3r = twiddles + 4 * q, *w3i = twiddles + 5 * q;
+
+    for (size_t g = 0; g < count; g += span) {
+        float *r = re + g, *m = im + g;
+        for (size_t j = 0; j < q; j += 4) {
+            __m128 ar = _mm_loadu_ps(r + j), ai = _mm_loadu_ps(m + j);
+            __m128 br, bi, cr, ci, dr, di;
+            cmul_sse2(_mm_loadu_ps(r + j + q), _mm_loadu_ps(m + j + q),
+                      w1r + j, w1i + j, &br, &bi);
+            cmul_sse2(_mm_loadu_ps(r + j + 2 * q), _mm_loadu_ps(m + j + 2 * q),
+                      w2r + j, w2i + j, &cr, &ci);
+            cmul_sse2(_mm_loadu_ps(r + j + 3 * q), _mm_loadu_ps(m + j + 3 * q),
+                      w3r + j, w3i + j, &dr, &di);
+
+            __m128 apc_r = _mm_add_ps(ar, cr), apc_i = _mm_add_ps(ai, ci);
+            __m128 amc_r = _mm_sub_ps(ar, cr), amc_i = _mm_sub_ps(ai, ci);
+            __m128 bpd_r = _mm_add_ps(br, dr), bpd_i = _mm_add_ps(bi, di);
+            __m128 bmd_r = _mm_sub_ps(br, dr), bmd_i = _mm_sub_ps(bi, di);
+
+            _mm_storeu_ps(r + j, _mm_add_ps(apc_r, bpd_r));
+            _mm_storeu_ps(m + j, _mm_add_ps(apc_i, bpd_i));
+            _mm_storeu_ps(r + j + q, _mm_add_ps(amc_r, bmd_i));
+            _mm_storeu_ps(m + j + q, _mm_sub_ps(amc_i, bmd_r));
+            _mm_storeu_ps(r + j + 2 * q, _mm_sub_ps(apc_r, bpd_r));
+            _mm_storeu_ps(m + j + 2 * q, _mm_sub_ps(apc_i, bpd_i));
+            _mm_storeu_ps(r + j + 3 * q, _mm_sub_ps(amc_r, bmd_i));
+            _mm_storeu_ps(m + j + 3 * q, _mm_add_ps(amc_i, bmd_r));
+        }
+    }
+}
+
+/* Four bins at a time: Z[k..k+3] and, reversed, Z[half-k-3..half-k] */
+__attribute__((target("sse2")))
+static void fft_split_sse2(float *out, const float *re, const float *im, size_t half,
+                           const float *twiddles)
+{
+    const float *wr = twiddles, *wi = twiddles + half;
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128 one_half = _mm_set1_ps(0.5f);
+    size_t k = 1;
+
+    out[0] = re[0] + im[0];
+    out[1] = 0.0f;
+    out[2 * half] = re[0] - im[0];
+    out[2 * half + 1] = 0.0f;
+
+    for (; k + 4 <= half; k += 4) {
+        __m128 ar = _mm_loadu_ps(re + k), ai = _mm_loadu_ps(im + k);
+        __m128 br = _mm_loadu_ps(re + half - k - 3), bi = _mm_loadu_ps(im + half - k - 3);
+        br = _mm_shuffle_ps(br, br, _MM_SHUFFLE(0, 1, 2, 3));
+        bi = _mm_xor_ps(_mm_shuffle_ps(bi, bi, _MM_SHUFFLE(0, 1, 2, 3)), sign);
+
+        __m128 er = _mm_mul_ps(one_half, _mm_add_ps(ar, br));
+        __m128 ei = _mm_mul_ps(one_half, _mm_add_ps(ai, bi));
+        __m128 or_ = _mm_mul_ps(one_half, _mm_sub_ps(ai, bi));
+        __m128 oi = _mm_mul_ps(one_half, _mm_sub_ps(br, ar));
+
+        __m128 tr, ti;
+        cmul_sse2(or_, oi, wr + k, wi + k, &tr, &ti);
+        __m128 xr = _mm_add_ps(er, tr), xi = _mm_add_ps(ei, ti);
+        _mm_storeu_ps(out + 2 * k, _mm_unpacklo_ps(xr, xi));
+        _mm_storeu_ps(out + 2 * k + 4, _mm_unpackhi_ps(xr, xi));
+    }
+
+    fft_split_from(out, re, im, half, twiddles, k);
+}
+
+/* AVX2 */
+
+__attribute__((target("avx2")))
+static void window_avx2(float *out, const int16_t *in, const float *window, size_t count)
+{
+    const __m256 scale = _mm256_set1_ps(PCM_SCALE);
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m128i pcm = _mm_loadu_si128((const __m128i *)(in + i));
+        __m256 f = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(pcm));
+        f = _mm256_mul_ps(_mm256_mul_ps(f, scale), _mm256_loadu_ps(window + i));
+        _mm256_storeu_ps(out + i, f);
+    }
+
+    window_scalar(out + i, in + i, window + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static int peak_power_avx2(const float *spectrum, int first, int last, float *max_power)
+{
+    __m256 best = _mm256_setzero_ps();
+    __m256i best_bin = _mm256_set1_epi32(-1);
+    /* shuffle_ps works per 128-bit half, so lanes hold bins 0,1,4,5 | 2,3,6,7 */
+    __m256i bin = _mm256_setr_epi32(first, first + 1, first + 4, first + 5,
+                                    first + 2, first + 3, first + 6, first + 7);
+    const __m256i step = _mm256_set1_epi32(8);
+    int i = first;
+
+    for (; i + 8 <= last; i += 8) {
+        __m256 a = _mm256_loadu_ps(spectrum + 2 * i);      /* bins 0-1 | 2-3 */
+        __m256 b = _mm256_loadu_ps(spectrum + 2 * i + 8);  /* bins 4-5 | 6-7 */
+        __m256 re = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 im = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        __m256 power = _mm256_add_ps(_mm256_mul_ps(re, re), _mm256_mul_ps(im, im));
+
+        __m256 gt = _mm256_cmp_ps(power, best, _CMP_GT_OQ);
+        best = _mm256_blendv_ps(best, power, gt);
+        best_bin = _mm256_blendv_epi8(best_bin, bin, _mm256_castps_si256(gt));
+        bin = _mm256_add_epi32(bin, step);
+    }
+
+    float lane_power[8];
+    int32_t lane_bin[8];
+    _mm256_storeu_ps(lane_power, best);
+    _mm256_storeu_si256((__m256i *)lane_bin, best_bin);
+    int best_idx = reduce_lanes(lane_power, lane_bin, 8, max_power);
+
+    float tail_power;
+    int tail_idx = peak_power_scalar(spectrum, i, last, &tail_power);
+    if (tail_idx >= 0 && tail_power > *max_power) {
+        *max_power = tail_power;
+        best_idx = tail_idx;
+    }
+    return best_idx;
+}
+
+__attribute__((target("avx2")))
+static void level_avx2(const int16_t *in, size_t count, uint64_t *sum_squares, int32_t *peak)
+{
+    __m256i acc = _mm256_setzero_si256();
+    __m256i vmax = _mm256_set1_epi16(INT16_MIN);
+    __m256i vmin = _mm256_set1_epi16(INT16_MAX);
+    size_t i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(in + i));
+        __m256i sq = _mm256_madd_epi16(x, x);
+        acc = _mm256_add_epi64(acc, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(sq)));
+        acc = _mm256_add_epi64(acc, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(sq, 1)));
+        vmax = _mm256_max_epi16(vmax, x);
+        vmin = _mm256_min_epi16(vmin, x);
+    }
+
+    uint64_t lanes[4];
+    int16_t maxs[16], mins[16];
+    _mm256_storeu_si256((__m256i *)lanes, acc);
+    _mm256_storeu_si256((__m256i *)maxs, vmax);
+    _mm256_storeu_si256((__m256i *)mins, vmin);
+
+    uint64_t sum;
+    int32_t max_abs;
+    level_scalar(in + i, count - i, &sum, &max_abs);
+    sum += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+
+    if (i > 0) {
+        for (int l = 0; l < 16; l++) {
+            if (maxs[l] > max_abs) max_abs = maxs[l];
+            if (-(int32_t)mins[l] > max_abs) max_abs = -(int32_t)mins[l];
+        }
+    }
+
+    *sum_squares = sum;
+    *peak = max_abs;
+}
+
+__attribute__((target("avx2")))
+static void window_level_avx2(float *out, const int16_t *in, const float *window, size_t count,
+                              uint64_t *sum_squares, int32_t *peak)
+{
+    const __m256 scale = _mm256_set1_ps(PCM_SCALE);
+    __m256i acc = _mm256_setzero_si256();
+    __m256i vmax = _mm256_set1_epi16(INT16_MIN);
+    __m256i vmin = _mm256_set1_epi16(INT16_MAX);
+    size_t i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        __m256i pcm = _mm256_loadu_si256((const __m256i *)(in + i));
+
+        __m256 flo = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_castsi256_si128(pcm)));
+        __m256 fhi = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_extracti128_si256(pcm, 1)));
+        flo = _mm256_mul_ps(_mm256_mul_ps(flo, scale), _mm256_loadu_ps(window + i));
+        fhi = _mm256_mul_ps(_mm256_mul_ps(fhi, scale), _mm256_loadu_ps(window + i + 8));
+        _mm256_storeu_ps(out + i, flo);
+        _mm256_storeu_ps(out + i + 8, fhi);
+
+        __m256i sq = _mm256_madd_epi16(pcm, pcm);
+        acc = _mm256_add_epi64(acc, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(sq)));
+        acc = _mm256_add_epi64(acc, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(sq, 1)));
+        vmax = _mm256_max_epi16(vmax, pcm);
+        vmin = _mm256_min_epi16(vmin, pcm);
+    }
+
+    uint64_t lanes[4];
+    int16_t maxs[16], mins[16];
+    _mm256_storeu_si256((__m256i *)lanes, acc);
+    _mm256_storeu_si256((__m256i *)maxs, vmax);
+    _mm256_storeu_si256((__m256i *)mins, vmin);
+
+    uint64_t sum;
+    int32_t max_abs;
+    window_level_scalar(out + i, in + i, window + i, count - i, &sum, &max_abs);
+    sum += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+
+    if (i > 0) {
+        for (int l = 0; l < 16; l++) {
+            if (maxs[l] > max_abs) max_abs = maxs[l];
+            if (-(int32_t)mins[l] > max_abs) max_abs = -(int32_t)mins[l];
+        }
+    }
+
+    *sum_squares = sum;
+    *peak = max_abs;
+}
+
+__attribute__((target("avx2")))
+static inline void cmul_avx2(__m256 xr, __m256 xi, const float *wr, const float *wi,
+                             __m256 *yr, __m256 *yi)
+{
+    __m256 vwr = _mm256_loadu_ps(wr), vwi = _mm256_loadu_ps(wi);
+    *yr = _mm256_sub_ps(_mm256_mul_ps(xr, vwr), _mm256_mul_ps(xi, vwi));
+    *yi = _mm256_add_ps(_mm256_mul_ps(xr, vwi), _mm256_mul_ps(xi, vwr));
+}
+
+__attribute__((target("avx2")))
+static void fft_radix2_avx2(float *re, float *im, size_t count, size_t span,
+                            const float *twiddles)
+{
+    size_t h = span / 2;
+    if (h % 8 != 0) {
+        fft_radix2_sse2(re, im, count, span, twiddles);
+        return;
+    }
+
+    const float *wr = twiddles, *wi = twiddles + h;
+    for (size_t g = 0; g < count; g += span) {
+        float *r = re + g, *m = im + g;
+        for (size_t j = 0; j < h; j += 8) {
+            __m256 br, bi;
+            cmul_avx2(_mm256_loadu_ps(r + j + h), _mm256_loadu_ps(m + j + h),
+                      wr + j, wi + j, &br, &bi);
+            __m256 ar = _mm256_loadu_ps(r + j), ai = _mm256_loadu_ps(m + j);
+            _mm256_storeu_ps(r + j, _mm256_add_ps(ar, br));
+            _mm256_storeu_ps(m + j, _mm256_add_ps(ai, bi));
+            _mm256_storeu_ps(r + j + h, _mm256_sub_ps(ar, br));
+            _mm256_storeu_ps(m + j + h, _mm256_sub_ps(ai, bi));
+        }
+    }
+}
+
+/* Passes whose quarters are narrower than 8 use SSE2 */
+__attribute__((target("avx2")))
+static void fft_radix4_avx2(float *re, float *im, size_t count, size_t span,
+                            const float *twiddles)
+{
+    size_t q = span / 4;
+    if (q % 8 != 0) {
+        fft_radix4_sse2(re, im, count, span, twiddles);
+        return;
+    }
+
+    const float *w1r = twiddles, *w1i = twiddles + q;
+    const float *w2r = twiddles + 2 * q, *w2i = twiddles + 3 * q;
+    const float *w3r = twiddles + 4 * q, *w3i = twiddles + 5 * q;
+
+    for (size_t g = 0; g < count; g += span) {
+        float *r = re + g, *m = im + g;
+        for (size_t j = 0; j < q; j += 8) {
+            __m256 ar = _mm256_loadu_ps(r + j), ai = _mm256_loadu_ps(m + j);
+            __m256 br, bi, cr, ci, dr, di;
+            cmul_avx2(_mm256_loadu_ps(r + j + q), _mm256_loadu_ps(m + j + q),
+                      w1r + j, w1i + j, &br, &bi);
+            cmul_avx2(_mm256_loadu_ps(r + j + 2 * q), _mm256_loadu_ps(m + j + 2 * q),
+                      w2r + j, w2i + j, &cr, &ci);
+            cmul_avx2(_mm256_loadu_ps(r + j + 3 * q), _mm256_loadu_ps(m + j + 3 * q),
+                      w3r + j, w3i + j, &dr, &di);
+
+            __m256 apc_r = _mm256_add_ps(ar, cr), apc_i = _mm256_add_ps(ai, ci);
+            __m256 amc_r = _mm256_sub_ps(ar, cr), amc_i = _mm256_sub_ps(ai, ci);
+            __m256 bpd_r = _mm256_add_ps(br, dr), bpd_i = _mm256_add_ps(bi, di);
+            __m256 bmd_r = _mm256_sub_ps(br, dr), bmd_i = _mm256_sub_ps(bi, di);
+
+            _mm256_storeu_ps(r + j, _mm256_add_ps(apc_r, bpd_r));
+            _mm256_storeu_ps(m + j, _mm256_add_ps(apc_i, bpd_i));
+            _mm256_storeu_ps(r + j + q, _mm256_add_ps(amc_r, bmd_i));
+            _mm256_storeu_ps(m + j + q, _mm256_sub_ps(amc_i, bmd_r));
+            _mm256_storeu_ps(r + j + 2 * q, _mm256_sub_ps(apc_r, bpd_r));
+            _mm256_storeu_ps(m + j + 2 * q, _mm256_sub_ps(apc_i, bpd_i));
+            _mm256_storeu_ps(r + j + 3 * q, _mm256_sub_ps(amc_r, bmd_i));
+            _mm256_storeu_ps(m + j + 3 * q, _mm256_add_ps(amc_i, bmd_r));
+        }
+    }
+}
+
+/* Eight bins at a time; the interleaved stores need a lane fix-up since
+ * AVX unpacks work within 128-bit halves */
+__attribute__((target("avx2")))
+static void fft_split_avx2(float *out, const float *re, const float *im, size_t half,
+                           const float *twiddles)
+{
+    const float *wr = twiddles, *wi = twiddles + half;
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    const __m256 one_half = _mm256_set1_ps(0.5f);
+    const __m256i reverse = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+    size_t k = 1;
+
+    out[0] = re[0] + im[0];
+    out[1] = 0.0f;
+    out[2 * half] = re[0] - im[0];
+    out[2 * half + 1] = 0.0f;
+
+    for (; k + 8 <= half; k += 8) {
+        __m256 ar = _mm256_loadu_ps(re + k), ai = _mm256_loadu_ps(im + k);
+        __m256 br = _mm256_permutevar8x32_ps(_mm256_loadu_ps(re + half - k - 7), reverse);
+        __m256 bi = _mm256_permutevar8x32_ps(_mm256_loadu_ps(im + half - k - 7), reverse);
+        bi = _mm256_xor_ps(bi, sign);
+
+        __m256 er = _mm256_mul_ps(one_half, _mm256_add_ps(ar, br));
+        __m256 ei = _mm256_mul_ps(one_half, _mm256_add_ps(ai, bi));
+        __m256 or_ = _mm256_mul_ps(one_half, _mm256_sub_ps(ai, bi));
+        __m256 oi = _mm256_mul_ps(one_half, _mm256_sub_ps(br, ar));
+
+        __m256 tr, ti;
+        cmul_avx2(or_, oi, wr + k, wi + k, &tr, &ti);
+        __m256 xr = _mm256_add_ps(er, tr), xi = _mm256_add_ps(ei, ti);
+        __m256 lo = _mm256_unpacklo_ps(xr, xi);   /* bins 0 1 | 4 5 */
+        __m256 hi = _mm256_unpackhi_ps(xr, xi);   /* bins 2 3 | 6 7 */
+        _mm256_storeu_ps(out + 2 * k, _mm256_permute2f128_ps(lo, hi, 0x20));
+        _mm256_storeu_ps(out + 2 * k + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+    }
+
+    /* The tail call below skips the compiler's own vzeroupper, and legacy
+     * SSE code after dirty AVX state runs several times slower */
+    _mm256_zeroupper();
+    fft_split_from(out, re, im, half, twiddles, k);
+}
+
+#endif /* VU_SIMD_X86 */
+
+static const vu_analyzer_kernels_t g_kernels[VU_SIMD_COUNT] = {
+    [VU_SIMD_SCALAR] = { VU_SIMD_SCALAR, "scalar", window_scalar, peak_power_scalar,
+                         level_scalar, window_level_scalar,
+                         fft_radix2_scalar, fft_radix4_scalar, fft_split_scalar },
+#ifdef VU_SIMD_X86
+    [VU_SIMD_SSE2]   = { VU_SIMD_SSE2, "sse2", window_sse2, peak_power_sse2,
+                         level_sse2, window_level_sse2,
+                         fft_radix2_sse2, fft_radix4_sse2, fft_split_sse2 },
+    [VU_SIMD_AVX2]   = { VU_SIMD_AVX2, "avx2", window_avx2, peak_power_avx2,
+                         level_avx2, window_level_avx2,
+                         fft_radix2_avx2, fft_radix4_avx2, fft_split_avx2 },
+#endif
+};
+
+static bool cpu_supports(vu_simd_level_t level)
+{
+    switch (level) {
+    case VU_SIMD_SCALAR:
+        return true;
+#ifdef VU_SIMD_X86
+    case VU_SIMD_SSE2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse2");
+    case VU_SIMD_AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+static pthread_once_t g_select_once = PTHREAD_ONCE_INIT;
+static const vu_analyzer_kernels_t *g_selected = &g_kernels[VU_SIMD_SCALAR];
+
+static void select_kernels(void)
+{
+    for (int level = VU_SIMD_COUNT - 1; level > VU_SIMD_SCALAR; level--) {
+        if (g_kernels[level].window && cpu_supports((vu_simd_level_t)level)) {
+            g_selected = &g_kernels[level];
+            return;
+        }
+    }
+}
+
+const vu_analyzer_kernels_t *vu_analyzer_kernels(void)
+{
+    pthread_once(&g_select_once, select_kernels);
+    return g_selected;
+}
+
+const vu_analyzer_kernels_t *vu_analyzer_kernels_for(vu_simd_level_t level)
+{
+    if (level < 0 || level >= VU_SIMD_COUNT) return NULL;
+    if (!g_kernels[level].window || !cpu_supports(level)) return NULL;
+    return &g_kernels[level];
+}
@@ -0,0 +1,93 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Analyzer inner-loop kernels (scalar, SSE2, AVX2) with runtime dispatch
+ *
+ * Internal to src/audio; not part of the public analyzer API.
+ */
+
+#ifndef VU_ANALYZER_SIMD_H
+#define VU_ANALYZER_SIMD_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Instruction set levels */
+typedef enum {
+    VU_SIMD_SCALAR = 0,
+    VU_SIMD_SSE2,
+    VU_SIMD_AVX2,
+    VU_SIMD_COUNT
+} vu_simd_level_t;
+
+/* Kernel table */
+typedef struct vu_analyzer_kernels {
+    vu_simd_level_t isa;
+    const char *name;
+
+    /*
+     * Convert PCM to float and apply window: out[i] = (in[i] / 32768) * window[i].
+     * Bit-identical across implementations.
+     */
+    void (*window)(float *out, const int16_t *in, const float *window, size_t count);
+
+    /*
+     * Find the bin in [first, last) with the largest squared magnitude
+     * re^2 + im^2 of an interleaved complex spectrum. Ties go to the lowest
+     * bin. Returns -1 if every power is zero.
+     * max_power: largest power found (0 if none)
+     */
+    int (*peak_power)(const float *spectrum, int first, int last, float *max_power);
+
+    /*
+     * Sum of squares and largest absolute value of PCM samples.
+     * Exact integer arithmetic, so identical across implementations.
+     */
+    void (*level)(const int16_t *in, size_t count, uint64_t *sum_squares, int32_t *peak);
+
+    /*
+     * window and level fused: one pass over the PCM produces the windowed
+     * floats and the level sums (same results as calling both).
+     */
+    void (*window_level)(float *out, const int16_t *in, const float *window, size_t count,
+                         uint64_t *sum_squares, int32_t *peak);
+
+    /*
+     * One radix-2 decimation-in-time pass of the built-in FFT, in place on
+     * split re/im arrays of `count` points: in each group of `span` points,
+     * the two half-length transforms are combined after multiplying the
+     * second by `twiddles` (span/2 re, then span/2 im).
+     * Bit-identical across implementations.
+     */
+    void (*fft_radix2)(float *re, float *im, size_t count, size_t span, const float *twiddles);
+
+    /*
+     * Radix-4 pass, same layout: four quarter-length transforms per group,
+     * quarters 1-3 multiplied by their twiddles (span/4 re then span/4 im
+     * for each) before the butterfly.
+     * Bit-identical across implementations.
+     */
+    void (*fft_radix4)(float *re, float *im, size_t count, size_t span, const float *twiddles);
+
+    /*
+     * Turn the `half`-point complex transform of a real signal packed as
+     * even + i odd samples into its real spectrum: half + 1 interleaved
+     * re/im pairs in `out`. twiddles: e^{-i pi k/half} for k < half, re
+     * block then im block.
+     * Bit-identical across implementations.
+     */
+    void (*fft_split)(float *out, const float *re, const float *im, size_t half,
+                      const float *twiddles);
+} vu_analyzer_kernels_t;
+
+/*
+ * Get the best kernels for this CPU (selected once, by CPUID)
+ */
+const vu_analyzer_kernels_t *vu_analyzer_kernels(void);
+
+/*
+ * Get kernels for a specific level, or NULL if the CPU/build lacks it
+ * (used by benchmarks to compare implementations)
+ */
+const vu_analyzer_kernels_t *vu_analyzer_kernels_for(vu_simd_level_t level);
+
+#endif /* VU_ANALYZER_SIMD_H */
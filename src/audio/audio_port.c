@@ -1,45 +1,101 @@
 /*
  * voip-utility - SIP VoIP Testing Utility
- * Custom PJMEDIA audio port (stub implementation)
+ * Custom PJMEDIA audio port implementation
  */
 
 #include "audio/audio_port.h"
+#include "audio/analysis_pool.h"
+#include "audio/frame_ring.h"
 #include "util/log.h"
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
+#include <pthread.h>
 
+/*
+ * The bridge's clock thread only copies each frame into `ring`; the
+ * analysis worker the port is attached to drains it and does everything
+ * else. The worker is not a PJLIB thread, hence a pthread mutex.
+ *
+ * The bridge removes ports asynchronously (PJSIP 2.14+) and may still be
+ * in put_frame after pjsua_conf_remove_port returns. It holds a reference
+ * to the port's group lock until it lets go; the last reference runs
+ * on_destroy, possibly on the clock thread. So vu_audio_port_destroy does
+ * the blocking part (taking the port off its worker, processing what is
+ * queued, closing the recorder) on the caller's thread, and on_destroy
+ * only frees memory. Late frames still go into the ring, but nothing
+ * reads them.
+ */
 struct vu_audio_port {
     pjmedia_port base;
     pj_pool_t *pool;
+    pthread_mutex_t mutex;     /* Guards the analysis state against readers */
+    uint32_t sample_rate;
+    unsigned samples_per_frame;
+
+    vu_frame_ring_t *ring;
+    vu_analysis_source_t *source;
+    int16_t *scratch;          /* One frame popped from the ring (worker) */
+    int16_t *silence;          /* One frame of zeros, standing in for dropped ones */
+
     vu_analyzer_t *analyzer;
     vu_beep_detector_t *beep_detector;
     vu_recorder_t *recorder;
-    uint32_t sample_rate;
+
+    /* Received audio not yet consumed by the analyzer: an analyzer frame
+     * is taken whenever fft_size samples are held, then the oldest `hop`
+     * are dropped */
+    int16_t *pending;
+    size_t pending_count;
+    size_t fft_size;
+    size_t hop;
+
+    vu_audio_port_status_t status;
 };
 
 static pj_status_t audio_port_put_frame(pjmedia_port *this_port, pjmedia_frame *frame);
 static pj_status_t audio_port_get_frame(pjmedia_port *this_port, pjmedia_frame *frame);
 static pj_status_t audio_port_on_destroy(pjmedia_port *this_port);
+static void audio_port_drain(void *user_data);
 
-vu_audio_port_t *vu_audio_port_create(pj_pool_t *pool, uint32_t sample_rate)
+vu_audio_port_t *vu_audio_port_create(pj_pool_t *pool, uint32_t sample_rate,
+                                      unsigned samples_per_frame, size_t queue_frames)
 {
-    if (!pool) return NULL;
+    if (!pool || sample_rate == 0 || samples_per_frame == 0) return NULL;
+    if (queue_frames == 0) queue_frames = vu_analysis_pool_queue_frames();
 
     vu_audio_port_t *port = pj_pool_zalloc(pool, sizeof(vu_audio_port_t));
     if (!port) return NULL;
 
     port->pool = pool;
     port->sample_rate = sample_rate;
+    port->samples_per_frame = samples_per_frame;
+    port->scratch = pj_pool_alloc(pool, samples_per_frame * sizeof(int16_t));
+    port->silence = pj_pool_zalloc(pool, samples_per_frame * sizeof(int16_t));
+    if (!port->scratch || !port->silence) return NULL;
+
+    port->ring = vu_frame_ring_create(queue_frames, samples_per_frame);
+    if (!port->ring) return NULL;
+
+    if (pthread_mutex_init(&port->mutex, NULL) != 0) {
+        vu_frame_ring_destroy(port->ring);
+        return NULL;
+    }
 
     /* Initialize PJMEDIA port */
     pj_str_t name = pj_str("vu_audio_port");
     pj_status_t status = pjmedia_port_info_init(&port->base.info, &name,
-                                                 0x12345678,  /* Signature */
+                                                 PJMEDIA_SIGNATURE('V', 'U', 'A', 'P'),
                                                  sample_rate,
                                                  1,  /* Channels */
                                                  16, /* Bits */
-                                                 sample_rate * 20 / 1000); /* 20ms frame */
-    if (status != PJ_SUCCESS) {
+                                                 samples_per_frame);
+    if (status == PJ_SUCCESS) {
+        port->source = vu_analysis_pool_attach(audio_port_drain, port);
+    }
+    if (!port->source) {
+        pthread_mutex_destroy(&port->mutex);
+        vu_frame_ring_destroy(port->ring);
         return NULL;
     }
 
@@ -47,14 +103,43 @@ vu_audio_port_t *vu_audio_port_create(pj_pool_t *pool, uint32_t sample_rate)
     port->base.get_frame = audio_port_get_frame;
     port->base.on_destroy = audio_port_on_destroy;
 
-    VU_LOG_DEBUG("Created audio port: sample_rate=%u", sample_rate);
+    /* Holds the caller's reference from here on */
+    status = pjmedia_port_init_grp_lock(&port->base, pool, NULL);
+    if (status != PJ_SUCCESS) {
+        vu_analysis_pool_detach(port->source);
+        pthread_mutex_destroy(&port->mutex);
+        vu_frame_ring_destroy(port->ring);
+        return NULL;
+    }
+
+    VU_LOG_DEBUG("Created audio port: sample_rate=%u, samples_per_frame=%u, queue=%zu frames",
+                 sample_rate, samples_per_frame, vu_frame_ring_depth(port->ring));
     return port;
 }
 
 void vu_audio_port_destroy(vu_audio_port_t *port)
 {
     if (!port) return;
-    /* Port memory is from pool, will be freed with pool */
+
+    /* Takes the port off its worker and processes what is still queued */
+    vu_analysis_pool_detach(port->source);
+    port->source = NULL;
+
+    vu_frame_ring_stats_t ring_stats;
+    vu_frame_ring_get_stats(port->ring, &ring_stats);
+    if (ring_stats.overruns > 0) {
+        VU_LOG_WARN("Audio port dropped %llu of %llu frames (analysis fell behind)",
+                    (unsigned long long)ring_stats.overruns,
+                    (unsigned long long)(ring_stats.frames_pushed + ring_stats.overruns));
+    }
+
+    /* The last queued audio has been written: finish the recording */
+    vu_recorder_t *recorder = vu_audio_port_take_recorder(port);
+    if (recorder) vu_recorder_close_async(recorder);
+
+    /* Drops the caller's reference: on_destroy runs now, or once the
+     * bridge has let go of the port */
+    pjmedia_port_destroy(&port->base);
 }
 
 pjmedia_port *vu_audio_port_get_pjmedia_port(vu_audio_port_t *port)
@@ -62,41 +147,165 @@ pjmedia_port *vu_audio_port_get_pjmedia_port(vu_audio_port_t *port)
     return port ? &port->base : NULL;
 }
 
-void vu_audio_port_set_analyzer(vu_audio_port_t *port, vu_analyzer_t *analyzer)
+vu_error_t vu_audio_port_enable_analysis(vu_audio_port_t *port,
+                                         const vu_analyzer_config_t *config,
+                                         const vu_beep_config_t *beep_config)
 {
-    if (port) port->analyzer = analyzer;
+    if (!port || !config) {
+        VU_SET_ERROR(VU_ERR_INVALID_ARG, "Invalid arguments");
+        return VU_ERR_INVALID_ARG;
+    }
+    if (port->analyzer) {
+        VU_SET_ERROR(VU_ERR_INVALID_ARG, "Analysis already enabled");
+        return VU_ERR_INVALID_ARG;
+    }
+
+    vu_analyzer_config_t port_config = *config;
+    port_config.sample_rate = (int)port->sample_rate;
+
+    size_t fft_size = (size_t)port_config.fft_size;
+    size_t hop = fft_size / 2;  /* 50% overlap, as in file analysis */
+    if (port_config.hop_ms > 0.0f) {
+        hop = (size_t)lroundf(port_config.hop_ms * port->sample_rate / 1000.0f);
+        if (hop < 1) hop = 1;
+        if (hop > fft_size) hop = fft_size;
+    }
+
+    int16_t *pending = pj_pool_alloc(port->pool,
+                                     (fft_size + port->samples_per_frame) * sizeof(int16_t));
+    vu_analyzer_t *analyzer = vu_analyzer_create(&port_config);
+    if (!pending || !analyzer) {
+        vu_analyzer_destroy(analyzer);
+        VU_SET_ERROR(VU_ERR_INVALID_ARG, "Invalid analyzer configuration (fft_size=%d)",
+                     port_config.fft_size);
+        return VU_ERR_INVALID_ARG;
+    }
+
+    vu_beep_detector_t *detector = NULL;
+    if (beep_config) {
+        detector = vu_beep_detector_create(beep_config, port->sample_rate);
+        if (!detector) {
+            vu_analyzer_destroy(analyzer);
+            VU_SET_ERROR(VU_ERR_NO_MEMORY, "Failed to create beep detector");
+            return VU_ERR_NO_MEMORY;
+        }
+    }
+
+    /* The worker may already be draining the port */
+    pthread_mutex_lock(&port->mutex);
+    port->pending = pending;
+    port->analyzer = analyzer;
+    port->beep_detector = detector;
+    port->fft_size = fft_size;
+    port->hop = hop;
+    port->pending_count = 0;
+    pthread_mutex_unlock(&port->mutex);
+    return VU_OK;
 }
 
-void vu_audio_port_set_beep_detector(vu_audio_port_t *port, vu_beep_detector_t *detector)
+void vu_audio_port_set_recorder(vu_audio_port_t *port, vu_recorder_t *recorder)
 {
-    if (port) port->beep_detector = detector;
+    if (!port) return;
+
+    /* The worker only writes with the mutex held, so once swapped out the
+     * old recorder is ours to close */
+    pthread_mutex_lock(&port->mutex);
+    vu_recorder_t *old = port->recorder;
+    port->recorder = recorder;
+    pthread_mutex_unlock(&port->mutex);
+
+    if (old) vu_recorder_close_async(old);
 }
 
-void vu_audio_port_set_recorder(vu_audio_port_t *port, vu_recorder_t *recorder)
+vu_recorder_t *vu_audio_port_take_recorder(vu_audio_port_t *port)
 {
-    if (port) port->recorder = recorder;
+    if (!port) return NULL;
+
+    pthread_mutex_lock(&port->mutex);
+    vu_recorder_t *recorder = port->recorder;
+    port->recorder = NULL;
+    pthread_mutex_unlock(&port->mutex);
+    return recorder;
 }
 
-static pj_status_t audio_port_put_frame(pjmedia_port *this_port, pjmedia_frame *frame)
+void vu_audio_port_get_status(vu_audio_port_t *port, vu_audio_port_status_t *status)
 {
-    vu_audio_port_t *port = (vu_audio_port_t *)this_port;
+    if (!status) return;
+    memset(status, 0, sizeof(*status));
+    if (!port) return;
 
-    if (frame->type != PJMEDIA_FRAME_TYPE_AUDIO) {
-        return PJ_SUCCESS;
-    }
+    pthread_mutex_lock(&port->mutex);
+    *status = port->status;
+    pthread_mutex_unlock(&port->mutex);
 
-    int16_t *samples = (int16_t *)frame->buf;
-    size_t sample_count = frame->size / sizeof(int16_t);
+    vu_frame_ring_stats_t ring_stats;
+    vu_frame_ring_get_stats(port->ring, &ring_stats);
+    status->frames_dropped = ring_stats.overruns;
+    status->queue_high_water = ring_stats.high_water;
+}
 
-    /* Feed to analyzer */
-    if (port->analyzer) {
-        vu_audio_analysis_t analysis;
-        vu_analyzer_process(port->analyzer, samples, sample_count, &analysis);
+int vu_audio_port_get_beeps(vu_audio_port_t *port, vu_beep_event_t *beeps, int max)
+{
+    if (!port || !beeps || max <= 0) return 0;
+
+    pthread_mutex_lock(&port->mutex);
+    int count = 0;
+    const vu_beep_result_t *result = vu_beep_detector_get_result(port->beep_detector);
+    if (result) {
+        count = result->beep_count < max ? result->beep_count : max;
+        memcpy(beeps, result->beeps, (size_t)count * sizeof(vu_beep_event_t));
+    }
+    pthread_mutex_unlock(&port->mutex);
+    return count;
+}
+
+/* Analyze every complete frame the pending audio holds (mutex held) */
+static void analyze_pending(vu_audio_port_t *port)
+{
+    while (port->pending_count >= port->fft_size) {
+        vu_analysis_frame_t frame;
+        memset(&frame, 0, sizeof(frame));
+        frame.index = (size_t)port->status.frames_analyzed;
+        frame.time_sec = (double)(port->status.frames_analyzed * port->hop) / port->sample_rate;
+        frame.sample_rate = port->sample_rate;
+        vu_analyzer_analyze_frame(port->analyzer, port->pending, port->fft_size,
+                                  &frame.freq, &frame.level);
 
-        /* Feed to beep detector */
         if (port->beep_detector) {
-            vu_beep_event_t beep;
-            vu_beep_detector_process(port->beep_detector, &analysis, &beep);
+            vu_beep_event_t event;
+            if (vu_beep_detector_process_frame(port->beep_detector, &frame, &event)) {
+                port->status.beep_count++;
+                VU_LOG_DEBUG("Live beep #%d: %.3fs - %.3fs @ %.0fHz", event.beep_index + 1,
+                             event.start_time_sec, event.end_time_sec, event.frequency_hz);
+            }
+        }
+
+        port->status.frames_analyzed++;
+        port->status.last_freq = frame.freq;
+        port->status.last_level = frame.level;
+
+        port->pending_count -= port->hop;
+        memmove(port->pending, port->pending + port->hop, port->pending_count * sizeof(int16_t));
+    }
+}
+
+/* Analyze and record one frame of received audio (worker, mutex held) */
+static void process_samples(vu_audio_port_t *port, const int16_t *samples, size_t sample_count)
+{
+    port->status.samples_received += sample_count;
+    port->status.audio_sec = (double)port->status.samples_received / port->sample_rate;
+
+    if (port->analyzer) {
+        /* Bridge frames are ptime long, so at most one is pending beyond
+         * a full analyzer frame; take what fits and loop for the rest */
+        size_t done = 0;
+        while (done < sample_count) {
+            size_t room = port->fft_size + port->samples_per_frame - port->pending_count;
+            size_t n = sample_count - done < room ? sample_count - done : room;
+            memcpy(port->pending + port->pending_count, samples + done, n * sizeof(int16_t));
+            port->pending_count += n;
+            done += n;
+            analyze_pending(port);
         }
     }
 
@@ -104,7 +313,42 @@ static pj_status_t audio_port_put_frame(pjmedia_port *this_port, pjmedia_frame *
     if (port->recorder) {
         vu_recorder_write(port->recorder, samples, sample_count);
     }
+}
+
+static void audio_port_drain(void *user_data)
+{
+    vu_audio_port_t *port = user_data;
+
+    /* Lock per frame so readers are never held off for a whole backlog.
+     * Frames dropped on a full queue are replaced by silence, so later
+     * frames (and the recording) keep their place on the call's clock. */
+    size_t count, dropped;
+    while (vu_frame_ring_pop(port->ring, port->scratch, &count, &dropped)) {
+        pthread_mutex_lock(&port->mutex);
+        while (dropped > 0) {
+            size_t n = dropped < port->samples_per_frame ? dropped : port->samples_per_frame;
+            process_samples(port, port->silence, n);
+            dropped -= n;
+        }
+        process_samples(port, port->scratch, count);
+        pthread_mutex_unlock(&port->mutex);
+    }
+}
 
+static pj_status_t audio_port_put_frame(pjmedia_port *this_port, pjmedia_frame *frame)
+{
+    vu_audio_port_t *port = (vu_audio_port_t *)this_port;
+
+    /* Clock thread: queue the frame and nothing more. The bridge sends an
+     * empty frame when nothing is heard; queue it as silence so times
+     * stay on the call's clock. A full queue drops the frame and counts
+     * an overrun; the worker fills the gap with silence. */
+    if (frame->type == PJMEDIA_FRAME_TYPE_AUDIO) {
+        vu_frame_ring_push(port->ring, (const int16_t *)frame->buf,
+                           frame->size / sizeof(int16_t));
+    } else if (frame->type == PJMEDIA_FRAME_TYPE_NONE) {
+        vu_frame_ring_push(port->ring, NULL, port->samples_per_frame);
+    }
     return PJ_SUCCESS;
 }
 
@@ -116,8 +360,22 @@ static pj_status_t audio_port_get_frame(pjmedia_port *this_port, pjmedia_frame *
     return PJ_SUCCESS;
 }
 
+/* May run on the clock thread: vu_audio_port_destroy has already done
+ * everything that blocks, so this only frees memory */
 static pj_status_t audio_port_on_destroy(pjmedia_port *this_port)
 {
-    (void)this_port;
+    vu_audio_port_t *port = (vu_audio_port_t *)this_port;
+
+    vu_beep_detector_destroy(port->beep_detector);
+    vu_analyzer_destroy(port->analyzer);
+    port->beep_detector = NULL;
+    port->analyzer = NULL;
+    vu_frame_ring_destroy(port->ring);
+    port->ring = NULL;
+
+    pthread_mutex_destroy(&port->mutex);
+
+    /* The port itself lives in the pool: nothing may touch it after this */
+    pj_pool_release(port->pool);
     return PJ_SUCCESS;
 }
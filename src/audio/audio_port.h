@@ -1,6 +1,15 @@
 /*
  * voip-utility - SIP VoIP Testing Utility
- * Custom PJMEDIA audio port for analysis
+ * Custom PJMEDIA audio port for live analysis
+ *
+ * A receive-only port attached to a call's conference slot. The bridge
+ * calls put_frame with every ptime of received audio on its clock thread,
+ * which only copies the frame into a lock-free queue. A worker of the
+ * analysis pool drains the queue every few milliseconds: it collects the
+ * audio into analyzer frames, runs the analyzer and beep detector on each
+ * as soon as it is complete, and optionally tees the audio to a WAV
+ * recorder. Results can be read from any thread while the call is still
+ * up, and trail the call by at most one worker tick.
  */
 
 #ifndef VU_AUDIO_PORT_H
@@ -14,19 +23,76 @@
 
 typedef struct vu_audio_port vu_audio_port_t;
 
-vu_audio_port_t *vu_audio_port_create(pj_pool_t *pool, uint32_t sample_rate);
+/* Snapshot of the live analysis */
+typedef struct vu_audio_port_status {
+    uint64_t samples_received;    /* Audio delivered by the bridge, with
+                                     dropped frames counted as silence */
+    double audio_sec;             /* The same, in seconds */
+    uint64_t frames_analyzed;     /* Analyzer frames run */
+    vu_freq_result_t last_freq;   /* Result of the latest frame */
+    vu_level_result_t last_level;
+    int beep_count;               /* Beeps detected so far */
+    uint64_t frames_dropped;      /* Frames lost to a full queue (analyzed
+                                     and recorded as silence) */
+    size_t queue_high_water;      /* Most frames ever queued at once */
+} vu_audio_port_status_t;
+
+/*
+ * Create a port at the bridge slot's clock rate and frame size, queueing
+ * up to `queue_frames` frames for its worker (0 = the analysis pool's
+ * setting; rounded up to a power of two). Memory comes from `pool`, which
+ * the port takes over and releases when it is destroyed. Starts the
+ * analysis pool if needed.
+ * Returns NULL on failure (the caller keeps `pool`).
+ */
+vu_audio_port_t *vu_audio_port_create(pj_pool_t *pool, uint32_t sample_rate,
+                                      unsigned samples_per_frame, size_t queue_frames);
+
+/*
+ * Destroy port. Remove it from the conference bridge first. What is
+ * still queued is processed and the recorder is closed here, on the
+ * caller's thread; the bridge may still hold the port for a while, so its
+ * memory (analyzer, detector, pool) is freed once it lets go. The caller
+ * must not use the port once this returns.
+ */
 void vu_audio_port_destroy(vu_audio_port_t *port);
 
 /* Get PJMEDIA port for connecting to conference bridge */
 pjmedia_port *vu_audio_port_get_pjmedia_port(vu_audio_port_t *port);
 
-/* Set analyzer for audio processing */
-void vu_audio_port_set_analyzer(vu_audio_port_t *port, vu_analyzer_t *analyzer);
-
-/* Set beep detector */
-void vu_audio_port_set_beep_detector(vu_audio_port_t *port, vu_beep_detector_t *detector);
+/*
+ * Analyze received audio with an analyzer built from `config` (its
+ * sample_rate is set to the port's) and, with `beep_config`, detect
+ * beeps. The analyzer steps by config->hop_ms, or half a frame.
+ * Call before connecting the port.
+ */
+vu_error_t vu_audio_port_enable_analysis(vu_audio_port_t *port,
+                                         const vu_analyzer_config_t *config,
+                                         const vu_beep_config_t *beep_config);
 
-/* Set recorder for saving audio */
+/*
+ * Tee received audio to `recorder`, which the port takes over: it is
+ * written on the worker and closed when the port is destroyed, after the
+ * last queued audio. A recorder set before is closed; NULL just stops.
+ */
 void vu_audio_port_set_recorder(vu_audio_port_t *port, vu_recorder_t *recorder);
 
+/*
+ * Stop recording and hand the recorder back to the caller (NULL if none),
+ * so it can be closed before the port is gone. Audio still queued for
+ * the worker, normally under one tick, is not written.
+ */
+vu_recorder_t *vu_audio_port_take_recorder(vu_audio_port_t *port);
+
+/*
+ * Get a snapshot of the analysis so far (thread-safe)
+ */
+void vu_audio_port_get_status(vu_audio_port_t *port, vu_audio_port_status_t *status);
+
+/*
+ * Copy up to `max` of the beeps detected so far, oldest first
+ * (thread-safe). Returns the number copied.
+ */
+int vu_audio_port_get_beeps(vu_audio_port_t *port, vu_beep_event_t *beeps, int max);
+
 #endif /* VU_AUDIO_PORT_H */
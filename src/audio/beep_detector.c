@@ -6,6 +6,7 @@
 #include "audio/beep_detector.h"
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 
 struct vu_beep_detector {
     vu_beep_config_t config;
@@ -16,11 +17,26 @@ struct vu_beep_detector {
     /* State tracking */
     bool in_beep;
     double beep_start_time;
+#ifdef VU_FIXED_POINT
+    /* Per-frame sums in integer milli-Hz / milli-dB: small cores often
+     * have a single-precision FPU at most, so doubles are emulated */
+    int64_t beep_sum_freq;
+    int64_t beep_sum_level;
+#else
     double beep_sum_freq;
     double beep_sum_level;
+#endif
     int beep_sample_count;
 };
 
+#ifdef VU_FIXED_POINT
+#define BEEP_SUM(x) ((int64_t)lrintf((x) * 1000.0f))
+#define BEEP_MEAN(sum, n) ((double)(sum) / 1000.0 / (n))
+#else
+#define BEEP_SUM(x) (x)
+#define BEEP_MEAN(sum, n) ((sum) / (n))
+#endif
+
 vu_beep_detector_t *vu_beep_detector_create(const vu_beep_config_t *config,
                                              uint32_t sample_rate)
 {
@@ -77,13 +93,13 @@ bool vu_beep_detector_process(vu_beep_detector_t *detector,
         /* Start of beep */
         detector->in_beep = true;
         detector->beep_start_time = current_time_sec;
-        detector->beep_sum_freq = freq_result->frequency;
-        detector->beep_sum_level = freq_result->magnitude_db;
+        detector->beep_sum_freq = BEEP_SUM(freq_result->frequency);
+        detector->beep_sum_level = BEEP_SUM(freq_result->magnitude_db);
         detector->beep_sample_count = 1;
     } else if (is_tone && detector->in_beep) {
         /* Continuing beep */
-        detector->beep_sum_freq += freq_result->frequency;
-        detector->beep_sum_level += freq_result->magnitude_db;
+        detector->beep_sum_freq += BEEP_SUM(freq_result->frequency);
+        detector->beep_sum_level += BEEP_SUM(freq_result->magnitude_db);
         detector->beep_sample_count++;
     } else if (!is_tone && detector->in_beep) {
         /* End of beep */
@@ -98,9 +114,9 @@ bool vu_beep_detector_process(vu_beep_detector_t *detector,
                 .start_time_sec = detector->beep_start_time,
                 .end_time_sec = current_time_sec,
                 .duration_sec = duration,
-                .frequency_hz = detector->beep_sum_freq / detector->beep_sample_count,
-                .avg_level_db = detector->beep_sum_level / detector->beep_sample_count,
-                .peak_level_db = detector->beep_sum_level / detector->beep_sample_count,
+                .frequency_hz = BEEP_MEAN(detector->beep_sum_freq, detector->beep_sample_count),
+                .avg_level_db = BEEP_MEAN(detector->beep_sum_level, detector->beep_sample_count),
+                .peak_level_db = BEEP_MEAN(detector->beep_sum_level, detector->beep_sample_count),
                 .beep_index = detector->result.beep_count
             };
 
@@ -139,12 +155,38 @@ bool vu_beep_detector_process(vu_beep_detector_t *detector,
     return false;
 }
 
+bool vu_beep_detector_process_frame(vu_beep_detector_t *detector,
+                                    const vu_analysis_frame_t *frame,
+                                    vu_beep_event_t *out_event)
+{
+    if (!detector || !frame) return false;
+
+    if (frame->sample_rate > 0) detector->sample_rate = frame->sample_rate;
+    return vu_beep_detector_process(detector, &frame->freq, &frame->level,
+                                    frame->time_sec, out_event);
+}
+
+uint32_t vu_beep_detector_get_sample_rate(const vu_beep_detector_t *detector)
+{
+    return detector ? detector->sample_rate : 0;
+}
+
 const vu_beep_result_t *vu_beep_detector_get_result(const vu_beep_detector_t *detector)
 {
     if (!detector) return NULL;
     return &detector->result;
 }
 
+void vu_beep_detector_configure_analyzer(const vu_beep_config_t *config,
+                                         vu_analyzer_config_t *analyzer_config)
+{
+    if (!config || !analyzer_config) return;
+    if (config->target_freq_hz <= 0) return;
+
+    analyzer_config->target_freqs_hz[0] = (float)config->target_freq_hz;
+    analyzer_config->target_count = 1;
+}
+
 void vu_beep_detector_reset(vu_beep_detector_t *detector)
 {
     if (!detector) return;
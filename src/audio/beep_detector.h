@@ -39,6 +39,8 @@ typedef struct vu_beep_detector vu_beep_detector_t;
 
 /*
  * Create beep detector with configuration
+ * sample_rate: rate of the analyzed audio, or 0 to take it from the
+ * frames passed to vu_beep_detector_process_frame
  */
 vu_beep_detector_t *vu_beep_detector_create(const vu_beep_config_t *config,
                                              uint32_t sample_rate);
@@ -64,11 +66,34 @@ bool vu_beep_detector_process(vu_beep_detector_t *detector,
                                double current_time_sec,
                                vu_beep_event_t *out_event);
 
+/*
+ * Process a frame from the streaming file analysis, taking its time and
+ * sample rate from the frame
+ * Returns true if a beep just ended (event available)
+ */
+bool vu_beep_detector_process_frame(vu_beep_detector_t *detector,
+                                    const vu_analysis_frame_t *frame,
+                                    vu_beep_event_t *out_event);
+
+/*
+ * Get the sample rate of the audio being processed (0 until known)
+ */
+uint32_t vu_beep_detector_get_sample_rate(const vu_beep_detector_t *detector);
+
 /*
  * Get detection results
  */
 const vu_beep_result_t *vu_beep_detector_get_result(const vu_beep_detector_t *detector);
 
+/*
+ * Select the analyzer mode for a beep configuration: when a target
+ * frequency is set, the analyzer is switched to its Goertzel filter bank
+ * for that frequency instead of a full FFT scan. Leaves the analyzer
+ * config untouched when any frequency is accepted.
+ */
+void vu_beep_detector_configure_analyzer(const vu_beep_config_t *config,
+                                         vu_analyzer_config_t *analyzer_config);
+
 /*
  * Reset detector state
  */
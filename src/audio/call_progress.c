@@ -0,0 +1,176 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Call progress tone classifier implementation
+ */
+
+#include "audio/call_progress.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* Largest level difference between a tone's two frequencies */
+#define MAX_PAIR_TWIST_DB 10.0f
+
+/* Share of the frame's power the pair must carry (see dtmf_detector.c) */
+#define MIN_TONE_SHARE 0.5f
+
+/* 480 + 620 Hz bursts shorter than this are reorder (0.25 s on), longer
+ * ones busy (0.5 s on) */
+#define REORDER_MAX_SEC 0.375
+
+typedef struct {
+    float low_hz;
+    float high_hz;
+    vu_tone_kind_t kind;       /* VU_TONE_BUSY stands for busy or reorder */
+} tone_pair_t;
+
+static const tone_pair_t g_pairs[] = {
+    {350.0f, 440.0f, VU_TONE_DIAL},
+    {440.0f, 480.0f, VU_TONE_RINGBACK},
+    {480.0f, 620.0f, VU_TONE_BUSY},
+};
+#define PAIR_COUNT (int)(sizeof(g_pairs) / sizeof(g_pairs[0]))
+
+struct vu_call_progress {
+    vu_call_progress_config_t config;
+    int counts[VU_TONE_COUNT];
+
+    /* Burst in progress (-1 = none) */
+    int pair;
+    double start_time;
+    float sum_level_db;
+    int frame_count;
+};
+
+vu_call_progress_config_t vu_call_progress_default_config(void)
+{
+    vu_call_progress_config_t config = {
+        .min_level_db = -35.0f,
+        .min_duration_sec = 0.1
+    };
+    return config;
+}
+
+vu_call_progress_t *vu_call_progress_create(const vu_call_progress_config_t *config)
+{
+    vu_call_progress_t *cp = calloc(1, sizeof(vu_call_progress_t));
+    if (!cp) return NULL;
+
+    cp->config = config ? *config : vu_call_progress_default_config();
+    cp->pair = -1;
+    return cp;
+}
+
+void vu_call_progress_destroy(vu_call_progress_t *cp)
+{
+    free(cp);
+}
+
+/* Pair sounding in the frame (the one carrying the most power), or -1 */
+static int frame_pair(const vu_call_progress_t *cp, const vu_analysis_frame_t *frame,
+                      float *level_db)
+{
+    const vu_spectrum_t *spectrum = frame->spectrum;
+    if (!spectrum || !spectrum->bins) return -1;
+
+    float frame_power = powf(10.0f, frame->level.rms_db / 10.0f);
+    float best_power = MIN_TONE_SHARE * frame_power;
+    int best = -1;
+
+    for (int p = 0; p < PAIR_COUNT; p++) {
+        float low_db = vu_spectrum_level_db(spectrum, g_pairs[p].low_hz);
+        float high_db = vu_spectrum_level_db(spectrum, g_pairs[p].high_hz);
+        if (low_db < cp->config.min_level_db || high_db < cp->config.min_level_db) continue;
+        if (fabsf(low_db - high_db) > MAX_PAIR_TWIST_DB) continue;
+
+        /* Each tone's power is twice its squared Hann magnitude */
+        float power = 2.0f * (powf(10.0f, low_db / 10.0f) + powf(10.0f, high_db / 10.0f));
+        if (power >= best_power) {
+            best_power = power;
+            best = p;
+            *level_db = low_db > high_db ? low_db : high_db;
+        }
+    }
+    return best;
+}
+
+/* End the burst in progress at `end_time`; true if it was reported */
+static bool end_burst(vu_call_progress_t *cp, double end_time, vu_tone_event_t *out_event)
+{
+    double duration = end_time - cp->start_time;
+    vu_tone_kind_t kind = g_pairs[cp->pair].kind;
+    cp->pair = -1;
+
+    if (duration < cp->config.min_duration_sec) return false;
+    if (kind == VU_TONE_BUSY && duration < REORDER_MAX_SEC) kind = VU_TONE_REORDER;
+
+    cp->counts[kind]++;
+    if (out_event) {
+        *out_event = (vu_tone_event_t){
+            .kind = kind,
+            .start_time_sec = cp->start_time,
+            .end_time_sec = end_time,
+            .duration_sec = duration,
+            .level_db = cp->sum_level_db / cp->frame_count
+        };
+    }
+    return true;
+}
+
+bool vu_call_progress_process_frame(vu_call_progress_t *cp,
+                                    const vu_analysis_frame_t *frame,
+                                    vu_tone_event_t *out_event)
+{
+    if (!cp || !frame) return false;
+
+    float level_db = 0.0f;
+    int pair = frame_pair(cp, frame, &level_db);
+
+    if (pair >= 0 && pair == cp->pair) {
+        /* Continuing burst */
+        cp->sum_level_db += level_db;
+        cp->frame_count++;
+        return false;
+    }
+
+    bool ended = cp->pair >= 0 && end_burst(cp, frame->time_sec, out_event);
+
+    if (pair >= 0) {
+        /* Start of burst */
+        cp->pair = pair;
+        cp->start_time = frame->time_sec;
+        cp->sum_level_db = level_db;
+        cp->frame_count = 1;
+    }
+    return ended;
+}
+
+bool vu_call_progress_flush(vu_call_progress_t *cp, double end_time_sec,
+                            vu_tone_event_t *out_event)
+{
+    if (!cp || cp->pair < 0) return false;
+    return end_burst(cp, end_time_sec, out_event);
+}
+
+const int *vu_call_progress_get_counts(const vu_call_progress_t *cp)
+{
+    return cp ? cp->counts : NULL;
+}
+
+const char *vu_tone_kind_name(vu_tone_kind_t kind)
+{
+    switch (kind) {
+    case VU_TONE_DIAL:     return "dial tone";
+    case VU_TONE_RINGBACK: return "ringback";
+    case VU_TONE_BUSY:     return "busy";
+    case VU_TONE_REORDER:  return "reorder";
+    default:               return "none";
+    }
+}
+
+void vu_call_progress_reset(vu_call_progress_t *cp)
+{
+    if (!cp) return;
+    cp->pair = -1;
+    memset(cp->counts, 0, sizeof(cp->counts));
+}
@@ -0,0 +1,94 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Call progress tone classifier on the analyzer's frame spectra
+ *
+ * Recognizes the North American precise tone plan from each frame's
+ * shared spectrum: dial (350 + 440 Hz), ringback (440 + 480 Hz) and
+ * 480 + 620 Hz, which is busy at its 0.5 s cadence and reorder (fast
+ * busy) at 0.25 s. A frame holds a tone when both of its frequencies are
+ * above the level threshold, within 10 dB of each other and carry most of
+ * the frame's energy; runs of frames with the same tone become events.
+ */
+
+#ifndef VU_CALL_PROGRESS_H
+#define VU_CALL_PROGRESS_H
+
+#include "audio/analyzer.h"
+#include <stdbool.h>
+
+/* Tone kinds */
+typedef enum {
+    VU_TONE_NONE = 0,
+    VU_TONE_DIAL,
+    VU_TONE_RINGBACK,
+    VU_TONE_BUSY,
+    VU_TONE_REORDER,
+    VU_TONE_COUNT
+} vu_tone_kind_t;
+
+/* Classifier configuration */
+typedef struct vu_call_progress_config {
+    float min_level_db;       /* Each frequency at least this strong (default -35) */
+    double min_duration_sec;  /* Shortest tone burst reported (default 0.1) */
+} vu_call_progress_config_t;
+
+/* One tone burst */
+typedef struct vu_tone_event {
+    vu_tone_kind_t kind;
+    double start_time_sec;
+    double end_time_sec;
+    double duration_sec;
+    float level_db;           /* Mean level of the stronger frequency */
+} vu_tone_event_t;
+
+/* Opaque classifier handle */
+typedef struct vu_call_progress vu_call_progress_t;
+
+/*
+ * Get default configuration
+ */
+vu_call_progress_config_t vu_call_progress_default_config(void);
+
+/*
+ * Create call progress classifier (NULL config for defaults)
+ * Returns NULL on failure.
+ */
+vu_call_progress_t *vu_call_progress_create(const vu_call_progress_config_t *config);
+
+/*
+ * Destroy classifier
+ */
+void vu_call_progress_destroy(vu_call_progress_t *cp);
+
+/*
+ * Process a frame from the streaming file analysis. Frames without a
+ * spectrum hold no tone.
+ * Returns true if a tone burst just ended (event available)
+ */
+bool vu_call_progress_process_frame(vu_call_progress_t *cp,
+                                    const vu_analysis_frame_t *frame,
+                                    vu_tone_event_t *out_event);
+
+/*
+ * End a burst still sounding when the audio ends at `end_time_sec`
+ * Returns true if it was long enough to report (event available)
+ */
+bool vu_call_progress_flush(vu_call_progress_t *cp, double end_time_sec,
+                            vu_tone_event_t *out_event);
+
+/*
+ * Get the number of bursts reported of each kind (VU_TONE_COUNT entries)
+ */
+const int *vu_call_progress_get_counts(const vu_call_progress_t *cp);
+
+/*
+ * Get a display name for a tone kind
+ */
+const char *vu_tone_kind_name(vu_tone_kind_t kind);
+
+/*
+ * Reset classifier state
+ */
+void vu_call_progress_reset(vu_call_progress_t *cp);
+
+#endif /* VU_CALL_PROGRESS_H */
@@ -0,0 +1,38 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Half-band decimator implementation
+ *
+ * Taps: ideal half-band sinc(n/2)/2 under a Kaiser window (beta 6.2),
+ * quantized to Q15 with the odd taps adjusted to sum to exactly 0.5 so
+ * DC passes at unity gain. The centre tap is 0.5 and the even taps are 0.
+ */
+
+#include "audio/decimator.h"
+
+#define HALFBAND_ODD_TAPS ((VU_HALFBAND_RADIUS + 1) / 2)
+
+/* Taps at offsets +-1, +-3, ... +-27 from the centre, Q15 */
+static const int32_t halfband_taps[HALFBAND_ODD_TAPS] = {
+    10391, -3357, 1891, -1228, 839, -581, 400,
+    -270, 176, -109, 64, -34, 15, -5
+};
+
+void vu_halfband_decimate(const int16_t *in, size_t count, int16_t *out)
+{
+    for (size_t m = 0; m < count; m++) {
+        const int16_t *x = in + 2 * m;
+
+        /* Symmetric taps: one multiply per pair. The sum stays within
+         * int32: sum(|h|) * 32768 * 32768 < 2^31 */
+        int32_t acc = (int32_t)x[0] << 14;
+        for (int k = 0; k < HALFBAND_ODD_TAPS; k++) {
+            int d = 2 * k + 1;
+            acc += halfband_taps[k] * ((int32_t)x[-d] + x[d]);
+        }
+
+        acc = (acc + (1 << 14)) >> 15;
+        if (acc > INT16_MAX) acc = INT16_MAX;
+        if (acc < INT16_MIN) acc = INT16_MIN;
+        out[m] = (int16_t)acc;
+    }
+}
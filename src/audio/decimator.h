@@ -0,0 +1,33 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Half-band decimation by 2 for telephony-band analysis
+ *
+ * A 55-tap linear-phase half-band low-pass: flat to within 0.01 dB up to
+ * 0.2125 of the input rate (3.4 kHz at 16 kHz) and at least 63 dB down
+ * from 0.289 (4.62 kHz), so nothing aliases into the telephony band.
+ * Every other tap of a half-band filter is zero, which leaves 14
+ * multiply-adds per output sample: the polyphase form only evaluates the
+ * odd taps of each output's input pair. Integer only.
+ */
+
+#ifndef VU_DECIMATOR_H
+#define VU_DECIMATOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Input samples needed on each side of an output's centre sample */
+#define VU_HALFBAND_RADIUS 27
+
+/* Highest frequency, as a fraction of the output rate, that passes a
+ * stage unattenuated and free of aliases */
+#define VU_HALFBAND_PASSBAND 0.42f
+
+/*
+ * Decimate by 2: out[m] is the filtered input centred on in[2 * m], with
+ * no delay. Reads in[-VU_HALFBAND_RADIUS] to
+ * in[2 * (count - 1) + VU_HALFBAND_RADIUS].
+ */
+void vu_halfband_decimate(const int16_t *in, size_t count, int16_t *out);
+
+#endif /* VU_DECIMATOR_H */
@@ -0,0 +1,199 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * DTMF digit detector implementation
+ */
+
+#include "audio/dtmf_detector.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* The chosen tone must beat the rest of its group by this much (Hann
+ * leakage between neighbouring DTMF tones is below -30 dB from 256-point
+ * frames at 8 kHz) */
+#define GROUP_MARGIN_DB 10.0f
+
+/* Share of the frame's power the two tones must carry; a clean digit
+ * gives at least 0.72 (scalloping between bins costs up to 1.4 dB) */
+#define MIN_TONE_SHARE 0.5f
+
+static const float g_low_hz[4] = {697.0f, 770.0f, 852.0f, 941.0f};
+static const float g_high_hz[4] = {1209.0f, 1336.0f, 1477.0f, 1633.0f};
+static const char g_keypad[4][4] = {
+    {'1', '2', '3', 'A'},
+    {'4', '5', '6', 'B'},
+    {'7', '8', '9', 'C'},
+    {'*', '0', '#', 'D'},
+};
+
+struct vu_dtmf_detector {
+    vu_dtmf_config_t config;
+
+    /* Digit in progress (0 = none) */
+    char digit;
+    double start_time;
+    float sum_low_db;
+    float sum_high_db;
+    int frame_count;
+
+    char *digits;              /* Reported digits, NUL-terminated */
+    size_t digit_count;
+    size_t digit_capacity;
+};
+
+vu_dtmf_config_t vu_dtmf_default_config(void)
+{
+    vu_dtmf_config_t config = {
+        .min_level_db = -30.0f,
+        .max_twist_db = 8.0f,
+        .min_duration_sec = 0.04
+    };
+    return config;
+}
+
+vu_dtmf_detector_t *vu_dtmf_detector_create(const vu_dtmf_config_t *config)
+{
+    vu_dtmf_detector_t *detector = calloc(1, sizeof(vu_dtmf_detector_t));
+    if (!detector) return NULL;
+
+    detector->config = config ? *config : vu_dtmf_default_config();
+    return detector;
+}
+
+void vu_dtmf_detector_destroy(vu_dtmf_detector_t *detector)
+{
+    if (!detector) return;
+    free(detector->digits);
+    free(detector);
+}
+
+/* Strongest of four tones; false unless it clears the other three by
+ * GROUP_MARGIN_DB */
+static bool strongest_tone(const vu_spectrum_t *spectrum, const float *freqs,
+                           int *index, float *level_db)
+{
+    float levels[4];
+    int best = 0;
+    for (int i = 0; i < 4; i++) {
+        levels[i] = vu_spectrum_level_db(spectrum, freqs[i]);
+        if (levels[i] > levels[best]) best = i;
+    }
+
+    for (int i = 0; i < 4; i++) {
+        if (i != best && levels[i] > levels[best] - GROUP_MARGIN_DB) return false;
+    }
+    *index = best;
+    *level_db = levels[best];
+    return true;
+}
+
+/* Digit held by one frame, or 0 */
+static char frame_digit(const vu_dtmf_detector_t *detector, const vu_analysis_frame_t *frame,
+                        float *low_db, float *high_db)
+{
+    const vu_spectrum_t *spectrum = frame->spectrum;
+    if (!spectrum || !spectrum->bins) return 0;
+    if ((spectrum->bin_count - 1) * spectrum->bin_hz <= g_high_hz[3]) return 0;
+
+    int row, col;
+    if (!strongest_tone(spectrum, g_low_hz, &row, low_db) ||
+        !strongest_tone(spectrum, g_high_hz, &col, high_db)) {
+        return 0;
+    }
+
+    if (*low_db < detector->config.min_level_db || *high_db < detector->config.min_level_db) {
+        return 0;
+    }
+    if (fabsf(*low_db - *high_db) > detector->config.max_twist_db) return 0;
+
+    /* A tone of amplitude A shows as A/2 through the Hann window and has
+     * power A^2/2, so each tone's power is twice its squared magnitude */
+    float tone_power = 2.0f * (powf(10.0f, *low_db / 10.0f) + powf(10.0f, *high_db / 10.0f));
+    float frame_power = powf(10.0f, frame->level.rms_db / 10.0f);
+    if (tone_power < MIN_TONE_SHARE * frame_power) return 0;
+
+    return g_keypad[row][col];
+}
+
+/* End the digit in progress at `end_time`; true if it was reported */
+static bool end_digit(vu_dtmf_detector_t *detector, double end_time, vu_dtmf_event_t *out_event)
+{
+    double duration = end_time - detector->start_time;
+    char digit = detector->digit;
+    detector->digit = 0;
+
+    if (duration < detector->config.min_duration_sec) return false;
+
+    if (detector->digit_count + 1 >= detector->digit_capacity) {
+        size_t new_cap = detector->digit_capacity == 0 ? 32 : detector->digit_capacity * 2;
+        char *new_digits = realloc(detector->digits, new_cap);
+        if (!new_digits) return false;
+        detector->digits = new_digits;
+        detector->digit_capacity = new_cap;
+    }
+    detector->digits[detector->digit_count++] = digit;
+    detector->digits[detector->digit_count] = '\0';
+
+    if (out_event) {
+        *out_event = (vu_dtmf_event_t){
+            .digit = digit,
+            .start_time_sec = detector->start_time,
+            .end_time_sec = end_time,
+            .duration_sec = duration,
+            .low_level_db = detector->sum_low_db / detector->frame_count,
+            .high_level_db = detector->sum_high_db / detector->frame_count
+        };
+    }
+    return true;
+}
+
+bool vu_dtmf_detector_process_frame(vu_dtmf_detector_t *detector,
+                                    const vu_analysis_frame_t *frame,
+                                    vu_dtmf_event_t *out_event)
+{
+    if (!detector || !frame) return false;
+
+    float low_db = 0.0f, high_db = 0.0f;
+    char digit = frame_digit(detector, frame, &low_db, &high_db);
+
+    if (digit != 0 && digit == detector->digit) {
+        /* Continuing digit */
+        detector->sum_low_db += low_db;
+        detector->sum_high_db += high_db;
+        detector->frame_count++;
+        return false;
+    }
+
+    bool ended = detector->digit != 0 && end_digit(detector, frame->time_sec, out_event);
+
+    if (digit != 0) {
+        /* Start of digit */
+        detector->digit = digit;
+        detector->start_time = frame->time_sec;
+        detector->sum_low_db = low_db;
+        detector->sum_high_db = high_db;
+        detector->frame_count = 1;
+    }
+    return ended;
+}
+
+bool vu_dtmf_detector_flush(vu_dtmf_detector_t *detector, double end_time_sec,
+                            vu_dtmf_event_t *out_event)
+{
+    if (!detector || detector->digit == 0) return false;
+    return end_digit(detector, end_time_sec, out_event);
+}
+
+const char *vu_dtmf_detector_get_digits(const vu_dtmf_detector_t *detector)
+{
+    if (!detector || !detector->digits) return "";
+    return detector->digits;
+}
+
+void vu_dtmf_detector_reset(vu_dtmf_detector_t *detector)
+{
+    if (!detector) return;
+    detector->digit = 0;
+    detector->digit_count = 0;
+    if (detector->digits) detector->digits[0] = '\0';
+}
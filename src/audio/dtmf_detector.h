@@ -0,0 +1,82 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * DTMF digit detector on the analyzer's frame spectra
+ *
+ * Reads the eight DTMF frequencies from each frame's shared spectrum
+ * (vu_analysis_frame_t.spectrum): a frame holds a digit when the
+ * strongest low-group and high-group tones are both above the level
+ * threshold, stand clear of the rest of their group, are within the
+ * twist limit of each other and carry most of the frame's energy. Runs of
+ * frames with the same digit become digit events.
+ */
+
+#ifndef VU_DTMF_DETECTOR_H
+#define VU_DTMF_DETECTOR_H
+
+#include "audio/analyzer.h"
+#include <stdbool.h>
+
+/* Detector configuration */
+typedef struct vu_dtmf_config {
+    float min_level_db;       /* Each tone at least this strong (default -30) */
+    float max_twist_db;       /* Largest level difference of the tones (default 8) */
+    double min_duration_sec;  /* Shortest digit reported (default 0.04) */
+} vu_dtmf_config_t;
+
+/* Detected digit */
+typedef struct vu_dtmf_event {
+    char digit;               /* 0-9, *, #, A-D */
+    double start_time_sec;
+    double end_time_sec;
+    double duration_sec;
+    float low_level_db;       /* Mean level of the low-group tone */
+    float high_level_db;      /* Mean level of the high-group tone */
+} vu_dtmf_event_t;
+
+/* Opaque detector handle */
+typedef struct vu_dtmf_detector vu_dtmf_detector_t;
+
+/*
+ * Get default configuration
+ */
+vu_dtmf_config_t vu_dtmf_default_config(void);
+
+/*
+ * Create DTMF detector (NULL config for defaults)
+ * Returns NULL on failure.
+ */
+vu_dtmf_detector_t *vu_dtmf_detector_create(const vu_dtmf_config_t *config);
+
+/*
+ * Destroy detector and free resources
+ */
+void vu_dtmf_detector_destroy(vu_dtmf_detector_t *detector);
+
+/*
+ * Process a frame from the streaming file analysis. Frames without a
+ * spectrum (analyzed without keep_spectrum, or gated as too quiet) hold
+ * no digit.
+ * Returns true if a digit just ended (event available)
+ */
+bool vu_dtmf_detector_process_frame(vu_dtmf_detector_t *detector,
+                                    const vu_analysis_frame_t *frame,
+                                    vu_dtmf_event_t *out_event);
+
+/*
+ * End a digit still sounding when the audio ends at `end_time_sec`
+ * Returns true if it was long enough to report (event available)
+ */
+bool vu_dtmf_detector_flush(vu_dtmf_detector_t *detector, double end_time_sec,
+                            vu_dtmf_event_t *out_event);
+
+/*
+ * Get the digits detected so far, in order (NUL-terminated)
+ */
+const char *vu_dtmf_detector_get_digits(const vu_dtmf_detector_t *detector);
+
+/*
+ * Reset detector state
+ */
+void vu_dtmf_detector_reset(vu_dtmf_detector_t *detector);
+
+#endif /* VU_DTMF_DETECTOR_H */
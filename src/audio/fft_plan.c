@@ -0,0 +1,390 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Process-wide FFT plan and window cache implementation
+ *
+ * Plans are FFTW plans, or with VU_FFT_BUILTIN (meson -Dfft=builtin) the
+ * built-in real FFT, which has no planner or wisdom and always loops its
+ * single-frame transform for batches.
+ */
+
+#include "audio/fft_plan.h"
+#include "util/log.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include <limits.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#ifdef VU_FFT_BUILTIN
+#include "audio/real_fft.h"
+#else
+#include <fftw3.h>
+#endif
+
+/* Frame stride in batched spectra is padded to this many complex values
+ * so every frame starts SIMD-aligned, like a standalone output buffer */
+#define SPECTRUM_ALIGN_COMPLEX 8
+
+#define BUFFER_ALIGN 64            /* Bytes; vu_fft_alloc with the built-in FFT */
+
+struct vu_fft_plan {
+    int size;
+    int batch;                 /* Transforms per execute */
+#ifdef VU_FFT_BUILTIN
+    vu_rfft_t *plan;           /* NULL until an FFT of this size is needed */
+#else
+    fftwf_plan plan;           /* NULL until an FFT of this size is needed */
+#endif
+    const struct vu_fft_plan *single;  /* Batch entries: the size's 1-frame plan */
+    bool loop_single;          /* Batch plan rounds differently: loop `single` */
+    float *window;             /* Hann window (single-frame entries only) */
+    struct vu_fft_plan *next;
+};
+
+/* FFTW's planner and wisdom calls are not thread-safe: all of them happen
+ * under this lock. Executing an existing plan needs no lock. */
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static vu_fft_plan_t *g_plans;
+static vu_fft_planner_t g_planner = VU_FFT_PLANNER_ESTIMATE;
+static char *g_wisdom_path;
+static bool g_wisdom_loaded;
+#ifndef VU_FFT_BUILTIN
+static bool g_wisdom_dirty;
+#endif
+
+const char *vu_fft_backend_name(void)
+{
+#ifdef VU_FFT_BUILTIN
+    return "builtin";
+#else
+    return "fftw";
+#endif
+}
+
+#ifndef VU_FFT_BUILTIN
+static unsigned planner_flags(vu_fft_planner_t planner)
+{
+    switch (planner) {
+    case VU_FFT_PLANNER_MEASURE: return FFTW_MEASURE;
+    case VU_FFT_PLANNER_PATIENT: return FFTW_PATIENT;
+    default:                     return FFTW_ESTIMATE;
+    }
+}
+#endif
+
+const char *vu_fft_planner_name(vu_fft_planner_t planner)
+{
+    switch (planner) {
+    case VU_FFT_PLANNER_MEASURE: return "measure";
+    case VU_FFT_PLANNER_PATIENT: return "patient";
+    default:                     return "estimate";
+    }
+}
+
+vu_fft_planner_t vu_fft_planner_from_string(const char *str)
+{
+    if (!str) return VU_FFT_PLANNER_ESTIMATE;
+    if (strcasecmp(str, "measure") == 0) return VU_FFT_PLANNER_MEASURE;
+    if (strcasecmp(str, "patient") == 0) return VU_FFT_PLANNER_PATIENT;
+    return VU_FFT_PLANNER_ESTIMATE;
+}
+
+void vu_fft_plan_init(vu_fft_planner_t planner, const char *wisdom_path)
+{
+    pthread_mutex_lock(&g_lock);
+    g_planner = planner;
+    free(g_wisdom_path);
+    g_wisdom_path = (wisdom_path && wisdom_path[0]) ? strdup(wisdom_path) : NULL;
+    g_wisdom_loaded = false;
+    pthread_mutex_unlock(&g_lock);
+
+#ifdef VU_FFT_BUILTIN
+    if (planner != VU_FFT_PLANNER_ESTIMATE) {
+        VU_LOG_DEBUG("Built-in FFT: %s planner has no effect", vu_fft_planner_name(planner));
+    }
+#endif
+}
+
+#ifndef VU_FFT_BUILTIN
+/* Import wisdom once, lazily, so commands that never analyze audio
+ * don't touch the file. Caller holds g_lock. */
+static void load_wisdom_locked(void)
+{
+    if (g_wisdom_loaded || !g_wisdom_path) return;
+    g_wisdom_loaded = true;
+
+    if (access(g_wisdom_path, R_OK) != 0) return;
+
+    if (fftwf_import_wisdom_from_filename(g_wisdom_path)) {
+        VU_LOG_DEBUG("Loaded FFTW wisdom from %s", g_wisdom_path);
+    } else {
+        VU_LOG_WARN("Ignoring unreadable FFTW wisdom file %s", g_wisdom_path);
+    }
+}
+
+/* Write wisdom to a temporary file and rename it into place, so parallel
+ * runs sharing a config dir never see a half-written file. Caller holds
+ * g_lock. */
+static void save_wisdom_locked(void)
+{
+    if (!g_wisdom_path || !g_wisdom_dirty) return;
+
+    /* Create the config dir (and its parents) on first save */
+    char dir[PATH_MAX];
+    snprintf(dir, sizeof(dir), "%s", g_wisdom_path);
+    for (char *p = strchr(dir + 1, '/'); p; p = strchr(p + 1, '/')) {
+        *p = '\0';
+        mkdir(dir, 0755);
+        *p = '/';
+    }
+
+    char tmp[PATH_MAX];
+    snprintf(tmp, sizeof(tmp), "%s.%ld.tmp", g_wisdom_path, (long)getpid());
+
+    if (fftwf_export_wisdom_to_filename(tmp) && rename(tmp, g_wisdom_path) == 0) {
+        VU_LOG_DEBUG("Saved FFTW wisdom to %s", g_wisdom_path);
+        g_wisdom_dirty = false;
+    } else {
+        unlink(tmp);
+        VU_LOG_WARN("Failed to save FFTW wisdom to %s", g_wisdom_path);
+    }
+}
+#else
+/* No plans to measure, so no wisdom to keep */
+static void save_wisdom_locked(void)
+{
+}
+#endif
+
+void vu_fft_plan_shutdown(void)
+{
+    pthread_mutex_lock(&g_lock);
+
+    save_wisdom_locked();
+
+    vu_fft_plan_t *entry = g_plans;
+    while (entry) {
+        vu_fft_plan_t *next = entry->next;
+#ifdef VU_FFT_BUILTIN
+        vu_rfft_destroy(entry->plan);
+#else
+        if (entry->plan) fftwf_destroy_plan(entry->plan);
+#endif
+        vu_fft_free(entry->window);
+        free(entry);
+        entry = next;
+    }
+    g_plans = NULL;
+
+    free(g_wisdom_path);
+    g_wisdom_path = NULL;
+    g_wisdom_loaded = false;
+
+    pthread_mutex_unlock(&g_lock);
+}
+
+size_t vu_fft_spectrum_stride(int fft_size)
+{
+    size_t complex_count = (size_t)fft_size / 2 + 1;
+    complex_count = (complex_count + SPECTRUM_ALIGN_COMPLEX - 1) /
+                    SPECTRUM_ALIGN_COMPLEX * SPECTRUM_ALIGN_COMPLEX;
+    return 2 * complex_count;
+}
+
+/* Find or create the cache entry for (size, batch). Caller holds g_lock. */
+static vu_fft_plan_t *get_entry_locked(int size, int batch)
+{
+    for (vu_fft_plan_t *entry = g_plans; entry; entry = entry->next) {
+        if (entry->size == size && entry->batch == batch) return entry;
+    }
+
+    vu_fft_plan_t *entry = calloc(1, sizeof(vu_fft_plan_t));
+    if (!entry) return NULL;
+
+    entry->size = size;
+    entry->batch = batch;
+
+    if (batch == 1) {
+        entry->window = vu_fft_alloc(size);
+        if (!entry->window) {
+            free(entry);
+            return NULL;
+        }
+
+        for (int i = 0; i < size; i++) {
+            entry->window[i] = 0.5f * (1.0f - cosf(2.0f * M_PI * i / (size - 1)));
+        }
+    }
+
+    entry->next = g_plans;
+    g_plans = entry;
+    return entry;
+}
+
+#ifdef VU_FFT_BUILTIN
+/* One transform per size; batches loop it, so their output is trivially
+ * identical to single frames. Caller holds g_lock. */
+static bool create_plan_locked(vu_fft_plan_t *entry)
+{
+    if (entry->batch > 1) {
+        entry->loop_single = true;
+        return true;
+    }
+
+    entry->plan = vu_rfft_create(entry->size, NULL);
+    return entry->plan != NULL;
+}
+#else
+/*
+ * FFTW may pick different codelets for a batch than for one transform,
+ * which would change the last bits of the spectrum. Run one batch of
+ * pseudo-random input both ways and keep the batch plan only if every
+ * frame matches exactly. Caller holds g_lock.
+ */
+static bool batch_matches_single(const vu_fft_plan_t *entry, float *in, float *out)
+{
+    size_t stride = vu_fft_spectrum_stride(entry->size);
+    size_t bytes = ((size_t)entry->size / 2 + 1) * 2 * sizeof(float);
+    float *ref = fftwf_alloc_real(stride);
+    bool match = ref != NULL;
+
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < (size_t)entry->size * entry->batch; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        in[i] = (float)(int32_t)seed / 2147483648.0f;
+    }
+    fftwf_execute_dft_r2c(entry->plan, in, (fftwf_complex *)out);
+
+    for (int f = 0; match && f < entry->batch; f++) {
+        fftwf_execute_dft_r2c(entry->single->plan, in + (size_t)f * entry->size,
+                              (fftwf_complex *)ref);
+        match = memcmp(ref, out + f * stride, bytes) == 0;
+    }
+
+    if (ref) fftwf_free(ref);
+    return match;
+}
+
+/* Plan on scratch buffers: MEASURE/PATIENT overwrite their arrays while
+ * timing, and the plan is later run on each analyzer's own buffers.
+ * Caller holds g_lock. */
+static bool create_plan_locked(vu_fft_plan_t *entry)
+{
+    int n = entry->size;
+    size_t stride = vu_fft_spectrum_stride(n);
+    float *in = fftwf_alloc_real((size_t)n * entry->batch);
+    float *out = fftwf_alloc_real(stride * entry->batch);
+    unsigned flags = planner_flags(g_planner);
+
+    if (in && out) {
+        load_wisdom_locked();
+        if (entry->batch == 1) {
+            entry->plan = fftwf_plan_dft_r2c_1d(n, in, (fftwf_complex *)out, flags);
+        } else {
+            entry->plan = fftwf_plan_many_dft_r2c(1, &n, entry->batch,
+                                                  in, NULL, 1, n,
+                                                  (fftwf_complex *)out, NULL, 1, (int)(stride / 2),
+                                                  flags);
+            if (entry->plan && !batch_matches_single(entry, in, out)) {
+                VU_LOG_DEBUG("FFTW batch plan (%d x %d) differs from single-frame plan, "
+                             "looping single-frame plan instead", entry->batch, n);
+                fftwf_destroy_plan(entry->plan);
+                entry->plan = NULL;
+                entry->loop_single = true;
+            }
+        }
+        if (entry->plan && g_planner != VU_FFT_PLANNER_ESTIMATE) {
+            g_wisdom_dirty = true;
+        }
+    }
+
+    if (in) fftwf_free(in);
+    if (out) fftwf_free(out);
+    return entry->plan != NULL || entry->loop_single;
+}
+#endif
+
+const vu_fft_plan_t *vu_fft_plan_get_batch(int fft_size, int batch)
+{
+    if (fft_size < 2 || batch < 1) return NULL;
+
+    /* Batch plans are checked against, and may fall back to, the
+     * single-frame plan, so make sure that exists first */
+    const vu_fft_plan_t *single = batch > 1 ? vu_fft_plan_get_batch(fft_size, 1) : NULL;
+    if (batch > 1 && !single) return NULL;
+
+    pthread_mutex_lock(&g_lock);
+    vu_fft_plan_t *entry = get_entry_locked(fft_size, batch);
+    if (entry && !entry->plan && !entry->loop_single) {
+        entry->single = single;
+        if (!create_plan_locked(entry)) entry = NULL;
+    }
+    pthread_mutex_unlock(&g_lock);
+
+    return entry;
+}
+
+const vu_fft_plan_t *vu_fft_plan_get(int fft_size)
+{
+    return vu_fft_plan_get_batch(fft_size, 1);
+}
+
+const float *vu_fft_window_get(int size)
+{
+    if (size < 2) return NULL;
+
+    pthread_mutex_lock(&g_lock);
+    vu_fft_plan_t *entry = get_entry_locked(size, 1);
+    pthread_mutex_unlock(&g_lock);
+
+    return entry ? entry->window : NULL;
+}
+
+/* One frame through a single-frame plan */
+static void execute_single(const vu_fft_plan_t *plan, float *in, float *out)
+{
+#ifdef VU_FFT_BUILTIN
+    vu_rfft_execute(plan->plan, in, out);
+#else
+    fftwf_execute_dft_r2c(plan->plan, in, (fftwf_complex *)out);
+#endif
+}
+
+void vu_fft_execute(const vu_fft_plan_t *plan, float *in, float *out)
+{
+    if (!plan->loop_single) {
+        execute_single(plan, in, out);
+        return;
+    }
+
+    size_t stride = vu_fft_spectrum_stride(plan->size);
+    for (int f = 0; f < plan->batch; f++) {
+        execute_single(plan->single, in + (size_t)f * plan->size, out + f * stride);
+    }
+}
+
+float *vu_fft_alloc(size_t count)
+{
+#ifdef VU_FFT_BUILTIN
+    void *buffer = NULL;
+    if (posix_memalign(&buffer, BUFFER_ALIGN, (count > 0 ? count : 1) * sizeof(float)) != 0) {
+        return NULL;
+    }
+    return buffer;
+#else
+    return fftwf_alloc_real(count);
+#endif
+}
+
+void vu_fft_free(float *buffer)
+{
+#ifdef VU_FFT_BUILTIN
+    free(buffer);
+#else
+    if (buffer) fftwf_free(buffer);
+#endif
+}
@@ -0,0 +1,99 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Process-wide FFT plan and window cache
+ *
+ * Analyzers of the same fft_size share one plan and one Hann window.
+ * Plans are created once, under a lock, with the configured planner rigor;
+ * FFTW wisdom can be persisted so later runs skip the measuring. Builds
+ * with the built-in FFT (meson -Dfft=builtin) keep the same interface;
+ * planner and wisdom settings then have no effect.
+ */
+
+#ifndef VU_FFT_PLAN_H
+#define VU_FFT_PLAN_H
+
+#include "util/error.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Planner rigor (FFTW_ESTIMATE / FFTW_MEASURE / FFTW_PATIENT) */
+typedef enum {
+    VU_FFT_PLANNER_ESTIMATE = 0,   /* Heuristic plan, instant (default) */
+    VU_FFT_PLANNER_MEASURE,        /* Time candidate plans, ~seconds on first use */
+    VU_FFT_PLANNER_PATIENT         /* Wider search, slower planning */
+} vu_fft_planner_t;
+
+/* Opaque shared real-to-complex plan */
+typedef struct vu_fft_plan vu_fft_plan_t;
+
+/*
+ * Configure planning. Call before the first analyzer is created.
+ * wisdom_path: FFTW wisdom file imported before the first plan is made and
+ * written back by vu_fft_plan_shutdown; NULL disables wisdom.
+ */
+void vu_fft_plan_init(vu_fft_planner_t planner, const char *wisdom_path);
+
+/*
+ * Save wisdom (if new plans were measured) and free all cached plans and
+ * windows. No analyzer may be alive.
+ */
+void vu_fft_plan_shutdown(void);
+
+/*
+ * Get the shared plan for a real FFT of `fft_size` points, creating it on
+ * first use. Safe to call from any thread. The plan lives until
+ * vu_fft_plan_shutdown. Returns NULL on failure.
+ */
+const vu_fft_plan_t *vu_fft_plan_get(int fft_size);
+
+/*
+ * Get the shared plan for `batch` real FFTs of `fft_size` points in one
+ * call (contiguous inputs, outputs vu_fft_spectrum_stride apart). Output is
+ * bit-identical to running the single-frame plan on each frame: if FFTW's
+ * batched plan would round differently, the single plan is looped instead.
+ * Returns NULL on failure.
+ */
+const vu_fft_plan_t *vu_fft_plan_get_batch(int fft_size, int batch);
+
+/*
+ * Get the distance in floats between consecutive spectra in batched
+ * output. At least fft_size/2 + 1 re/im pairs, padded for alignment.
+ */
+size_t vu_fft_spectrum_stride(int fft_size);
+
+/*
+ * Get the shared Hann window of `size` points (no plan is created).
+ * Returns NULL on failure.
+ */
+const float *vu_fft_window_get(int size);
+
+/*
+ * Transform `in` (fft_size reals per frame) into `out` (fft_size/2 + 1
+ * interleaved re/im pairs per frame, frames vu_fft_spectrum_stride apart).
+ * Buffers must come from vu_fft_alloc. Thread-safe: any number of threads
+ * may execute the same plan on their own buffers.
+ */
+void vu_fft_execute(const vu_fft_plan_t *plan, float *in, float *out);
+
+/*
+ * Allocate/free SIMD-aligned float buffers for vu_fft_execute
+ */
+float *vu_fft_alloc(size_t count);
+void vu_fft_free(float *buffer);
+
+/*
+ * Get the FFT implementation compiled in: "fftw" or "builtin"
+ */
+const char *vu_fft_backend_name(void);
+
+/*
+ * Get planner name string
+ */
+const char *vu_fft_planner_name(vu_fft_planner_t planner);
+
+/*
+ * Parse planner from string
+ */
+vu_fft_planner_t vu_fft_planner_from_string(const char *str);
+
+#endif /* VU_FFT_PLAN_H */
@@ -0,0 +1,281 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Integer DSP kernels for the fixed-point analyzer implementation
+ *
+ * The N-point real FFT runs as an N/2-point complex FFT over the even and
+ * odd samples, followed by the usual split into the real spectrum. Data
+ * is int32 with int64 products; each butterfly stage shifts right by one,
+ * which keeps every intermediate within int32 and leaves the output scaled
+ * by 1 / (N/2). Only table setup uses floating point.
+ */
+
+#include "audio/fixed_dsp.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+struct vu_fixed_fft {
+    int size;                  /* N real points */
+    int half;                  /* M = N/2 complex points */
+    int16_t *window;           /* Hann window, Q15 */
+    int32_t *twiddle;          /* cos, -sin of 2*pi*k/N for k = 0..M, Q31 */
+    uint32_t *bitrev;          /* M-point bit-reversal permutation */
+};
+
+/* Q31 product with rounding */
+static inline int32_t mul_q31(int32_t a, int32_t b)
+{
+    return (int32_t)(((int64_t)a * b + (1LL << 30)) >> 31);
+}
+
+static int32_t to_q31(double x)
+{
+    double scaled = round(x * 2147483648.0);
+    if (scaled > 2147483647.0) scaled = 2147483647.0;
+    if (scaled < -2147483648.0) scaled = -2147483648.0;
+    return (int32_t)scaled;
+}
+
+vu_fixed_fft_t *vu_fixed_fft_create(int size)
+{
+    if (size < 4 || (size & (size - 1)) != 0) return NULL;
+
+    vu_fixed_fft_t *fft = calloc(1, sizeof(vu_fixed_fft_t));
+    if (!fft) return NULL;
+
+    fft->size = size;
+    fft->half = size / 2;
+    fft->window = malloc((size_t)size * sizeof(int16_t));
+    fft->twiddle = malloc(((size_t)fft->half + 1) * 2 * sizeof(int32_t));
+    fft->bitrev = malloc((size_t)fft->half * sizeof(uint32_t));
+    if (!fft->window || !fft->twiddle || !fft->bitrev) {
+        vu_fixed_fft_destroy(fft);
+        return NULL;
+    }
+
+    /* Same Hann definition as the floating-point window */
+    for (int i = 0; i < size; i++) {
+        double w = 0.5 * (1.0 - cos(2.0 * M_PI * i / (size - 1)));
+        fft->window[i] = (int16_t)lround(w * 32767.0);
+    }
+
+    for (int k = 0; k <= fft->half; k++) {
+        double angle = 2.0 * M_PI * k / size;
+        fft->twiddle[2 * k] = to_q31(cos(angle));
+        fft->twiddle[2 * k + 1] = to_q31(-sin(angle));
+    }
+
+    int bits = 0;
+    while ((1 << bits) < fft->half) bits++;
+    for (uint32_t i = 0; i < (uint32_t)fft->half; i++) {
+        uint32_t r = 0;
+        for (int b = 0; b < bits; b++) {
+            r |= ((i >> b) & 1u) << (bits - 1 - b);
+        }
+        fft->bitrev[i] = r;
+    }
+
+    return fft;
+}
+
+void vu_fixed_fft_destroy(vu_fixed_fft_t *fft)
+{
+    if (!fft) return;
+
+    free(fft->window);
+    free(fft->twiddle);
+    free(fft->bitrev);
+    free(fft);
+}
+
+void vu_fixed_fft_window(const vu_fixed_fft_t *fft, int32_t *out,
+                         const int16_t *in, size_t count,
+                         uint64_t *sum_squares, int32_t *peak,
+                         uint64_t *window_squares)
+{
+    uint64_t sum = 0;
+    uint64_t windowed = 0;
+    int32_t max_abs = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        int32_t s = in[i];
+        /* Q15 sample x Q15 window = Q30, halved to Q29 */
+        out[i] = (s * fft->window[i]) >> 1;
+        sum += (uint64_t)(s * s);
+        /* Q22 squared: under 2^44 each, so the sum cannot overflow */
+        int64_t q = out[i] >> 7;
+        windowed += (uint64_t)(q * q);
+        int32_t a = s < 0 ? -s : s;
+        if (a > max_abs) max_abs = a;
+    }
+
+    memset(out + count, 0, ((size_t)fft->size - count) * sizeof(int32_t));
+
+    *sum_squares = sum;
+    *peak = max_abs;
+    *window_squares = windowed;
+}
+
+double vu_fixed_fft_window_energy(const vu_fixed_fft_t *fft)
+{
+    double energy = 0.0;
+    for (int i = 0; i < fft->size; i++) {
+        double w = fft->window[i] / 32767.0;
+        energy += w * w;
+    }
+    return energy;
+}
+
+double vu_fixed_fft_window_response(const vu_fixed_fft_t *fft, int k)
+{
+    double re = 0.0, im = 0.0;
+    for (int i = 0; i < fft->size; i++) {
+        double w = fft->window[i] / 32767.0;
+        re += w * cos(2.0 * M_PI * k * i / fft->size);
+        im -= w * sin(2.0 * M_PI * k * i / fft->size);
+    }
+    return sqrt(re * re + im * im);
+}
+
+/* M-point complex FFT in place, each stage scaled by 1/2 */
+static void complex_fft(const vu_fixed_fft_t *fft, int32_t *data)
+{
+    int m = fft->half;
+
+    for (int i = 0; i < m; i++) {
+        int j = (int)fft->bitrev[i];
+        if (j > i) {
+            int32_t re = data[2 * i];
+            int32_t im = data[2 * i + 1];
+            data[2 * i] = data[2 * j];
+            data[2 * i + 1] = data[2 * j + 1];
+            data[2 * j] = re;
+            data[2 * j + 1] = im;
+        }
+    }
+
+    for (int len = 2; len <= m; len <<= 1) {
+        int h = len / 2;
+        /* W_len^j = W_N^(j * N/len) */
+        int step = fft->size / len;
+
+        for (int start = 0; start < m; start += len) {
+            for (int j = 0; j < h; j++) {
+                int32_t wr = fft->twiddle[2 * j * step];
+                int32_t wi = fft->twiddle[2 * j * step + 1];
+                int32_t *a = &data[2 * (start + j)];
+                int32_t *b = &data[2 * (start + j + h)];
+
+                int64_t tr = ((int64_t)b[0] * wr - (int64_t)b[1] * wi + (1LL << 30)) >> 31;
+                int64_t ti = ((int64_t)b[0] * wi + (int64_t)b[1] * wr + (1LL << 30)) >> 31;
+
+                int64_t ar = a[0];
+                int64_t ai = a[1];
+                a[0] = (int32_t)((ar + tr) >> 1);
+                a[1] = (int32_t)((ai + ti) >> 1);
+                b[0] = (int32_t)((ar - tr) >> 1);
+                b[1] = (int32_t)((ai - ti) >> 1);
+            }
+        }
+    }
+}
+
+void vu_fixed_fft_execute(const vu_fixed_fft_t *fft, int32_t *data)
+{
+    int m = fft->half;
+
+    /* Even samples as real parts, odd as imaginary: Z = FFT_M(z) / M */
+    complex_fft(fft, data);
+
+    /* Split: X[k] = Fe + W^k Fo and X[M-k] = conj(Fe - W^k Fo), where
+     * Fe = (Z[k] + conj Z[M-k]) / 2 and Fo = -i (Z[k] - conj Z[M-k]) / 2 */
+    int32_t re0 = data[0];
+    int32_t im0 = data[1];
+    data[0] = re0 + im0;
+    data[1] = 0;
+    data[2 * m] = re0 - im0;
+    data[2 * m + 1] = 0;
+
+    for (int k = 1; k <= m / 2; k++) {
+        int32_t *zk = &data[2 * k];
+        int32_t *zc = &data[2 * (m - k)];
+
+        int32_t fe_re = (int32_t)(((int64_t)zk[0] + zc[0]) >> 1);
+        int32_t fe_im = (int32_t)(((int64_t)zk[1] - zc[1]) >> 1);
+        int32_t fo_re = (int32_t)(((int64_t)zk[1] + zc[1]) >> 1);
+        int32_t fo_im = (int32_t)(((int64_t)zc[0] - zk[0]) >> 1);
+
+        int32_t wr = fft->twiddle[2 * k];
+        int32_t wi = fft->twiddle[2 * k + 1];
+        int32_t t_re = mul_q31(fo_re, wr) - mul_q31(fo_im, wi);
+        int32_t t_im = mul_q31(fo_re, wi) + mul_q31(fo_im, wr);
+
+        zk[0] = fe_re + t_re;
+        zk[1] = fe_im + t_im;
+        zc[0] = fe_re - t_re;
+        zc[1] = t_im - fe_im;
+    }
+}
+
+int vu_fixed_peak_power(const int32_t *spectrum, int first, int last,
+                        uint64_t *max_power)
+{
+    uint64_t best = 0;
+    int best_bin = -1;
+
+    for (int i = first; i < last; i++) {
+        int64_t re = spectrum[2 * i];
+        int64_t im = spectrum[2 * i + 1];
+        uint64_t power = (uint64_t)(re * re) + (uint64_t)(im * im);
+        if (power > best) {
+            best = power;
+            best_bin = i;
+        }
+    }
+
+    *max_power = best;
+    return best_bin;
+}
+
+void vu_fixed_goertzel(const int32_t *in, size_t count,
+                       const vu_fixed_goertzel_coeff_t *coeffs, int targets,
+                       int64_t *s1, int64_t *s2)
+{
+    for (int t = 0; t < targets; t++) {
+        /* Q29 down to Q20, less any headroom this filter needs */
+        int32_t coeff = coeffs[t].coeff;
+        int shift = 9 + coeffs[t].headroom;
+        int64_t a = 0, b = 0;
+
+        for (size_t i = 0; i < count; i++) {
+            int64_t s0 = (in[i] >> shift) + ((coeff * a) >> 24) - b;
+            b = a;
+            a = s0;
+        }
+
+        /* Back to Q20: the true states are within the bound in
+         * vu_fixed_goertzel_coeff, so they fit easily in 64 bits */
+        s1[t] = a * ((int64_t)1 << coeffs[t].headroom);
+        s2[t] = b * ((int64_t)1 << coeffs[t].headroom);
+    }
+}
+
+/*
+ * A full-scale Q20 input (2^20) drives the state to at most 2^20 * count *
+ * min(count, 1 / |sin w|), and the Q24 product needs |state| < 2^38: so
+ * up to 512 samples always fit, but e.g. 8192 samples only for sin w >=
+ * 1/32 (40 Hz .. fs/2 - 40 Hz at 8 kHz). Beyond that the input is scaled
+ * down.
+ */
+vu_fixed_goertzel_coeff_t vu_fixed_goertzel_coeff(double w, size_t count)
+{
+    vu_fixed_goertzel_coeff_t c = { (int32_t)lround(2.0 * cos(w) * (1 << 24)), 0 };
+
+    double sin_w = fabs(sin(w));
+    double growth = (double)count * (sin_w * (double)count > 1.0 ? 1.0 / sin_w : (double)count);
+    while (growth > (double)(1 << 18)) {
+        growth /= 2.0;
+        c.headroom++;
+    }
+    return c;
+}
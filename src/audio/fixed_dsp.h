@@ -0,0 +1,98 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Integer DSP kernels for the fixed-point analyzer
+ *
+ * Samples are windowed into Q29 (full scale = 2^29) and transformed by a
+ * Q31-twiddle real FFT that halves every stage, so the output needs no
+ * overflow checks and bin k holds X[k] / (N/2), the same normalization the
+ * floating-point analyzer reports.
+ */
+
+#ifndef VU_FIXED_DSP_H
+#define VU_FIXED_DSP_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Q29 full scale of windowed samples and spectrum magnitudes */
+#define VU_FIXED_ONE (1 << 29)
+
+/* Full scale of Goertzel states */
+#define VU_FIXED_GOERTZEL_ONE (1 << 20)
+
+/* Full scale of vu_fixed_fft_window's window_squares (Q44) */
+#define VU_FIXED_ENERGY_ONE ((uint64_t)1 << 44)
+
+/* Opaque real FFT (window, twiddles and bit reversal) of one size */
+typedef struct vu_fixed_fft vu_fixed_fft_t;
+
+/* One Goertzel filter, set up for a frame length */
+typedef struct vu_fixed_goertzel_coeff {
+    int32_t coeff;             /* 2*cos(w), Q24 */
+    int headroom;              /* Extra input shift that keeps the states in range */
+} vu_fixed_goertzel_coeff_t;
+
+/*
+ * Create a real FFT of `size` points (power of 2, at least 4).
+ * Returns NULL on failure.
+ */
+vu_fixed_fft_t *vu_fixed_fft_create(int size);
+
+/*
+ * Destroy FFT and free resources
+ */
+void vu_fixed_fft_destroy(vu_fixed_fft_t *fft);
+
+/*
+ * Apply the Hann window to `count` PCM samples (count <= size) into `out`
+ * as Q29, zero-padding to size, and measure them in the same pass:
+ * sum of squares and largest absolute sample, and the windowed frame's
+ * energy (sum of squares at VU_FIXED_ENERGY_ONE full scale).
+ */
+void vu_fixed_fft_window(const vu_fixed_fft_t *fft, int32_t *out,
+                         const int16_t *in, size_t count,
+                         uint64_t *sum_squares, int32_t *peak,
+                         uint64_t *window_squares);
+
+/*
+ * Sum of squared Hann window coefficients (for energy bounds)
+ */
+double vu_fixed_fft_window_energy(const vu_fixed_fft_t *fft);
+
+/*
+ * |W(k)|: magnitude of the Hann window's DFT at bin k, i.e. how much of a
+ * tone k bins away a bin picks up (k = 0: the window's sum)
+ */
+double vu_fixed_fft_window_response(const vu_fixed_fft_t *fft, int k);
+
+/*
+ * Transform in place: `data` holds size reals on entry (size + 2 entries
+ * allocated) and size/2 + 1 interleaved re/im pairs on return.
+ */
+void vu_fixed_fft_execute(const vu_fixed_fft_t *fft, int32_t *data);
+
+/*
+ * Find the bin in [first, last) with the largest power re^2 + im^2.
+ * Returns the bin, or -1 if every bin is zero.
+ */
+int vu_fixed_peak_power(const int32_t *spectrum, int first, int last,
+                        uint64_t *max_power);
+
+/*
+ * Goertzel filter bank over `count` Q29 samples: runs one filter per
+ * coefficient and returns each filter's last two states (Q20 scale), from
+ * which the caller forms the complex output.
+ * coeffs: one per target, from vu_fixed_goertzel_coeff for at least `count`
+ */
+void vu_fixed_goertzel(const int32_t *in, size_t count,
+                       const vu_fixed_goertzel_coeff_t *coeffs, int targets,
+                       int64_t *s1, int64_t *s2);
+
+/*
+ * Goertzel filter at angular frequency w (radians per sample) for frames
+ * of up to `count` samples: its Q24 coefficient and the headroom its
+ * states need over that length
+ */
+vu_fixed_goertzel_coeff_t vu_fixed_goertzel_coeff(double w, size_t count);
+
+#endif /* VU_FIXED_DSP_H */
@@ -0,0 +1,141 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Lock-free SPSC frame ring implementation
+ */
+
+#include "audio/frame_ring.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Keeps the producer's and consumer's indices on their own cache lines */
+#define CACHE_LINE 64
+
+/*
+ * head and tail count frames since creation and only ever grow; a slot
+ * is `index & mask`, and head - tail frames are queued. Each side owns
+ * one index: the release store of it publishes the slot it just filled
+ * (or freed) to the acquire load on the other side.
+ */
+struct vu_frame_ring {
+    _Alignas(CACHE_LINE) atomic_size_t head;    /* Next slot to fill (producer) */
+    _Alignas(CACHE_LINE) atomic_size_t tail;    /* Next slot to take (consumer) */
+
+    _Alignas(CACHE_LINE) atomic_uint_fast64_t pushed;
+    atomic_uint_fast64_t overruns;
+    atomic_size_t high_water;
+
+    size_t depth;
+    size_t mask;
+    size_t frame_samples;
+    size_t dropped;            /* Samples dropped since the last push (producer) */
+    size_t *counts;            /* Samples held in each slot */
+    size_t *gaps;              /* Samples dropped just before each slot */
+    int16_t *samples;          /* depth * frame_samples */
+};
+
+vu_frame_ring_t *vu_frame_ring_create(size_t depth, size_t frame_samples)
+{
+    if (depth == 0 || frame_samples == 0) return NULL;
+
+    size_t slots = 1;
+    while (slots < depth) slots <<= 1;
+
+    vu_frame_ring_t *ring = aligned_alloc(CACHE_LINE, sizeof(vu_frame_ring_t));
+    if (!ring) return NULL;
+    memset(ring, 0, sizeof(*ring));
+
+    ring->depth = slots;
+    ring->mask = slots - 1;
+    ring->frame_samples = frame_samples;
+    ring->counts = calloc(slots, sizeof(size_t));
+    ring->gaps = calloc(slots, sizeof(size_t));
+    ring->samples = calloc(slots * frame_samples, sizeof(int16_t));
+    if (!ring->counts || !ring->gaps || !ring->samples) {
+        vu_frame_ring_destroy(ring);
+        return NULL;
+    }
+
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->pushed, 0);
+    atomic_init(&ring->overruns, 0);
+    atomic_init(&ring->high_water, 0);
+    return ring;
+}
+
+void vu_frame_ring_destroy(vu_frame_ring_t *ring)
+{
+    if (!ring) return;
+    free(ring->samples);
+    free(ring->counts);
+    free(ring->gaps);
+    free(ring);
+}
+
+bool vu_frame_ring_push(vu_frame_ring_t *ring, const int16_t *samples, size_t count)
+{
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    if (count > ring->frame_samples) count = ring->frame_samples;
+    if (head - tail >= ring->depth) {
+        ring->dropped += count;
+        atomic_fetch_add_explicit(&ring->overruns, 1, memory_order_relaxed);
+        return false;
+    }
+
+    size_t slot = head & ring->mask;
+    int16_t *dst = ring->samples + slot * ring->frame_samples;
+    if (samples) {
+        memcpy(dst, samples, count * sizeof(int16_t));
+    } else {
+        memset(dst, 0, count * sizeof(int16_t));
+    }
+    ring->counts[slot] = count;
+    ring->gaps[slot] = ring->dropped;
+    ring->dropped = 0;
+
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    atomic_fetch_add_explicit(&ring->pushed, 1, memory_order_relaxed);
+
+    /* Only the producer raises the mark, so a plain compare suffices */
+    size_t queued = head + 1 - tail;
+    if (queued > atomic_load_explicit(&ring->high_water, memory_order_relaxed)) {
+        atomic_store_explicit(&ring->high_water, queued, memory_order_relaxed);
+    }
+    return true;
+}
+
+bool vu_frame_ring_pop(vu_frame_ring_t *ring, int16_t *out, size_t *count, size_t *dropped)
+{
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (tail == head) return false;
+
+    size_t slot = tail & ring->mask;
+    *count = ring->counts[slot];
+    *dropped = ring->gaps[slot];
+    memcpy(out, ring->samples + slot * ring->frame_samples, *count * sizeof(int16_t));
+
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+size_t vu_frame_ring_depth(const vu_frame_ring_t *ring)
+{
+    return ring ? ring->depth : 0;
+}
+
+void vu_frame_ring_get_stats(const vu_frame_ring_t *ring, vu_frame_ring_stats_t *stats)
+{
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (!ring) return;
+
+    /* The counters are only read, but C11 wants non-const atomics */
+    vu_frame_ring_t *r = (vu_frame_ring_t *)ring;
+    stats->frames_pushed = atomic_load_explicit(&r->pushed, memory_order_relaxed);
+    stats->overruns = atomic_load_explicit(&r->overruns, memory_order_relaxed);
+    stats->high_water = atomic_load_explicit(&r->high_water, memory_order_relaxed);
+}
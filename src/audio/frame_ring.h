@@ -0,0 +1,67 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Lock-free single-producer/single-consumer ring of audio frames
+ *
+ * Hands fixed-size frames from one thread to another without locks: the
+ * producer (PJMEDIA's clock thread) only copies a frame into the next free
+ * slot and publishes it, the consumer (an analysis worker) copies frames
+ * out in order. A full ring drops the new frame and counts an overrun, so
+ * the producer never waits; the next frame queued carries the number of
+ * samples dropped before it, so the consumer can keep its own clock.
+ * Exactly one thread may push and one thread may pop at any time.
+ */
+
+#ifndef VU_FRAME_RING_H
+#define VU_FRAME_RING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct vu_frame_ring vu_frame_ring_t;
+
+/* Counters (each read atomically, not as a consistent set) */
+typedef struct vu_frame_ring_stats {
+    uint64_t frames_pushed;    /* Frames queued */
+    uint64_t overruns;         /* Frames dropped on a full ring */
+    size_t high_water;         /* Most frames ever queued at once */
+} vu_frame_ring_stats_t;
+
+/*
+ * Create a ring of at least `depth` frames (rounded up to a power of two)
+ * of up to `frame_samples` samples each
+ * Returns NULL on failure.
+ */
+vu_frame_ring_t *vu_frame_ring_create(size_t depth, size_t frame_samples);
+
+/*
+ * Destroy ring (neither side may be using it)
+ */
+void vu_frame_ring_destroy(vu_frame_ring_t *ring);
+
+/*
+ * Queue a frame (producer). NULL samples queues `count` samples of
+ * silence; frames longer than the slot are truncated.
+ * Returns false if the ring was full and the frame was dropped.
+ */
+bool vu_frame_ring_push(vu_frame_ring_t *ring, const int16_t *samples, size_t count);
+
+/*
+ * Take the oldest frame into `out` (frame_samples long), its length into
+ * `count` and the samples dropped on overruns just before it into
+ * `dropped` (consumer)
+ * Returns false if the ring is empty.
+ */
+bool vu_frame_ring_pop(vu_frame_ring_t *ring, int16_t *out, size_t *count, size_t *dropped);
+
+/*
+ * Get the ring's depth in frames (after rounding)
+ */
+size_t vu_frame_ring_depth(const vu_frame_ring_t *ring);
+
+/*
+ * Get the ring's counters (any thread)
+ */
+void vu_frame_ring_get_stats(const vu_frame_ring_t *ring, vu_frame_ring_stats_t *stats);
+
+#endif /* VU_FRAME_RING_H */
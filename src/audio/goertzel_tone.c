@@ -0,0 +1,91 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Goertzel tone measurement implementation
+ *
+ * After N samples a filter at w holds s1 = y[N-1] and s2 = y[N-2], and
+ * s1 - e^{-jw} s2 = X(w) e^{jw(N-1)}. Rotating by e^{-jw(N-1)} gives X(w)
+ * itself, so filters at different frequencies line up as FFT bins do.
+ */
+
+#include "audio/goertzel_tone.h"
+#include "audio/peak_interp.h"
+#include <string.h>
+#include <math.h>
+
+void vu_goertzel_target_init(vu_goertzel_target_t *target, const vu_analyzer_config_t *config,
+                             int t)
+{
+    double w = 2.0 * M_PI * config->target_freqs_hz[t] / config->sample_rate;
+    double bin_w = 2.0 * M_PI / config->fft_size;
+    double last = config->fft_size - 1;
+
+    for (int f = 0; f < VU_GOERTZEL_FILTERS; f++) {
+        double wf = w + (f - VU_GOERTZEL_FILTER(0)) * bin_w;
+        target->w[f] = wf;
+        target->cos_w[f] = (float)cos(wf);
+        target->sin_w[f] = (float)sin(wf);
+        target->align[f][0] = (float)cos(wf * last);
+        target->align[f][1] = (float)-sin(wf * last);
+    }
+}
+
+void vu_goertzel_bin(const vu_goertzel_target_t *target, int filter, float s1, float s2,
+                     float *bin)
+{
+    float re = s1 - s2 * target->cos_w[filter];
+    float im = s2 * target->sin_w[filter];
+    const float *a = target->align[filter];
+    bin[0] = re * a[0] - im * a[1];
+    bin[1] = re * a[1] + im * a[0];
+}
+
+float vu_goertzel_power(const float *bin)
+{
+    return bin[0] * bin[0] + bin[1] * bin[1];
+}
+
+int vu_goertzel_centre(const float *bins)
+{
+    float below = vu_goertzel_power(bins);
+    float at = vu_goertzel_power(bins + 2);
+    float above = vu_goertzel_power(bins + 4);
+
+    if (above > at && above >= below) return 1;
+    if (below > at) return -1;
+    return 0;
+}
+
+float vu_goertzel_frequency(const vu_analyzer_config_t *config, int t, const float *bins,
+                            int centre, const float *beyond)
+{
+    /* Three consecutive bins around the strongest */
+    float around[6];
+    if (centre > 0) {
+        memcpy(around, bins + 2, 4 * sizeof(float));
+        memcpy(around + 4, beyond, 2 * sizeof(float));
+    } else if (centre < 0) {
+        memcpy(around, beyond, 2 * sizeof(float));
+        memcpy(around + 2, bins, 4 * sizeof(float));
+    } else {
+        memcpy(around, bins, 6 * sizeof(float));
+    }
+
+    vu_peak_interp_t method = config->interpolation != VU_PEAK_INTERP_NONE ?
+                              config->interpolation : VU_PEAK_INTERP_PARABOLIC;
+    float offset, peak_db;
+    vu_peak_interpolate(method, around, &offset, &peak_db);
+    return config->target_freqs_hz[t] +
+           (centre + offset) * (float)config->sample_rate / config->fft_size;
+}
+
+/*
+ * A pure tone within a bin or so of the target puts most of its energy in
+ * these bins; speech or noise leaking into the target spreads over the
+ * whole spectrum
+ */
+bool vu_goertzel_is_tone(const float *bins, float tone_norm, double energy)
+{
+    double power = (double)vu_goertzel_power(bins) + vu_goertzel_power(bins + 2) +
+                   vu_goertzel_power(bins + 4);
+    return energy > 0.0 && power * tone_norm >= VU_ANALYZER_MIN_TONE_SHARE * energy;
+}
@@ -0,0 +1,74 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Goertzel tone measurement
+ *
+ * Internal to src/audio; shared by both analyzer engines. Goertzel mode
+ * runs one filter per target and, for a target above min_level_db, more
+ * filters one and two FFT bins either side. Their outputs, rotated to a
+ * common phase reference, are the bins vu_peak_interpolate takes, and
+ * tell a tone near the target from speech or noise leaking into it. The
+ * filters always run over the whole zero-padded frame, so everything but
+ * their states is fixed per analyzer and computed at create time.
+ */
+
+#ifndef VU_GOERTZEL_TONE_H
+#define VU_GOERTZEL_TONE_H
+
+#include "audio/analyzer.h"
+#include <stdbool.h>
+
+/* Filters per target: the target itself and 1 and 2 bins either side */
+#define VU_GOERTZEL_FILTERS 5
+
+/* Index of the filter `bins` FFT bins from the target (-2 .. 2) */
+#define VU_GOERTZEL_FILTER(bins) ((bins) + 2)
+
+/* Per-target constants */
+typedef struct vu_goertzel_target {
+    double w[VU_GOERTZEL_FILTERS];        /* Each filter's angular frequency */
+    float cos_w[VU_GOERTZEL_FILTERS];
+    float sin_w[VU_GOERTZEL_FILTERS];
+    float align[VU_GOERTZEL_FILTERS][2];  /* e^{-jw(N-1)}, re/im */
+} vu_goertzel_target_t;
+
+/*
+ * Set up target t of `config` (its fft_size is the filters' length N)
+ */
+void vu_goertzel_target_init(vu_goertzel_target_t *target, const vu_analyzer_config_t *config,
+                             int t);
+
+/*
+ * X of one filter from its last two states, at the states' scale: the
+ * filter output s1 - e^{-jw} s2 is X advanced by N - 1 samples, rotated
+ * back so all filters share a phase reference. `bin`: re/im.
+ */
+void vu_goertzel_bin(const vu_goertzel_target_t *target, int filter, float s1, float s2,
+                     float *bin);
+
+/*
+ * |X|^2 of a re/im pair
+ */
+float vu_goertzel_power(const float *bin);
+
+/*
+ * Where a tone lies given the target's bins (below, at, above: three
+ * re/im pairs): -1 or 1 if nearer a neighbour, so the frequency has to be
+ * measured around it with the filter two bins out that side, else 0
+ */
+int vu_goertzel_centre(const float *bins);
+
+/*
+ * Frequency of target t from its bins and vu_goertzel_centre's `centre`;
+ * `beyond` is X two bins out on that side (unused for centre 0)
+ */
+float vu_goertzel_frequency(const vu_analyzer_config_t *config, int t, const float *bins,
+                            int centre, const float *beyond);
+
+/*
+ * True if the target's bins carry at least VU_ANALYZER_MIN_TONE_SHARE of
+ * the windowed frame's `energy` (the same scale as the bins squared).
+ * tone_norm: a pure tone's three-bin power over its energy, inverted.
+ */
+bool vu_goertzel_is_tone(const float *bins, float tone_norm, double energy);
+
+#endif /* VU_GOERTZEL_TONE_H */
@@ -0,0 +1,83 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Sub-bin spectral peak interpolation implementation
+ *
+ * Parabolic: fit y = b - (a - c) x / 2 + (a - 2b + c) x^2 / 2 through the
+ * dB magnitudes a, b, c of bins k - 1, k, k + 1; the vertex gives offset
+ * and height. Jacobsen: offset = P * Re((X[k-1] - X[k+1]) /
+ * (2 X[k] - X[k-1] - X[k+1])), where the Hann window halves the
+ * rectangular-window estimate (P = 2), and the height from the Hann main
+ * lobe |W(d)| = sinc(d) / (1 - d^2) at that offset.
+ */
+
+#include "audio/peak_interp.h"
+#include <math.h>
+
+#define JACOBSEN_HANN_SCALE 2.0f
+
+static float power_db(const float *bin)
+{
+    return 10.0f * log10f(bin[0] * bin[0] + bin[1] * bin[1] + 1e-30f);
+}
+
+static float clamp_offset(float offset)
+{
+    if (offset > 0.5f) return 0.5f;
+    if (offset < -0.5f) return -0.5f;
+    return offset;
+}
+
+static void parabolic(const float *bins, float *offset, float *peak_db)
+{
+    float a = power_db(bins);
+    float b = power_db(bins + 2);
+    float c = power_db(bins + 4);
+    float denom = a - 2.0f * b + c;
+
+    /* Not a strict maximum (flat or rising): keep the bin */
+    float d = denom < 0.0f ? clamp_offset(0.5f * (a - c) / denom) : 0.0f;
+    *offset = d;
+    *peak_db = b - 0.25f * (a - c) * d;
+}
+
+static void jacobsen(const float *bins, float *offset, float *peak_db)
+{
+    /* num / den with num = X[k-1] - X[k+1], den = 2 X[k] - X[k-1] - X[k+1] */
+    float num_re = bins[0] - bins[4];
+    float num_im = bins[1] - bins[5];
+    float den_re = 2.0f * bins[2] - bins[0] - bins[4];
+    float den_im = 2.0f * bins[3] - bins[1] - bins[5];
+    float den_power = den_re * den_re + den_im * den_im;
+
+    float d = 0.0f;
+    if (den_power > 0.0f) {
+        d = clamp_offset(JACOBSEN_HANN_SCALE * (num_re * den_re + num_im * den_im) / den_power);
+    }
+
+    /* Undo the main lobe's roll-off at offset d */
+    float gain = 1.0f;
+    if (d != 0.0f) {
+        float x = (float)M_PI * d;
+        gain = sinf(x) / x / (1.0f - d * d);
+    }
+
+    *offset = d;
+    *peak_db = power_db(bins + 2) - 20.0f * log10f(gain);
+}
+
+void vu_peak_interpolate(vu_peak_interp_t method, const float *bins,
+                         float *offset, float *peak_db)
+{
+    switch (method) {
+    case VU_PEAK_INTERP_PARABOLIC:
+        parabolic(bins, offset, peak_db);
+        break;
+    case VU_PEAK_INTERP_JACOBSEN:
+        jacobsen(bins, offset, peak_db);
+        break;
+    default:
+        *offset = 0.0f;
+        *peak_db = power_db(bins + 2);
+        break;
+    }
+}
@@ -0,0 +1,22 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Sub-bin spectral peak interpolation
+ *
+ * Internal to src/audio; shared by both analyzer engines.
+ */
+
+#ifndef VU_PEAK_INTERP_H
+#define VU_PEAK_INTERP_H
+
+#include "audio/analyzer.h"
+
+/*
+ * Refine the peak at bin k of a Hann-windowed spectrum from bins k - 1,
+ * k and k + 1 (`bins`: three interleaved re/im pairs, any common scale).
+ * offset: position of the true peak relative to bin k, in bins (-0.5..0.5)
+ * peak_db: its magnitude, 20 * log10 in the scale of the bins
+ */
+void vu_peak_interpolate(vu_peak_interp_t method, const float *bins,
+                         float *offset, float *peak_db);
+
+#endif /* VU_PEAK_INTERP_H */
@@ -0,0 +1,105 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Detector pipeline implementation
+ */
+
+#include "audio/pipeline.h"
+#include "util/log.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    const char *name;
+    vu_analysis_frame_cb_t process;
+    void *user_data;
+    bool needs_spectrum;
+    bool active;               /* Still subscribed in the current run */
+} pipeline_detector_t;
+
+struct vu_pipeline {
+    vu_analyzer_config_t config;
+    pipeline_detector_t detectors[VU_PIPELINE_MAX_DETECTORS];
+    int detector_count;
+    int active_count;
+};
+
+vu_pipeline_t *vu_pipeline_create(const vu_analyzer_config_t *config)
+{
+    vu_pipeline_t *pipeline = calloc(1, sizeof(vu_pipeline_t));
+    if (!pipeline) return NULL;
+
+    pipeline->config = config ? *config : vu_analyzer_default_config();
+    return pipeline;
+}
+
+void vu_pipeline_destroy(vu_pipeline_t *pipeline)
+{
+    free(pipeline);
+}
+
+bool vu_pipeline_subscribe(vu_pipeline_t *pipeline, const char *name,
+                           vu_analysis_frame_cb_t process, void *user_data,
+                           bool needs_spectrum)
+{
+    if (!pipeline || !process) return false;
+    if (pipeline->detector_count >= VU_PIPELINE_MAX_DETECTORS) return false;
+
+    pipeline->detectors[pipeline->detector_count++] = (pipeline_detector_t){
+        .name = name ? name : "detector",
+        .process = process,
+        .user_data = user_data,
+        .needs_spectrum = needs_spectrum,
+    };
+    return true;
+}
+
+int vu_pipeline_detector_count(const vu_pipeline_t *pipeline)
+{
+    return pipeline ? pipeline->detector_count : 0;
+}
+
+/* Fan one analyzed frame out to the detectors still subscribed */
+static bool dispatch_frame(void *user_data, const vu_analysis_frame_t *frame)
+{
+    vu_pipeline_t *pipeline = user_data;
+
+    for (int i = 0; i < pipeline->detector_count; i++) {
+        pipeline_detector_t *detector = &pipeline->detectors[i];
+        if (!detector->active) continue;
+
+        if (!detector->process(detector->user_data, frame)) {
+            VU_LOG_DEBUG("Pipeline: %s done at frame %zu", detector->name, frame->index);
+            detector->active = false;
+            pipeline->active_count--;
+        }
+    }
+    return pipeline->active_count > 0;
+}
+
+vu_error_t vu_pipeline_run_file(vu_pipeline_t *pipeline, const char *path,
+                                vu_analysis_summary_t *summary)
+{
+    if (summary) memset(summary, 0, sizeof(*summary));
+
+    if (!pipeline || !path) {
+        VU_SET_ERROR(VU_ERR_INVALID_ARG, "Invalid arguments");
+        return VU_ERR_INVALID_ARG;
+    }
+
+    vu_analyzer_config_t config = pipeline->config;
+    bool spectrum = false;
+    for (int i = 0; i < pipeline->detector_count; i++) {
+        pipeline->detectors[i].active = true;
+        spectrum = spectrum || pipeline->detectors[i].needs_spectrum;
+    }
+    pipeline->active_count = pipeline->detector_count;
+
+    /* Spectral detectors share the full FFT of every frame */
+    if (spectrum) {
+        config.keep_spectrum = true;
+        config.target_count = 0;
+        config.sliding_dft = false;
+    }
+
+    return vu_analyzer_analyze_file_stream(path, &config, dispatch_frame, pipeline, summary);
+}
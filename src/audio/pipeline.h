@@ -0,0 +1,63 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Detector pipeline: one analysis pass feeding several detectors
+ *
+ * Detectors subscribe a frame callback; running the pipeline over a file
+ * streams it through the analyzer once and hands every frame to each
+ * subscriber in turn. Detectors that need the spectrum (DTMF, VAD, call
+ * progress tones) read the frame's shared FFT output in place, so each
+ * one added costs only its own per-frame work, not another transform.
+ */
+
+#ifndef VU_PIPELINE_H
+#define VU_PIPELINE_H
+
+#include "audio/analyzer.h"
+#include "util/error.h"
+#include <stdbool.h>
+
+/* Most detectors one pipeline can feed */
+#define VU_PIPELINE_MAX_DETECTORS 16
+
+/* Opaque pipeline handle */
+typedef struct vu_pipeline vu_pipeline_t;
+
+/*
+ * Create a pipeline analyzing files with `config` (NULL for defaults)
+ * Returns NULL on failure.
+ */
+vu_pipeline_t *vu_pipeline_create(const vu_analyzer_config_t *config);
+
+/*
+ * Destroy pipeline (subscribed detectors are owned by the caller)
+ */
+void vu_pipeline_destroy(vu_pipeline_t *pipeline);
+
+/*
+ * Subscribe a detector. `process` gets every frame, in order, after the
+ * detectors subscribed before it; returning false unsubscribes it for the
+ * rest of the run, and the run stops once no detector is left.
+ * needs_spectrum: the detector reads frame->spectrum. The pipeline then
+ * runs the analyzer in FFT mode with keep_spectrum (one thread, no
+ * Goertzel filters, sliding DFT or result cache); otherwise the
+ * configuration is used as given.
+ * Returns false if the pipeline is full.
+ */
+bool vu_pipeline_subscribe(vu_pipeline_t *pipeline, const char *name,
+                           vu_analysis_frame_cb_t process, void *user_data,
+                           bool needs_spectrum);
+
+/*
+ * Get the number of subscribed detectors
+ */
+int vu_pipeline_detector_count(const vu_pipeline_t *pipeline);
+
+/*
+ * Analyze a WAV file, delivering each frame to the subscribed detectors
+ * summary: optional, filled in on return
+ * Returns VU_OK on success (including every detector stopping early).
+ */
+vu_error_t vu_pipeline_run_file(vu_pipeline_t *pipeline, const char *path,
+                                vu_analysis_summary_t *summary);
+
+#endif /* VU_PIPELINE_H */
@@ -0,0 +1,252 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Built-in real FFT implementation
+ *
+ * With z[j] = x[2j] + i x[2j+1] and Z its M = N/2 point DFT,
+ *   X[k] = E[k] + W^k O[k],  E[k] = (Z[k] + Z*[M-k]) / 2,
+ *                            O[k] = (Z[k] - Z*[M-k]) / 2i,  W = e^{-2 pi i/N}
+ * where E and O are the DFTs of the even and odd samples.
+ *
+ * Z is computed in place by decimation-in-time passes on split re/im
+ * arrays. Their input must be in digit-reversed order, so the packing
+ * step reads the samples through a precomputed index table and runs the
+ * first (twiddle-free) radix-4 pass as it goes; the output comes out in
+ * natural order, which lets the split step read Z[k] and Z[M-k] as
+ * vectors.
+ */
+
+#include "audio/real_fft.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <sched.h>
+#include <math.h>
+
+#define MAX_PASSES 32
+#define STACK_POINTS 2048          /* Complex points of scratch kept on the stack */
+#define SCRATCH_SLOTS 8            /* Larger sizes: scratch blocks per transform */
+
+typedef struct {
+    int radix;                 /* 2 or 4 */
+    size_t span;               /* Group length in complex points */
+    const float *twiddles;     /* Kernel layout, see analyzer_simd.h */
+} fft_pass_t;
+
+struct vu_rfft {
+    int size;                  /* N */
+    size_t half;               /* M = N/2 */
+    const vu_analyzer_kernels_t *kernels;
+
+    /* In execution order, narrowest span first */
+    int pass_count;
+    fft_pass_t passes[MAX_PASSES];
+    bool first_radix4;         /* passes[0] is the span-4 pass run while packing */
+
+    size_t *source;            /* source[p]: index of the z point packed at p */
+    float *split;              /* e^{-2 pi i k/N}: re block then im block */
+    float *twiddles;           /* All passes' twiddles, one block */
+
+    /* M > STACK_POINTS: SCRATCH_SLOTS blocks of 2M floats, one per
+     * concurrent execution, claimed through a bit each in scratch_busy */
+    float *scratch;
+    atomic_uint scratch_busy;
+};
+
+/* Twiddles of one pass over groups of `span`: for each quarter (or half)
+ * q > 0, W_span^{qj} for j in the quarter, re block then im block */
+static float *fill_twiddles(float *w, int radix, size_t span)
+{
+    size_t part = span / radix;
+
+    for (int q = 1; q < radix; q++) {
+        for (size_t j = 0; j < part; j++) {
+            double angle = 2.0 * M_PI * (double)(q * j) / (double)span;
+            w[j] = (float)cos(angle);
+            w[part + j] = (float)-sin(angle);
+        }
+        w += 2 * part;
+    }
+    return w;
+}
+
+vu_rfft_t *vu_rfft_create(int size, const vu_analyzer_kernels_t *kernels)
+{
+    if (size < 2 || (size & (size - 1)) != 0) return NULL;
+
+    vu_rfft_t *rfft = calloc(1, sizeof(vu_rfft_t));
+    if (!rfft) return NULL;
+
+    size_t m = (size_t)size / 2;
+    rfft->size = size;
+    rfft->half = m;
+    rfft->kernels = kernels ? kernels : vu_analyzer_kernels();
+
+    /* Radix-4 throughout, plus a last radix-2 pass if M is an odd power
+     * of two (the widest span, so it vectorizes fully) */
+    size_t twiddle_count = 0;
+    size_t span = 4;
+    for (; span <= m; span *= 4) {
+        rfft->passes[rfft->pass_count++] = (fft_pass_t){ 4, span, NULL };
+        twiddle_count += span / 4 * 6;
+    }
+    if (span / 4 < m) {
+        rfft->passes[rfft->pass_count++] = (fft_pass_t){ 2, m, NULL };
+        twiddle_count += m;
+    }
+    rfft->first_radix4 = rfft->pass_count > 0 && rfft->passes[0].radix == 4;
+
+    rfft->source = malloc(m * sizeof(size_t));
+    rfft->split = malloc(2 * m * sizeof(float));
+    rfft->twiddles = malloc((twiddle_count > 0 ? twiddle_count : 1) * sizeof(float));
+    if (m > STACK_POINTS) {
+        rfft->scratch = malloc(SCRATCH_SLOTS * 2 * m * sizeof(float));
+    }
+    atomic_init(&rfft->scratch_busy, 0);
+    if (!rfft->source || !rfft->split || !rfft->twiddles ||
+        (m > STACK_POINTS && !rfft->scratch)) {
+        vu_rfft_destroy(rfft);
+        return NULL;
+    }
+
+    float *w = rfft->twiddles;
+    for (int p = 0; p < rfft->pass_count; p++) {
+        rfft->passes[p].twiddles = w;
+        w = fill_twiddles(w, rfft->passes[p].radix, rfft->passes[p].span);
+    }
+
+    /* The widest pass combines the transforms of the points with each
+     * residue d (mod its radix r), found at offset d * M/r, and so on
+     * down: position p's digits, most significant first, are the source
+     * index's digits least significant first */
+    for (size_t p = 0; p < m; p++) {
+        size_t rest = p, k = 0, weight = 1, group = m;
+        for (int i = rfft->pass_count - 1; i >= 0; i--) {
+            int radix = rfft->passes[i].radix;
+            group /= radix;
+            k += rest / group * weight;
+            rest %= group;
+            weight *= radix;
+        }
+        rfft->source[p] = k;
+    }
+
+    for (size_t k = 0; k < m; k++) {
+        double angle = 2.0 * M_PI * (double)k / size;
+        rfft->split[k] = (float)cos(angle);
+        rfft->split[m + k] = (float)-sin(angle);
+    }
+
+    return rfft;
+}
+
+void vu_rfft_destroy(vu_rfft_t *rfft)
+{
+    if (!rfft) return;
+
+    free(rfft->source);
+    free(rfft->split);
+    free(rfft->twiddles);
+    free(rfft->scratch);
+    free(rfft);
+}
+
+/* Pack z in digit-reversed order, running the twiddle-free span-4 pass
+ * on each group of four as it is loaded */
+static void pack_radix4(const vu_rfft_t *rfft, const float *in, float *re, float *im)
+{
+    const size_t *source = rfft->source;
+
+    for (size_t g = 0; g < rfft->half; g += 4) {
+        const float *a = in + 2 * source[g], *b = in + 2 * source[g + 1];
+        const float *c = in + 2 * source[g + 2], *d = in + 2 * source[g + 3];
+
+        float apc_r = a[0] + c[0], apc_i = a[1] + c[1];
+        float amc_r = a[0] - c[0], amc_i = a[1] - c[1];
+        float bpd_r = b[0] + d[0], bpd_i = b[1] + d[1];
+        float bmd_r = b[0] - d[0], bmd_i = b[1] - d[1];
+
+        re[g] = apc_r + bpd_r;
+        im[g] = apc_i + bpd_i;
+        re[g + 1] = amc_r + bmd_i;
+        im[g + 1] = amc_i - bmd_r;
+        re[g + 2] = apc_r - bpd_r;
+        im[g + 2] = apc_i - bpd_i;
+        re[g + 3] = amc_r - bmd_i;
+        im[g + 3] = amc_i + bmd_r;
+    }
+}
+
+/*
+ * Scratch for one execution of a transform larger than the stack buffer:
+ * a free slot of the transform's own, else (more threads than slots) a
+ * fresh block, else wait for a slot to come free. Never fails. Returns
+ * the slot taken, or -1 for a block to free.
+ */
+static int claim_scratch(const vu_rfft_t *rfft, float **scratch)
+{
+    /* The transform is shared read-only apart from this word */
+    atomic_uint *busy = (atomic_uint *)&rfft->scratch_busy;
+
+    for (bool allocate = true;; allocate = false) {
+        unsigned mask = atomic_load_explicit(busy, memory_order_relaxed);
+        for (int s = 0; s < SCRATCH_SLOTS; s++) {
+            while (!(mask & (1u << s))) {
+                if (atomic_compare_exchange_weak_explicit(busy, &mask, mask | (1u << s),
+                                                          memory_order_acquire,
+                                                          memory_order_relaxed)) {
+                    *scratch = rfft->scratch + (size_t)s * 2 * rfft->half;
+                    return s;
+                }
+            }
+        }
+        if (allocate) {
+            *scratch = malloc(2 * rfft->half * sizeof(float));
+            if (*scratch) return -1;
+        }
+        sched_yield();
+    }
+}
+
+static void release_scratch(const vu_rfft_t *rfft, int slot, float *scratch)
+{
+    if (slot < 0) {
+        free(scratch);
+        return;
+    }
+    atomic_fetch_and_explicit((atomic_uint *)&rfft->scratch_busy, ~(1u << slot),
+                              memory_order_release);
+}
+
+void vu_rfft_execute(const vu_rfft_t *rfft, const float *in, float *out)
+{
+    size_t m = rfft->half;
+    float stack[2 * STACK_POINTS];
+    float *re = stack;
+    int slot = 0;
+    if (m > STACK_POINTS) slot = claim_scratch(rfft, &re);
+    float *im = re + m;
+
+    int first = 0;
+    if (rfft->first_radix4) {
+        pack_radix4(rfft, in, re, im);
+        first = 1;
+    } else {
+        for (size_t p = 0; p < m; p++) {
+            re[p] = in[2 * rfft->source[p]];
+            im[p] = in[2 * rfft->source[p] + 1];
+        }
+    }
+
+    for (int p = first; p < rfft->pass_count; p++) {
+        const fft_pass_t *pass = &rfft->passes[p];
+        if (pass->radix == 4) {
+            rfft->kernels->fft_radix4(re, im, m, pass->span, pass->twiddles);
+        } else {
+            rfft->kernels->fft_radix2(re, im, m, pass->span, pass->twiddles);
+        }
+    }
+
+    rfft->kernels->fft_split(out, re, im, m, rfft->split);
+
+    if (re != stack) release_scratch(rfft, slot, re);
+}
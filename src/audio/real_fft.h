@@ -0,0 +1,42 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Built-in real FFT
+ *
+ * Power-of-two real-to-complex transform for the analyzer's frame sizes,
+ * the FFT backend when the build does not use FFTW. The N real inputs are
+ * packed as N/2 complex points, transformed by radix-4 passes (plus one
+ * radix-2 pass when N/2 is not a power of four) and split back into the
+ * real spectrum. Twiddles and the output order are precomputed per size;
+ * the passes run on the SIMD kernels of vu_analyzer_kernels().
+ */
+
+#ifndef VU_REAL_FFT_H
+#define VU_REAL_FFT_H
+
+#include "audio/analyzer_simd.h"
+
+/* Opaque transform of one size */
+typedef struct vu_rfft vu_rfft_t;
+
+/*
+ * Create a transform of `size` points (a power of two, at least 2).
+ * kernels: pass implementation, NULL for the best this CPU supports.
+ * Returns NULL on failure.
+ */
+vu_rfft_t *vu_rfft_create(int size, const vu_analyzer_kernels_t *kernels);
+
+/*
+ * Destroy transform and free resources
+ */
+void vu_rfft_destroy(vu_rfft_t *rfft);
+
+/*
+ * Transform `in` (size reals) into `out` (size/2 + 1 interleaved re/im
+ * pairs, unnormalized like FFTW's r2c). `in` is not modified. Thread-safe:
+ * any number of threads may execute one transform. Sizes above 4096 work
+ * in scratch blocks allocated with the transform, so no call allocates
+ * unless more threads than blocks run at once.
+ */
+void vu_rfft_execute(const vu_rfft_t *rfft, const float *in, float *out);
+
+#endif /* VU_REAL_FFT_H */
@@ -1,28 +1,65 @@
 /*
  * voip-utility - SIP VoIP Testing Utility
- * WAV recorder (stub implementation)
+ * WAV recorder implementation
  */
 
 #include "audio/recorder.h"
 #include "util/log.h"
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#ifdef VU_HAVE_LIBURING
+#include <liburing.h>
+#endif
 
-struct vu_recorder {
-    FILE *fp;
-    uint32_t sample_rate;
-    int channels;
-    uint32_t samples_written;
-    char path[512];
-};
+/* Largest data chunk a plain RIFF header can describe: the RIFF size
+ * (data plus the rest of the header) must fit in 32 bits */
+#define RIFF_MAX_DATA (UINT32_MAX - (sizeof(wav_header_t) - 8))
+
+/* Header size fields while recording: a reader of an unfinished file
+ * (e.g. after a crash) takes the data to run to the end of the file */
+#define SIZE_UNKNOWN UINT32_MAX
 
-/* WAV header structure */
+/* Buffers per recorder, each a multiple of the page size so every full
+ * buffer lands at an aligned file offset (the header rides at the start
+ * of the first). The writer thread double-buffers 1 MB; io_uring keeps
+ * more, smaller writes in flight so hundreds of recordings stay within a
+ * few hundred MB. */
+#define THREAD_BUFFERS      2
+#define THREAD_BUFFER_BYTES (1024 * 1024)
+#define URING_BUFFERS       4
+#define URING_BUFFER_BYTES  (256 * 1024)
+#define MAX_BUFFERS         4
+#define BUFFER_ALIGN        4096
+
+/* Disk space reserved ahead of the writes, so a long recording's blocks
+ * are allocated in large extents rather than one write at a time */
+#define PREALLOC_BYTES (16 * 1024 * 1024)
+
+/* Shared submission ring, and how long its thread waits for completions
+ * before taking new writes */
+#define URING_ENTRIES  256
+#define URING_POLL_MS  2
+
+/* WAV header structure. The JUNK chunk reserves room for the RF64 ds64
+ * chunk, so a recording that passes 4 GB becomes RF64 (EBU Tech 3306)
+ * by rewriting the header in place when it is closed. */
 #pragma pack(push, 1)
 typedef struct {
-    char riff[4];
+    char riff[4];              /* "RIFF", or "RF64" past 4 GB */
     uint32_t file_size;
     char wave[4];
+    char ds64[4];              /* "JUNK", or "ds64" past 4 GB */
+    uint32_t ds64_size;
+    uint64_t riff_size64;
+    uint64_t data_size64;
+    uint64_t sample_count64;
+    uint32_t table_length;
     char fmt[4];
     uint32_t fmt_size;
     uint16_t audio_format;
@@ -36,28 +73,553 @@ typedef struct {
 } wav_header_t;
 #pragma pack(pop)
 
+/* One write handed to the backend: a full buffer, or the final header */
+typedef struct write_req {
+    struct vu_recorder *rec;
+    const uint8_t *data;
+    size_t len;                /* Still to write */
+    size_t total;              /* Length as handed off */
+    uint64_t offset;
+    int buffer;                /* Buffer index, or -1 for the header */
+    struct write_req *next;
+} write_req_t;
+
+/*
+ * Samples are copied into the active buffer on the caller's thread; a
+ * full buffer is handed to the backend, which writes it while the next
+ * one fills. The caller only waits if the buffer it moves on to is still
+ * being written (a disk a whole set of buffers behind).
+ */
+struct vu_recorder {
+    int fd;
+    vu_recorder_backend_t backend;
+    wav_header_t header;       /* As written; finalized on close */
+    wav_header_t final_header;
+    uint32_t sample_rate;
+    int channels;
+    uint64_t data_bytes;       /* Accepted by vu_recorder_write */
+    char path[512];
+
+    uint8_t *buffers[MAX_BUFFERS];
+    int buffer_count;
+    size_t buffer_bytes;
+    int active;                /* Being filled by the caller */
+    size_t fill;
+    uint64_t active_offset;    /* Where the active buffer goes */
+
+    /* Write state, shared with the backend */
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    write_req_t reqs[MAX_BUFFERS + 1];   /* One per buffer, then the header */
+    bool busy[MAX_BUFFERS];
+    int queue_depth;           /* Buffers handed off and not yet written */
+    int max_queue_depth;
+    uint64_t bytes_written;
+    uint64_t file_end;         /* End of the furthest write */
+    uint64_t reserved;         /* End of the preallocated space */
+    unsigned stalls;           /* Times the caller waited for the disk */
+    bool closing;
+    bool header_queued;
+    bool finished;             /* Closed on disk */
+    bool detached;             /* Closed with close_async: the backend frees */
+    atomic_bool io_error;      /* A write failed */
+
+    /* Writer thread backend */
+    pthread_t writer;
+    write_req_t *queue;
+    write_req_t **queue_tail;
+};
+
+static vu_recorder_backend_t g_backend = VU_RECORDER_BACKEND_THREAD;
+
+/* Reserve space past the writes without changing the file size, so an
+ * unfinished file still ends where its data does */
+static void preallocate(vu_recorder_t *rec, uint64_t end)
+{
+#ifdef FALLOC_FL_KEEP_SIZE
+    if (end <= rec->reserved) return;
+    if (fallocate(rec->fd, FALLOC_FL_KEEP_SIZE, (off_t)rec->reserved, PREALLOC_BYTES) == 0) {
+        rec->reserved += PREALLOC_BYTES;
+    } else {
+        /* Unsupported here (e.g. tmpfs): plain writes still work */
+        rec->reserved = UINT64_MAX;
+    }
+#else
+    (void)rec;
+    (void)end;
+#endif
+}
+
+static bool write_all(int fd, const uint8_t *data, size_t len, uint64_t offset)
+{
+    while (len > 0) {
+        ssize_t n = pwrite(fd, data, len, (off_t)offset);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        len -= (size_t)n;
+        offset += (uint64_t)n;
+    }
+    return true;
+}
+
+/* Final sizes: plain RIFF while they fit, RF64 beyond */
+static void build_final_header(vu_recorder_t *recorder)
+{
+    wav_header_t header = recorder->header;
+
+    /* Whole 16-bit samples only, so the data chunk never needs the pad
+     * byte an odd-sized chunk would */
+    uint64_t data_size = recorder->data_bytes;
+    uint64_t riff_size = sizeof(header) - 8 + data_size;
+
+    if (data_size <= RIFF_MAX_DATA) {
+        header.file_size = (uint32_t)riff_size;
+        header.data_size = (uint32_t)data_size;
+    } else {
+        memcpy(header.riff, "RF64", 4);
+        header.file_size = SIZE_UNKNOWN;
+        memcpy(header.ds64, "ds64", 4);
+        header.riff_size64 = riff_size;
+        header.data_size64 = data_size;
+        header.sample_count64 = data_size / header.block_align;
+        header.table_length = 0;
+        header.data_size = SIZE_UNKNOWN;
+    }
+
+    recorder->final_header = header;
+}
+
+/* Record a finished buffer write (rec->mutex held) */
+static void complete_write(vu_recorder_t *rec, write_req_t *req, bool ok, int err)
+{
+    if (!ok && !atomic_exchange(&rec->io_error, true)) {
+        VU_LOG_ERROR("Failed to write %s: %s", rec->path, strerror(err));
+    }
+
+    uint64_t end = req->offset + req->len;
+    if (end > rec->file_end) rec->file_end = end;
+    if (ok) rec->bytes_written += req->total;
+
+    rec->busy[req->buffer] = false;
+    rec->queue_depth--;
+    pthread_cond_broadcast(&rec->cond);
+}
+
+/* Trim the reservation past the data and close the file */
+static void close_file(vu_recorder_t *rec)
+{
+    if (ftruncate(rec->fd, (off_t)rec->file_end) != 0) {
+        VU_LOG_WARN("Failed to trim %s: %s", rec->path, strerror(errno));
+    }
+    close(rec->fd);
+
+    if (rec->stalls > 0) {
+        VU_LOG_WARN("Recording %s waited %u time(s) for the disk", rec->path, rec->stalls);
+    }
+    VU_LOG_INFO("Saved WAV: %s (%.2fs%s)", rec->path, vu_recorder_get_duration(rec),
+                rec->data_bytes > RIFF_MAX_DATA ? ", RF64" : "");
+}
+
+static void free_recorder(vu_recorder_t *rec)
+{
+    pthread_cond_destroy(&rec->cond);
+    pthread_mutex_destroy(&rec->mutex);
+    for (int i = 0; i < rec->buffer_count; i++) free(rec->buffers[i]);
+    free(rec);
+}
+
+/* ----- Writer thread backend: one thread per recorder ----- */
+
+static void *writer_run(void *arg)
+{
+    vu_recorder_t *rec = arg;
+
+    pthread_mutex_lock(&rec->mutex);
+    for (;;) {
+        while (!rec->queue && !rec->closing) {
+            pthread_cond_wait(&rec->cond, &rec->mutex);
+        }
+        write_req_t *req = rec->queue;
+        if (!req) break;
+        rec->queue = req->next;
+        if (!rec->queue) rec->queue_tail = &rec->queue;
+        pthread_mutex_unlock(&rec->mutex);
+
+        preallocate(rec, req->offset + req->len);
+        bool ok = write_all(rec->fd, req->data, req->len, req->offset);
+        int err = errno;
+
+        pthread_mutex_lock(&rec->mutex);
+        complete_write(rec, req, ok, err);
+    }
+    pthread_mutex_unlock(&rec->mutex);
+    return NULL;
+}
+
+/* ----- io_uring backend: one ring and thread for all recorders ----- */
+
+#ifdef VU_HAVE_LIBURING
+
+static struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;       /* New writes, and recordings finished */
+    bool started;
+    bool stop;
+    pthread_t thread;
+    struct io_uring ring;
+    write_req_t *queue;        /* Waiting for a submission slot */
+    write_req_t **queue_tail;
+    int in_flight;             /* Submitted, not yet completed */
+    int closing;               /* Recordings closed, not yet finished */
+} g_uring = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+    .queue_tail = &g_uring.queue
+};
+
+/* Queue a write for the ring thread (g_uring.mutex held) */
+static void uring_queue_locked(write_req_t *req)
+{
+    req->next = NULL;
+    *g_uring.queue_tail = req;
+    g_uring.queue_tail = &req->next;
+    pthread_cond_broadcast(&g_uring.cond);
+}
+
+static void uring_queue(write_req_t *req)
+{
+    pthread_mutex_lock(&g_uring.mutex);
+    uring_queue_locked(req);
+    pthread_mutex_unlock(&g_uring.mutex);
+}
+
+/* The header was written: close the file and release the recording */
+static void uring_finish(vu_recorder_t *rec, bool ok, int err)
+{
+    if (!ok) VU_LOG_WARN("Failed to finalize WAV header: %s (%s)", rec->path, strerror(err));
+    close_file(rec);
+
+    pthread_mutex_lock(&rec->mutex);
+    bool detached = rec->detached;
+    rec->finished = true;
+    pthread_cond_broadcast(&rec->cond);
+    pthread_mutex_unlock(&rec->mutex);
+
+    /* A waiting vu_recorder_destroy frees it otherwise */
+    if (detached) free_recorder(rec);
+
+    pthread_mutex_lock(&g_uring.mutex);
+    g_uring.closing--;
+    pthread_cond_broadcast(&g_uring.cond);
+    pthread_mutex_unlock(&g_uring.mutex);
+}
+
+/* Queue the final header once every buffer of a closing recording is
+ * on disk (rec->mutex held) */
+static void uring_queue_header_locked(vu_recorder_t *rec)
+{
+    if (!rec->closing || rec->header_queued || rec->queue_depth > 0) return;
+
+    write_req_t *req = &rec->reqs[MAX_BUFFERS];
+    req->rec = rec;
+    req->data = (const uint8_t *)&rec->final_header;
+    req->len = sizeof(rec->final_header);
+    req->total = req->len;
+    req->offset = 0;
+    req->buffer = -1;
+    rec->header_queued = true;
+    uring_queue(req);
+}
+
+static void uring_complete(struct io_uring_cqe *cqe)
+{
+    write_req_t *req = io_uring_cqe_get_data(cqe);
+    vu_recorder_t *rec = req->rec;
+    int res = cqe->res;
+
+    /* Retry interrupted and short writes with what is left */
+    if (res == -EINTR || res == -EAGAIN) {
+        uring_queue(req);
+        return;
+    }
+    if (res > 0 && (size_t)res < req->len) {
+        req->data += res;
+        req->len -= (size_t)res;
+        req->offset += (uint64_t)res;
+        uring_queue(req);
+        return;
+    }
+
+    bool ok = res >= 0;
+    if (req->buffer < 0) {
+        uring_finish(rec, ok, -res);
+        return;
+    }
+
+    pthread_mutex_lock(&rec->mutex);
+    complete_write(rec, req, ok, -res);
+    uring_queue_header_locked(rec);
+    pthread_mutex_unlock(&rec->mutex);
+}
+
+/*
+ * Take every queued write, submit them in one batch, then reap what has
+ * completed. Completions are waited for briefly so writes queued in the
+ * meantime are picked up without a wakeup from the recorders.
+ */
+static void *uring_run(void *arg)
+{
+    (void)arg;
+
+    for (;;) {
+        pthread_mutex_lock(&g_uring.mutex);
+        while (!g_uring.queue && g_uring.in_flight == 0 && !g_uring.stop) {
+            pthread_cond_wait(&g_uring.cond, &g_uring.mutex);
+        }
+        if (!g_uring.queue && g_uring.in_flight == 0) {
+            pthread_mutex_unlock(&g_uring.mutex);
+            break;
+        }
+        write_req_t *list = g_uring.queue;
+        g_uring.queue = NULL;
+        g_uring.queue_tail = &g_uring.queue;
+        pthread_mutex_unlock(&g_uring.mutex);
+
+        int submitted = 0;
+        while (list) {
+            struct io_uring_sqe *sqe = io_uring_get_sqe(&g_uring.ring);
+            if (!sqe) {
+                /* Ring full: submit what is prepared, keep the rest */
+                io_uring_submit(&g_uring.ring);
+                sqe = io_uring_get_sqe(&g_uring.ring);
+                if (!sqe) break;
+            }
+            write_req_t *req = list;
+            list = req->next;
+
+            if (req->buffer >= 0) preallocate(req->rec, req->offset + req->len);
+            io_uring_prep_write(sqe, req->rec->fd, req->data, (unsigned)req->len, req->offset);
+            io_uring_sqe_set_data(sqe, req);
+            submitted++;
+        }
+        if (submitted > 0) io_uring_submit(&g_uring.ring);
+
+        pthread_mutex_lock(&g_uring.mutex);
+        g_uring.in_flight += submitted;
+        while (list) {
+            write_req_t *req = list;
+            list = req->next;
+            uring_queue_locked(req);
+        }
+        int in_flight = g_uring.in_flight;
+        pthread_mutex_unlock(&g_uring.mutex);
+        if (in_flight == 0) continue;
+
+        struct io_uring_cqe *cqe;
+        struct __kernel_timespec wait = { .tv_sec = 0, .tv_nsec = URING_POLL_MS * 1000000L };
+        if (io_uring_wait_cqe_timeout(&g_uring.ring, &cqe, &wait) != 0) continue;
+
+        int reaped = 0;
+        while (io_uring_peek_cqe(&g_uring.ring, &cqe) == 0) {
+            uring_complete(cqe);
+            io_uring_cqe_seen(&g_uring.ring, cqe);
+            reaped++;
+        }
+
+        pthread_mutex_lock(&g_uring.mutex);
+        g_uring.in_flight -= reaped;
+        pthread_mutex_unlock(&g_uring.mutex);
+    }
+    return NULL;
+}
+
+static vu_error_t uring_start(void)
+{
+    pthread_mutex_lock(&g_uring.mutex);
+    vu_error_t err = VU_OK;
+    if (!g_uring.started) {
+        int ret = io_uring_queue_init(URING_ENTRIES, &g_uring.ring, 0);
+        if (ret < 0) {
+            VU_SET_ERROR(VU_ERR_NOT_SUPPORTED, "io_uring unavailable: %s", strerror(-ret));
+            err = VU_ERR_NOT_SUPPORTED;
+        } else if (pthread_create(&g_uring.thread, NULL, uring_run, NULL) != 0) {
+            io_uring_queue_exit(&g_uring.ring);
+            VU_SET_ERROR(VU_ERR_NO_MEMORY, "Failed to start io_uring writer");
+            err = VU_ERR_NO_MEMORY;
+        } else {
+            g_uring.started = true;
+            g_uring.stop = false;
+        }
+    }
+    pthread_mutex_unlock(&g_uring.mutex);
+    return err;
+}
+
+static void uring_stop(void)
+{
+    pthread_mutex_lock(&g_uring.mutex);
+    if (!g_uring.started) {
+        pthread_mutex_unlock(&g_uring.mutex);
+        return;
+    }
+    /* Recordings closed asynchronously still finish */
+    while (g_uring.closing > 0) pthread_cond_wait(&g_uring.cond, &g_uring.mutex);
+    g_uring.stop = true;
+    pthread_cond_broadcast(&g_uring.cond);
+    pthread_mutex_unlock(&g_uring.mutex);
+
+    pthread_join(g_uring.thread, NULL);
+    io_uring_queue_exit(&g_uring.ring);
+
+    pthread_mutex_lock(&g_uring.mutex);
+    g_uring.started = false;
+    pthread_mutex_unlock(&g_uring.mutex);
+}
+
+#endif /* VU_HAVE_LIBURING */
+
+/* ----- Common ----- */
+
+/* Give the active buffer to the backend and move on to the next one,
+ * waiting if it is still being written unless `last` */
+static void hand_off(vu_recorder_t *rec, bool last)
+{
+    write_req_t *req = &rec->reqs[rec->active];
+    req->rec = rec;
+    req->data = rec->buffers[rec->active];
+    req->len = rec->fill;
+    req->total = rec->fill;
+    req->offset = rec->active_offset;
+    req->buffer = rec->active;
+    req->next = NULL;
+
+    pthread_mutex_lock(&rec->mutex);
+    rec->busy[rec->active] = true;
+    if (++rec->queue_depth > rec->max_queue_depth) rec->max_queue_depth = rec->queue_depth;
+    if (rec->backend == VU_RECORDER_BACKEND_THREAD) {
+        *rec->queue_tail = req;
+        rec->queue_tail = &req->next;
+        pthread_cond_broadcast(&rec->cond);
+    }
+    pthread_mutex_unlock(&rec->mutex);
+
+#ifdef VU_HAVE_LIBURING
+    if (rec->backend == VU_RECORDER_BACKEND_IO_URING) uring_queue(req);
+#endif
+
+    rec->active_offset += rec->fill;
+    rec->active = (rec->active + 1) % rec->buffer_count;
+    rec->fill = 0;
+    if (last) return;
+
+    pthread_mutex_lock(&rec->mutex);
+    if (rec->busy[rec->active]) {
+        rec->stalls++;
+        while (rec->busy[rec->active]) pthread_cond_wait(&rec->cond, &rec->mutex);
+    }
+    pthread_mutex_unlock(&rec->mutex);
+}
+
+vu_error_t vu_recorder_set_backend(vu_recorder_backend_t backend)
+{
+    if (backend == VU_RECORDER_BACKEND_THREAD) {
+        g_backend = backend;
+        return VU_OK;
+    }
+    if (backend != VU_RECORDER_BACKEND_IO_URING) {
+        VU_SET_ERROR(VU_ERR_INVALID_ARG, "Unknown recorder backend %d", (int)backend);
+        return VU_ERR_INVALID_ARG;
+    }
+
+#ifdef VU_HAVE_LIBURING
+    vu_error_t err = uring_start();
+    if (err == VU_OK) g_backend = backend;
+    return err;
+#else
+    VU_SET_ERROR(VU_ERR_NOT_SUPPORTED, "Built without liburing");
+    return VU_ERR_NOT_SUPPORTED;
+#endif
+}
+
+vu_recorder_backend_t vu_recorder_get_backend(void)
+{
+    return g_backend;
+}
+
+vu_recorder_backend_t vu_recorder_backend_from_string(const char *name)
+{
+    if (name && (strcmp(name, "io_uring") == 0 || strcmp(name, "uring") == 0)) {
+        return VU_RECORDER_BACKEND_IO_URING;
+    }
+    return VU_RECORDER_BACKEND_THREAD;
+}
+
+void vu_recorder_shutdown(void)
+{
+#ifdef VU_HAVE_LIBURING
+    uring_stop();
+#endif
+    g_backend = VU_RECORDER_BACKEND_THREAD;
+}
+
 vu_recorder_t *vu_recorder_create(const char *path, uint32_t sample_rate, int channels)
 {
-    if (!path) return NULL;
+    if (!path || channels <= 0) return NULL;
 
     vu_recorder_t *rec = calloc(1, sizeof(vu_recorder_t));
     if (!rec) return NULL;
 
-    rec->fp = fopen(path, "wb");
-    if (!rec->fp) {
-        VU_LOG_ERROR("Failed to open %s for writing", path);
+    rec->backend = g_backend;
+    bool uring = rec->backend == VU_RECORDER_BACKEND_IO_URING;
+    rec->buffer_count = uring ? URING_BUFFERS : THREAD_BUFFERS;
+    rec->buffer_bytes = uring ? URING_BUFFER_BYTES : THREAD_BUFFER_BYTES;
+    rec->queue_tail = &rec->queue;
+
+    for (int i = 0; i < rec->buffer_count; i++) {
+        if (posix_memalign((void **)&rec->buffers[i], BUFFER_ALIGN, rec->buffer_bytes) != 0) {
+            rec->buffers[i] = NULL;
+        }
+        if (!rec->buffers[i]) {
+            VU_LOG_ERROR("Failed to allocate recording buffers for %s", path);
+            for (int j = 0; j < i; j++) free(rec->buffers[j]);
+            free(rec);
+            return NULL;
+        }
+    }
+
+    bool sync_ok = pthread_mutex_init(&rec->mutex, NULL) == 0;
+    if (sync_ok && pthread_cond_init(&rec->cond, NULL) != 0) {
+        pthread_mutex_destroy(&rec->mutex);
+        sync_ok = false;
+    }
+    if (!sync_ok) {
+        for (int i = 0; i < rec->buffer_count; i++) free(rec->buffers[i]);
         free(rec);
         return NULL;
     }
 
+    rec->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (rec->fd < 0) {
+        VU_LOG_ERROR("Failed to open %s for writing", path);
+        free_recorder(rec);
+        return NULL;
+    }
+
     rec->sample_rate = sample_rate;
     rec->channels = channels;
     strncpy(rec->path, path, sizeof(rec->path) - 1);
 
-    /* Write placeholder header */
-    wav_header_t header = {0};
+    /* Placeholder header */
+    wav_header_t header;
+    memset(&header, 0, sizeof(header));
     memcpy(header.riff, "RIFF", 4);
+    header.file_size = SIZE_UNKNOWN;
     memcpy(header.wave, "WAVE", 4);
+    memcpy(header.ds64, "JUNK", 4);
+    header.ds64_size = 28;
     memcpy(header.fmt, "fmt ", 4);
     header.fmt_size = 16;
     header.audio_format = 1;  /* PCM */
@@ -67,51 +629,135 @@ vu_recorder_t *vu_recorder_create(const char *path, uint32_t sample_rate, int ch
     header.block_align = channels * 2;
     header.byte_rate = sample_rate * channels * 2;
     memcpy(header.data, "data", 4);
+    header.data_size = SIZE_UNKNOWN;
 
-    fwrite(&header, sizeof(header), 1, rec->fp);
+    /* The header goes out with the first buffer */
+    rec->header = header;
+    memcpy(rec->buffers[0], &header, sizeof(header));
+    rec->fill = sizeof(header);
 
-    VU_LOG_DEBUG("Created WAV recorder: %s", path);
+    if (!uring && pthread_create(&rec->writer, NULL, writer_run, rec) != 0) {
+        VU_LOG_ERROR("Failed to start recording writer for %s", path);
+        close(rec->fd);
+        unlink(path);
+        free_recorder(rec);
+        return NULL;
+    }
+
+    VU_LOG_DEBUG("Created WAV recorder: %s (%s)", path, uring ? "io_uring" : "writer thread");
     return rec;
 }
 
+/*
+ * Hand over what is buffered and start closing. With io_uring the header
+ * is queued behind the last buffer, and a detached recorder may be freed
+ * by the ring thread as soon as this returns.
+ */
+static void begin_close(vu_recorder_t *recorder, bool detached)
+{
+    build_final_header(recorder);
+    if (recorder->fill > 0) hand_off(recorder, true);
+
+#ifdef VU_HAVE_LIBURING
+    if (recorder->backend == VU_RECORDER_BACKEND_IO_URING) {
+        pthread_mutex_lock(&g_uring.mutex);
+        g_uring.closing++;
+        pthread_mutex_unlock(&g_uring.mutex);
+    }
+#endif
+
+    pthread_mutex_lock(&recorder->mutex);
+    recorder->closing = true;
+    recorder->detached = detached;
+#ifdef VU_HAVE_LIBURING
+    if (recorder->backend == VU_RECORDER_BACKEND_IO_URING) uring_queue_header_locked(recorder);
+#endif
+    pthread_cond_broadcast(&recorder->cond);
+    pthread_mutex_unlock(&recorder->mutex);
+}
+
 void vu_recorder_destroy(vu_recorder_t *recorder)
 {
     if (!recorder) return;
 
-    if (recorder->fp) {
-        /* Update header with final sizes */
-        uint32_t data_size = recorder->samples_written * recorder->channels * 2;
-        uint32_t file_size = data_size + sizeof(wav_header_t) - 8;
+#ifdef VU_HAVE_LIBURING
+    if (recorder->backend == VU_RECORDER_BACKEND_IO_URING) {
+        begin_close(recorder, false);
 
-        fseek(recorder->fp, 4, SEEK_SET);
-        fwrite(&file_size, 4, 1, recorder->fp);
-        fseek(recorder->fp, 40, SEEK_SET);
-        fwrite(&data_size, 4, 1, recorder->fp);
+        pthread_mutex_lock(&recorder->mutex);
+        while (!recorder->finished) pthread_cond_wait(&recorder->cond, &recorder->mutex);
+        pthread_mutex_unlock(&recorder->mutex);
+        free_recorder(recorder);
+        return;
+    }
+#endif
 
-        fclose(recorder->fp);
-        VU_LOG_INFO("Saved WAV: %s (%.2fs)", recorder->path,
-                    (double)recorder->samples_written / recorder->sample_rate);
+    begin_close(recorder, false);
+    pthread_join(recorder->writer, NULL);
+
+    const wav_header_t *header = &recorder->final_header;
+    if (!write_all(recorder->fd, (const uint8_t *)header, sizeof(*header), 0)) {
+        VU_LOG_WARN("Failed to finalize WAV header: %s", recorder->path);
     }
+    close_file(recorder);
+    free_recorder(recorder);
+}
+
+void vu_recorder_close_async(vu_recorder_t *recorder)
+{
+    if (!recorder) return;
 
-    free(recorder);
+#ifdef VU_HAVE_LIBURING
+    if (recorder->backend == VU_RECORDER_BACKEND_IO_URING) {
+        /* The ring thread frees it once the header is written */
+        begin_close(recorder, true);
+        return;
+    }
+#endif
+    vu_recorder_destroy(recorder);
 }
 
 vu_error_t vu_recorder_write(vu_recorder_t *recorder, const int16_t *samples, size_t count)
 {
     if (!recorder || !samples) return VU_ERR_INVALID_ARG;
-    if (!recorder->fp) return VU_ERR_IO;
 
-    size_t written = fwrite(samples, sizeof(int16_t), count, recorder->fp);
-    if (written != count) {
-        return VU_ERR_IO;
-    }
+    /* A failed write by the backend surfaces on the next call */
+    if (atomic_load_explicit(&recorder->io_error, memory_order_relaxed)) return VU_ERR_IO;
+
+    const uint8_t *src = (const uint8_t *)samples;
+    size_t bytes = count * sizeof(int16_t);
+    recorder->data_bytes += bytes;
 
-    recorder->samples_written += count / recorder->channels;
+    while (bytes > 0) {
+        size_t n = recorder->buffer_bytes - recorder->fill;
+        if (n > bytes) n = bytes;
+        memcpy(recorder->buffers[recorder->active] + recorder->fill, src, n);
+        recorder->fill += n;
+        src += n;
+        bytes -= n;
+
+        if (recorder->fill == recorder->buffer_bytes) hand_off(recorder, false);
+    }
     return VU_OK;
 }
 
+void vu_recorder_get_stats(vu_recorder_t *recorder, vu_recorder_stats_t *stats)
+{
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (!recorder) return;
+
+    pthread_mutex_lock(&recorder->mutex);
+    stats->queue_depth = recorder->queue_depth;
+    stats->max_queue_depth = recorder->max_queue_depth;
+    stats->bytes_written = recorder->bytes_written;
+    stats->stalls = recorder->stalls;
+    pthread_mutex_unlock(&recorder->mutex);
+}
+
 double vu_recorder_get_duration(const vu_recorder_t *recorder)
 {
     if (!recorder) return 0;
-    return (double)recorder->samples_written / recorder->sample_rate;
+    uint64_t frames = recorder->data_bytes / (sizeof(int16_t) * (uint64_t)recorder->channels);
+    return (double)frames / recorder->sample_rate;
 }
@@ -12,9 +12,64 @@
 
 typedef struct vu_recorder vu_recorder_t;
 
+/* How buffers reach the disk */
+typedef enum {
+    VU_RECORDER_BACKEND_THREAD = 0,   /* A writer thread per recorder */
+    VU_RECORDER_BACKEND_IO_URING      /* One io_uring and thread for all
+                                         recorders (built with liburing) */
+} vu_recorder_backend_t;
+
+/* Write statistics */
+typedef struct vu_recorder_stats {
+    int queue_depth;          /* Buffers waiting for or being written */
+    int max_queue_depth;
+    uint64_t bytes_written;   /* On disk so far */
+    unsigned stalls;          /* Times a write waited for the disk */
+} vu_recorder_stats_t;
+
+/*
+ * Select the backend of recorders created from now on. io_uring fails
+ * with VU_ERR_NOT_SUPPORTED if not built in or refused by the kernel;
+ * the current backend is kept.
+ */
+vu_error_t vu_recorder_set_backend(vu_recorder_backend_t backend);
+vu_recorder_backend_t vu_recorder_get_backend(void);
+
+/* Parse "thread" or "io_uring" (anything else is "thread") */
+vu_recorder_backend_t vu_recorder_backend_from_string(const char *name);
+
+/*
+ * Wait for recordings closed with vu_recorder_close_async and stop the
+ * io_uring writer. Close every recorder first.
+ */
+void vu_recorder_shutdown(void);
+
+/*
+ * Create a 16-bit PCM WAV recording of `channels` interleaved channels.
+ * Closing a recording past 4 GB writes it as RF64, so multi-day
+ * captures keep their full length.
+ *
+ * Writes only copy into a preallocated buffer; each full buffer is
+ * written into preallocated disk space by the backend while the next one
+ * fills. Use a recorder from one thread at a time.
+ */
 vu_recorder_t *vu_recorder_create(const char *path, uint32_t sample_rate, int channels);
+
+/* Flush what is buffered, finalize the header and close */
 void vu_recorder_destroy(vu_recorder_t *recorder);
+
+/*
+ * Like vu_recorder_destroy, but with io_uring the last writes, the header
+ * and the close complete in the background (vu_recorder_shutdown waits
+ * for them). The writer thread backend closes synchronously.
+ */
+void vu_recorder_close_async(vu_recorder_t *recorder);
+
+/* Queue samples (VU_ERR_IO once a buffer failed to reach the disk) */
 vu_error_t vu_recorder_write(vu_recorder_t *recorder, const int16_t *samples, size_t count);
 double vu_recorder_get_duration(const vu_recorder_t *recorder);
 
+/* Get write statistics (any thread) */
+void vu_recorder_get_stats(vu_recorder_t *recorder, vu_recorder_stats_t *stats);
+
 #endif /* VU_RECORDER_H */
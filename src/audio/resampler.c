@@ -0,0 +1,172 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Polyphase sample rate converter implementation
+ *
+ * With the ratio reduced to out/in = L/M, output m sits at input position
+ * m * M / L: input index floor(m * M / L) plus phase (m * M mod L) / L.
+ * Each of the L phases has its own 2 * radius taps, normalized to unity
+ * DC gain. Ratios with more than RESAMPLE_MAX_PHASES phases (e.g. 44100
+ * to 8001) round the phase to the nearest of that many, a timing error
+ * below 1/2048 of an input sample.
+ */
+
+#include "audio/resampler.h"
+#include <stdlib.h>
+#include <math.h>
+
+#define RESAMPLE_ZEROS      16     /* Sinc zero crossings each side */
+#define RESAMPLE_BETA       7.0    /* Kaiser window shape */
+#define RESAMPLE_MAX_PHASES 1024
+
+struct vu_resampler {
+    uint64_t step_num;         /* M: input samples per L outputs */
+    uint64_t step_den;         /* L */
+    int phases;                /* Rows in the tap table */
+    int radius;                /* Taps at indices -(radius - 1) .. radius */
+    int16_t *taps;             /* phases x (2 * radius), Q15 */
+};
+
+static uint64_t gcd_u64(uint64_t a, uint64_t b)
+{
+    while (b != 0) {
+        uint64_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/* Zeroth-order modified Bessel function, for the Kaiser window */
+static double bessel_i0(double x)
+{
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; term > 1e-12 * sum; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+vu_resampler_t *vu_resampler_create(uint32_t in_rate, uint32_t out_rate)
+{
+    if (in_rate == 0 || out_rate == 0 || out_rate >= in_rate) return NULL;
+
+    vu_resampler_t *resampler = calloc(1, sizeof(vu_resampler_t));
+    if (!resampler) return NULL;
+
+    uint64_t g = gcd_u64(in_rate, out_rate);
+    resampler->step_num = in_rate / g;
+    resampler->step_den = out_rate / g;
+    resampler->phases = resampler->step_den < RESAMPLE_MAX_PHASES ?
+                        (int)resampler->step_den : RESAMPLE_MAX_PHASES;
+
+    /* Cutoff in cycles per input sample: the output's Nyquist frequency.
+     * Below 0.5, so every tap (at most 2 * cutoff) stays under 1.0 in Q15. */
+    double cutoff = 0.5 * out_rate / in_rate;
+    resampler->radius = (int)ceil(RESAMPLE_ZEROS / (2.0 * cutoff));
+
+    int width = 2 * resampler->radius;
+    resampler->taps = malloc((size_t)resampler->phases * width * sizeof(int16_t));
+    if (!resampler->taps) {
+        vu_resampler_destroy(resampler);
+        return NULL;
+    }
+
+    double window_norm = bessel_i0(RESAMPLE_BETA);
+    double *row = malloc((size_t)width * sizeof(double));
+    if (!row) {
+        vu_resampler_destroy(resampler);
+        return NULL;
+    }
+
+    for (int p = 0; p < resampler->phases; p++) {
+        double frac = (double)p / resampler->phases;
+        double sum = 0.0;
+
+        for (int i = 0; i < width; i++) {
+            double t = (i - (resampler->radius - 1)) - frac;
+            double r = t / resampler->radius;
+            double sinc = t == 0.0 ? 2.0 * cutoff : sin(2.0 * M_PI * cutoff * t) / (M_PI * t);
+            double window = r * r < 1.0 ? bessel_i0(RESAMPLE_BETA * sqrt(1.0 - r * r)) /
+                                          window_norm : 0.0;
+            row[i] = sinc * window;
+            sum += row[i];
+        }
+
+        /* Unity DC gain per phase, with the rounding residue on the
+         * largest tap */
+        int16_t *taps = resampler->taps + (size_t)p * width;
+        int32_t total = 0;
+        int largest = 0;
+        for (int i = 0; i < width; i++) {
+            taps[i] = (int16_t)lround(row[i] / sum * 32768.0);
+            total += taps[i];
+            if (abs(taps[i]) > abs(taps[largest])) largest = i;
+        }
+        taps[largest] = (int16_t)(taps[largest] + (32768 - total));
+    }
+
+    free(row);
+    return resampler;
+}
+
+void vu_resampler_destroy(vu_resampler_t *resampler)
+{
+    if (!resampler) return;
+
+    free(resampler->taps);
+    free(resampler);
+}
+
+void vu_resampler_span(const vu_resampler_t *resampler, uint64_t start, size_t count,
+                       int64_t *first, size_t *len)
+{
+    uint64_t lo = start * resampler->step_num / resampler->step_den;
+    uint64_t last = count > 0 ? start + count - 1 : start;
+    uint64_t hi = last * resampler->step_num / resampler->step_den;
+
+    /* One more on the right: a rounded-up phase moves to the next index */
+    *first = (int64_t)lo - (resampler->radius - 1);
+    *len = (size_t)(hi - lo) + 2 * (size_t)resampler->radius + 1;
+}
+
+void vu_resampler_run(const vu_resampler_t *resampler, const int16_t *in, int64_t first,
+                      uint64_t start, size_t count, int16_t *out)
+{
+    int width = 2 * resampler->radius;
+    uint64_t num = resampler->step_num;
+    uint64_t den = resampler->step_den;
+    uint64_t phases = (uint64_t)resampler->phases;
+
+    for (size_t m = 0; m < count; m++) {
+        uint64_t pos = (start + m) * num;
+        uint64_t index = pos / den;
+        uint64_t phase = pos % den;
+        if (phases != den) {
+            phase = (phase * phases + den / 2) / den;
+            if (phase == phases) {
+                phase = 0;
+                index++;
+            }
+        }
+
+        const int16_t *x = in + ((int64_t)index - (resampler->radius - 1) - first);
+        const int16_t *taps = resampler->taps + phase * (uint64_t)width;
+
+        /* Q15 taps, |sum| <= 2^15 * sum(|h|): stays within int32 */
+        int32_t acc = 0;
+        for (int i = 0; i < width; i++) {
+            acc += (int32_t)taps[i] * x[i];
+        }
+
+        acc = (acc + (1 << 14)) >> 15;
+        if (acc > INT16_MAX) acc = INT16_MAX;
+        if (acc < INT16_MIN) acc = INT16_MIN;
+        out[m] = (int16_t)acc;
+    }
+}
+
+uint64_t vu_resampler_output_count(const vu_resampler_t *resampler, uint64_t in_count)
+{
+    return in_count * resampler->step_den / resampler->step_num;
+}
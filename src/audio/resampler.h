@@ -0,0 +1,57 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Polyphase sample rate converter for any rate pair
+ *
+ * Windowed-sinc interpolation (Kaiser, 16 zero crossings) from a table
+ * of per-phase Q15 taps. Downsampling moves the cutoff to the output's
+ * Nyquist frequency: flat to within 0.01 dB up to 0.425 of the output
+ * rate and at least 70 dB down from 0.575, so the telephony band comes
+ * through clean. Every output sample depends only on the input, which
+ * lets a reader start anywhere in a stream and still reproduce exactly
+ * what reading through would return. Integer only per sample.
+ */
+
+#ifndef VU_RESAMPLER_H
+#define VU_RESAMPLER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Opaque converter for one rate pair */
+typedef struct vu_resampler vu_resampler_t;
+
+/*
+ * Create a converter from in_rate down to out_rate (both non-zero,
+ * out_rate < in_rate). Upsampling and equal rates are not supported:
+ * their unity centre tap does not fit the Q15 table.
+ * Returns NULL on failure.
+ */
+vu_resampler_t *vu_resampler_create(uint32_t in_rate, uint32_t out_rate);
+
+/*
+ * Destroy converter and free resources
+ */
+void vu_resampler_destroy(vu_resampler_t *resampler);
+
+/*
+ * Get the input range that output samples [start, start + count) read:
+ * `len` samples from input index `first` (negative near the start of the
+ * stream, where the input counts as zero)
+ */
+void vu_resampler_span(const vu_resampler_t *resampler, uint64_t start, size_t count,
+                       int64_t *first, size_t *len);
+
+/*
+ * Compute output samples [start, start + count) from `in`, which holds
+ * the input range given by vu_resampler_span starting at input index
+ * `first`
+ */
+void vu_resampler_run(const vu_resampler_t *resampler, const int16_t *in, int64_t first,
+                      uint64_t start, size_t count, int16_t *out);
+
+/*
+ * Get the number of output samples for `in_count` input samples
+ */
+uint64_t vu_resampler_output_count(const vu_resampler_t *resampler, uint64_t in_count);
+
+#endif /* VU_RESAMPLER_H */
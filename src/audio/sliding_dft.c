@@ -0,0 +1,288 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Sliding DFT implementation
+ *
+ * For each tracked frequency w the state is
+ *   S(n) = sum_{m=0}^{N-1} x(n-N+1+m) e^{-jwm}
+ * and advances one sample as
+ *   S(n) = e^{jw} (S(n-1) - x(n-N)) + x(n) e^{-jw(N-1)}.
+ * The recursion is exact in theory but accumulates rounding, so every N
+ * samples the state is recomputed directly from the sample history, which
+ * costs O(N) per bin per N samples: still O(bins) per sample.
+ */
+
+#include "audio/sliding_dft.h"
+#include "audio/analyzer_simd.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+struct vu_sdft {
+    int size;                  /* Window length N */
+    float min_level_db;
+
+    /* Tracked frequencies, structure of arrays for the per-sample loop */
+    int tracker_count;
+    double *state_re;
+    double *state_im;
+    double *rotate_re;         /* e^{jw} */
+    double *rotate_im;
+    double *tail_re;           /* e^{-jw(N-1)} */
+    double *tail_im;
+
+    /* Reported frequencies: candidate c is tracker center[c], windowed
+     * with trackers center[c] - 1 and center[c] + 1 */
+    int candidate_count;
+    int *center;
+    float *freq_hz;
+    bool targets;              /* Candidates are Goertzel targets, not bins */
+    float bin_hz;
+
+    int16_t *history;          /* Last N samples, circular */
+    size_t head;               /* Next history slot (the oldest once full) */
+    uint64_t pushed;           /* Samples pushed so far */
+    int since_sync;            /* Samples since the last direct recompute */
+};
+
+static void add_tracker(vu_sdft_t *sdft, double w, int size)
+{
+    int t = sdft->tracker_count++;
+    sdft->rotate_re[t] = cos(w);
+    sdft->rotate_im[t] = sin(w);
+    sdft->tail_re[t] = cos(w * (size - 1));
+    sdft->tail_im[t] = -sin(w * (size - 1));
+}
+
+vu_sdft_t *vu_sdft_create(const vu_analyzer_config_t *config)
+{
+    if (!config || config->fft_size < 4 || config->sample_rate <= 0) return NULL;
+
+    int n = config->fft_size;
+    double bin_hz = (double)config->sample_rate / n;
+
+    /* Candidate frequencies: the targets, or every bin in the band */
+    int first_bin = 0, candidates;
+    if (config->target_count > 0) {
+        candidates = config->target_count;
+    } else {
+        first_bin = (int)ceil(config->band_min_hz / bin_hz);
+        int last_bin = (int)floor(config->band_max_hz / bin_hz);
+        if (first_bin < 1) first_bin = 1;
+        if (last_bin > n / 2 - 1) last_bin = n / 2 - 1;
+        candidates = last_bin - first_bin + 1;
+        if (candidates < 1) return NULL;
+    }
+
+    /* Targets need their own neighbours; band bins share them */
+    int trackers = config->target_count > 0 ? 3 * candidates : candidates + 2;
+
+    vu_sdft_t *sdft = calloc(1, sizeof(vu_sdft_t));
+    if (!sdft) return NULL;
+
+    sdft->size = n;
+    sdft->min_level_db = config->min_level_db;
+    sdft->targets = config->target_count > 0;
+    sdft->bin_hz = (float)bin_hz;
+    sdft->candidate_count = candidates;
+    sdft->state_re = calloc((size_t)trackers, sizeof(double));
+    sdft->state_im = calloc((size_t)trackers, sizeof(double));
+    sdft->rotate_re = calloc((size_t)trackers, sizeof(double));
+    sdft->rotate_im = calloc((size_t)trackers, sizeof(double));
+    sdft->tail_re = calloc((size_t)trackers, sizeof(double));
+    sdft->tail_im = calloc((size_t)trackers, sizeof(double));
+    sdft->center = calloc((size_t)candidates, sizeof(int));
+    sdft->freq_hz = calloc((size_t)candidates, sizeof(float));
+    sdft->history = calloc((size_t)n, sizeof(int16_t));
+    if (!sdft->state_re || !sdft->state_im || !sdft->rotate_re || !sdft->rotate_im ||
+        !sdft->tail_re || !sdft->tail_im || !sdft->center || !sdft->freq_hz ||
+        !sdft->history) {
+        vu_sdft_destroy(sdft);
+        return NULL;
+    }
+
+    double bin_w = 2.0 * M_PI / n;
+    if (config->target_count > 0) {
+        for (int c = 0; c < candidates; c++) {
+            double w = 2.0 * M_PI * config->target_freqs_hz[c] / config->sample_rate;
+            add_tracker(sdft, w - bin_w, n);
+            sdft->center[c] = sdft->tracker_count;
+            add_tracker(sdft, w, n);
+            add_tracker(sdft, w + bin_w, n);
+            sdft->freq_hz[c] = config->target_freqs_hz[c];
+        }
+    } else {
+        for (int k = first_bin - 1; k <= first_bin + candidates; k++) {
+            add_tracker(sdft, k * bin_w, n);
+        }
+        for (int c = 0; c < candidates; c++) {
+            sdft->center[c] = c + 1;
+            sdft->freq_hz[c] = (float)((first_bin + c) * bin_hz);
+        }
+    }
+
+    return sdft;
+}
+
+void vu_sdft_destroy(vu_sdft_t *sdft)
+{
+    if (!sdft) return;
+
+    free(sdft->state_re);
+    free(sdft->state_im);
+    free(sdft->rotate_re);
+    free(sdft->rotate_im);
+    free(sdft->tail_re);
+    free(sdft->tail_im);
+    free(sdft->center);
+    free(sdft->freq_hz);
+    free(sdft->history);
+    free(sdft);
+}
+
+int vu_sdft_bin_count(const vu_sdft_t *sdft)
+{
+    return sdft ? sdft->tracker_count : 0;
+}
+
+/* Recompute every state directly from the history (oldest sample first) */
+static void sync_states(vu_sdft_t *sdft)
+{
+    int n = sdft->size;
+    size_t oldest = sdft->head;
+
+    for (int t = 0; t < sdft->tracker_count; t++) {
+        /* e^{-jwm} by rotation, exact enough over one window in double */
+        double step_re = sdft->rotate_re[t];
+        double step_im = -sdft->rotate_im[t];
+        double ph_re = 1.0, ph_im = 0.0;
+        double re = 0.0, im = 0.0;
+
+        for (int m = 0; m < n; m++) {
+            double x = sdft->history[(oldest + (size_t)m) % (size_t)n];
+            re += x * ph_re;
+            im += x * ph_im;
+            double next_re = ph_re * step_re - ph_im * step_im;
+            ph_im = ph_re * step_im + ph_im * step_re;
+            ph_re = next_re;
+        }
+
+        sdft->state_re[t] = re;
+        sdft->state_im[t] = im;
+    }
+    sdft->since_sync = 0;
+}
+
+void vu_sdft_push(vu_sdft_t *sdft, const int16_t *samples, size_t count)
+{
+    if (!sdft || !samples) return;
+
+    int n = sdft->size;
+    int trackers = sdft->tracker_count;
+
+    for (size_t i = 0; i < count; i++) {
+        double x = samples[i];
+        double old = sdft->history[sdft->head];
+        sdft->history[sdft->head] = samples[i];
+        if (++sdft->head == (size_t)n) sdft->head = 0;
+        sdft->pushed++;
+
+        /* Filling the first window: nothing to slide yet */
+        if (sdft->pushed < (uint64_t)n) continue;
+        if (sdft->pushed == (uint64_t)n || ++sdft->since_sync >= n) {
+            sync_states(sdft);
+            continue;
+        }
+
+        for (int t = 0; t < trackers; t++) {
+            double d_re = sdft->state_re[t] - old;
+            double d_im = sdft->state_im[t];
+            sdft->state_re[t] = d_re * sdft->rotate_re[t] - d_im * sdft->rotate_im[t] +
+                                x * sdft->tail_re[t];
+            sdft->state_im[t] = d_re * sdft->rotate_im[t] + d_im * sdft->rotate_re[t] +
+                                x * sdft->tail_im[t];
+        }
+    }
+}
+
+/*
+ * Offset of the tone near target tracker t from the target, in bins:
+ * Jacobsen's estimator on the unwindowed states one bin either side,
+ * Re((S[-1] - S[+1]) / (2 S[0] - S[-1] - S[+1])). Unwindowed, a tone d
+ * bins away makes S[k] proportional to 1 / (d - k), so the estimate is d
+ * itself, beyond the neighbours too, and needs no further trackers.
+ */
+static float target_offset(const vu_sdft_t *sdft, int t)
+{
+    double num_re = sdft->state_re[t - 1] - sdft->state_re[t + 1];
+    double num_im = sdft->state_im[t - 1] - sdft->state_im[t + 1];
+    double den_re = 2.0 * sdft->state_re[t] - sdft->state_re[t - 1] - sdft->state_re[t + 1];
+    double den_im = 2.0 * sdft->state_im[t] - sdft->state_im[t - 1] - sdft->state_im[t + 1];
+    double den_power = den_re * den_re + den_im * den_im;
+    if (den_power <= 0.0) return 0.0f;
+
+    double d = (num_re * den_re + num_im * den_im) / den_power;
+    if (d > 2.0) d = 2.0;
+    if (d < -2.0) d = -2.0;
+    return (float)d;
+}
+
+bool vu_sdft_result(const vu_sdft_t *sdft, vu_freq_result_t *freq,
+                    vu_level_result_t *level)
+{
+    if (!sdft || !freq || !level || sdft->pushed < (uint64_t)sdft->size) return false;
+
+    /* Hann window in the frequency domain: 0.5 S[k] - 0.25 (S[k-1] + S[k+1]) */
+    double best_power = 0.0;
+    int best = -1;
+    for (int c = 0; c < sdft->candidate_count; c++) {
+        int t = sdft->center[c];
+        double re = 0.5 * sdft->state_re[t] -
+                    0.25 * (sdft->state_re[t - 1] + sdft->state_re[t + 1]);
+        double im = 0.5 * sdft->state_im[t] -
+                    0.25 * (sdft->state_im[t - 1] + sdft->state_im[t + 1]);
+        double power = re * re + im * im;
+        if (power > best_power) {
+            best_power = power;
+            best = c;
+        }
+    }
+
+    /* The window wraps around the circular history: measure both parts */
+    const vu_analyzer_kernels_t *kernels = vu_analyzer_kernels();
+    size_t n = (size_t)sdft->size;
+    size_t oldest = sdft->head;
+    uint64_t sum_a = 0, sum_b = 0;
+    int32_t peak_a = 0, peak_b = 0;
+    kernels->level(sdft->history + oldest, n - oldest, &sum_a, &peak_a);
+    if (oldest > 0) kernels->level(sdft->history, oldest, &sum_b, &peak_b);
+    vu_analyzer_level_from_sums(sum_a + sum_b, peak_a > peak_b ? peak_a : peak_b, n, level);
+
+    /* States are in PCM units: normalize to full scale, then by N/2 */
+    float magnitude = (float)(sqrt(best_power) / 32768.0 / (sdft->size / 2));
+    memset(freq, 0, sizeof(*freq));
+    freq->magnitude_db = 20.0f * log10f(magnitude + 1e-10f);
+    freq->valid = (freq->magnitude_db > sdft->min_level_db);
+    if (best < 0) return true;
+
+    if (!sdft->targets) {
+        freq->frequency = sdft->freq_hz[best];
+        return true;
+    }
+    if (!freq->valid) return true;
+
+    /* A target only names a tone if it and its neighbours carry most of
+     * the window's energy: by Parseval the unwindowed states of a tone
+     * within a bin or so hold N sum(x^2) / 2 between them */
+    int t = sdft->center[best];
+    double power = 0.0;
+    for (int i = t - 1; i <= t + 1; i++) {
+        power += sdft->state_re[i] * sdft->state_re[i] + sdft->state_im[i] * sdft->state_im[i];
+    }
+    double energy = (double)(sum_a + sum_b);
+    if (energy <= 0.0 || power * 2.0 < VU_ANALYZER_MIN_TONE_SHARE * n * energy) {
+        freq->valid = false;
+        return true;
+    }
+    freq->frequency = sdft->freq_hz[best] + target_offset(sdft, t) * sdft->bin_hz;
+    return true;
+}
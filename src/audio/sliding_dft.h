@@ -0,0 +1,53 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Sliding DFT: per-sample spectrum updates for a fixed set of bins
+ *
+ * Keeps the DFT of the last fft_size samples at a few frequencies and
+ * updates it with each new sample in O(bins), so results can be taken at
+ * any hop without transforming whole frames. The Hann window is applied
+ * in the frequency domain from each bin's two neighbours.
+ */
+
+#ifndef VU_SLIDING_DFT_H
+#define VU_SLIDING_DFT_H
+
+#include "audio/analyzer.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/* Opaque sliding DFT state */
+typedef struct vu_sdft vu_sdft_t;
+
+/*
+ * Create a sliding DFT over config->fft_size samples. Tracks the
+ * configured Goertzel targets if target_count > 0, otherwise every bin
+ * between band_min_hz and band_max_hz.
+ * Returns NULL on failure.
+ */
+vu_sdft_t *vu_sdft_create(const vu_analyzer_config_t *config);
+
+/*
+ * Destroy sliding DFT and free resources
+ */
+void vu_sdft_destroy(vu_sdft_t *sdft);
+
+/*
+ * Get the number of tracked frequencies (work per sample)
+ */
+int vu_sdft_bin_count(const vu_sdft_t *sdft);
+
+/*
+ * Slide the window on by `count` samples
+ */
+void vu_sdft_push(vu_sdft_t *sdft, const int16_t *samples, size_t count);
+
+/*
+ * Get the dominant tracked frequency and the level of the last fft_size
+ * samples, scaled like the analyzer's frame results.
+ * Returns false until fft_size samples have been pushed.
+ */
+bool vu_sdft_result(const vu_sdft_t *sdft, vu_freq_result_t *freq,
+                    vu_level_result_t *level);
+
+#endif /* VU_SLIDING_DFT_H */
@@ -0,0 +1,146 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Voice activity detector implementation
+ */
+
+#include "audio/vad.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* Fewest bins the flatness is worth measuring over */
+#define MIN_FLATNESS_BINS 8
+
+struct vu_vad {
+    vu_vad_config_t config;
+    vu_vad_result_t result;
+
+    bool in_segment;
+    double start_time;
+    double release_time;       /* First inactive frame after the last active one */
+    bool releasing;
+};
+
+vu_vad_config_t vu_vad_default_config(void)
+{
+    vu_vad_config_t config = {
+        .threshold_db = -45.0f,
+        .max_flatness = 0.45f,
+        .band_min_hz = 300.0f,
+        .band_max_hz = 3400.0f,
+        .hangover_sec = 0.2
+    };
+    return config;
+}
+
+vu_vad_t *vu_vad_create(const vu_vad_config_t *config)
+{
+    vu_vad_t *vad = calloc(1, sizeof(vu_vad_t));
+    if (!vad) return NULL;
+
+    vad->config = config ? *config : vu_vad_default_config();
+    vad->result.first_active_sec = -1.0;
+    return vad;
+}
+
+void vu_vad_destroy(vu_vad_t *vad)
+{
+    free(vad);
+}
+
+/* Geometric over arithmetic mean of the bin powers in the band; 1 if the
+ * band is too narrow to tell */
+static float spectral_flatness(const vu_vad_t *vad, const vu_spectrum_t *spectrum)
+{
+    int first = (int)ceilf(vad->config.band_min_hz / spectrum->bin_hz);
+    int last = (int)(vad->config.band_max_hz / spectrum->bin_hz);
+    if (first < 1) first = 1;
+    if (last > spectrum->bin_count - 1) last = spectrum->bin_count - 1;
+    if (last - first + 1 < MIN_FLATNESS_BINS) return 1.0f;
+
+    float log_sum = 0.0f, sum = 0.0f;
+    for (int k = first; k <= last; k++) {
+        float power = vu_spectrum_power(spectrum, k) + 1e-20f;
+        log_sum += logf(power);
+        sum += power;
+    }
+
+    int n = last - first + 1;
+    return expf(log_sum / n) / (sum / n);
+}
+
+static bool frame_active(const vu_vad_t *vad, const vu_analysis_frame_t *frame)
+{
+    if (frame->level.rms_db < vad->config.threshold_db) return false;
+
+    const vu_spectrum_t *spectrum = frame->spectrum;
+    if (!spectrum || !spectrum->bins) return true;
+    return spectral_flatness(vad, spectrum) <= vad->config.max_flatness;
+}
+
+/* Close the open segment at `end_time` */
+static void end_segment(vu_vad_t *vad, double end_time, vu_vad_segment_t *out_segment)
+{
+    vu_vad_segment_t segment = {
+        .start_time_sec = vad->start_time,
+        .end_time_sec = end_time,
+        .duration_sec = end_time - vad->start_time
+    };
+
+    vad->in_segment = false;
+    vad->releasing = false;
+    vad->result.segment_count++;
+    vad->result.active_sec += segment.duration_sec;
+    if (vad->result.first_active_sec < 0) vad->result.first_active_sec = segment.start_time_sec;
+
+    if (out_segment) *out_segment = segment;
+}
+
+bool vu_vad_process_frame(vu_vad_t *vad, const vu_analysis_frame_t *frame,
+                          vu_vad_segment_t *out_segment)
+{
+    if (!vad || !frame) return false;
+
+    if (frame_active(vad, frame)) {
+        if (!vad->in_segment) {
+            vad->in_segment = true;
+            vad->start_time = frame->time_sec;
+        }
+        vad->releasing = false;
+        return false;
+    }
+
+    if (!vad->in_segment) return false;
+
+    if (!vad->releasing) {
+        vad->releasing = true;
+        vad->release_time = frame->time_sec;
+    }
+    if (frame->time_sec - vad->release_time < vad->config.hangover_sec) return false;
+
+    end_segment(vad, vad->release_time, out_segment);
+    return true;
+}
+
+bool vu_vad_flush(vu_vad_t *vad, double end_time_sec, vu_vad_segment_t *out_segment)
+{
+    if (!vad || !vad->in_segment) return false;
+
+    end_segment(vad, vad->releasing ? vad->release_time : end_time_sec, out_segment);
+    return true;
+}
+
+const vu_vad_result_t *vu_vad_get_result(const vu_vad_t *vad)
+{
+    if (!vad) return NULL;
+    return &vad->result;
+}
+
+void vu_vad_reset(vu_vad_t *vad)
+{
+    if (!vad) return;
+    vad->in_segment = false;
+    vad->releasing = false;
+    memset(&vad->result, 0, sizeof(vad->result));
+    vad->result.first_active_sec = -1.0;
+}
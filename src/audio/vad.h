@@ -0,0 +1,84 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Voice activity detector on the analyzer's frames
+ *
+ * A frame is active when its RMS level reaches the threshold and, if it
+ * has a spectrum, the voice band is not spectrally flat: steady noise
+ * spreads its power evenly over the bins (flatness near 0.56 for white
+ * noise), while speech and tones concentrate it. Activity is held for a
+ * hangover period so pauses between words do not split a segment.
+ */
+
+#ifndef VU_VAD_H
+#define VU_VAD_H
+
+#include "audio/analyzer.h"
+#include <stdbool.h>
+
+/* Detector configuration */
+typedef struct vu_vad_config {
+    float threshold_db;       /* Lowest active RMS level (default -45) */
+    float max_flatness;       /* Highest active spectral flatness, 0-1 (default 0.45) */
+    float band_min_hz;        /* Band the flatness is measured over (default 300) */
+    float band_max_hz;        /* (default 3400) */
+    double hangover_sec;      /* Activity held after the last active frame (default 0.2) */
+} vu_vad_config_t;
+
+/* One stretch of voice activity */
+typedef struct vu_vad_segment {
+    double start_time_sec;
+    double end_time_sec;
+    double duration_sec;
+} vu_vad_segment_t;
+
+/* Totals over the audio processed */
+typedef struct vu_vad_result {
+    int segment_count;
+    double active_sec;        /* Sum of segment durations */
+    double first_active_sec;  /* Start of the first segment (-1 if none) */
+} vu_vad_result_t;
+
+/* Opaque detector handle */
+typedef struct vu_vad vu_vad_t;
+
+/*
+ * Get default configuration
+ */
+vu_vad_config_t vu_vad_default_config(void);
+
+/*
+ * Create voice activity detector (NULL config for defaults)
+ * Returns NULL on failure.
+ */
+vu_vad_t *vu_vad_create(const vu_vad_config_t *config);
+
+/*
+ * Destroy detector
+ */
+void vu_vad_destroy(vu_vad_t *vad);
+
+/*
+ * Process a frame from the streaming file analysis. Frames without a
+ * spectrum are judged on their level alone.
+ * Returns true if a segment just ended (segment available)
+ */
+bool vu_vad_process_frame(vu_vad_t *vad, const vu_analysis_frame_t *frame,
+                          vu_vad_segment_t *out_segment);
+
+/*
+ * End a segment still open when the audio ends at `end_time_sec`
+ * Returns true if there was one (segment available)
+ */
+bool vu_vad_flush(vu_vad_t *vad, double end_time_sec, vu_vad_segment_t *out_segment);
+
+/*
+ * Get detection totals
+ */
+const vu_vad_result_t *vu_vad_get_result(const vu_vad_t *vad);
+
+/*
+ * Reset detector state
+ */
+void vu_vad_reset(vu_vad_t *vad);
+
+#endif /* VU_VAD_H */
@@ -0,0 +1,739 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Streaming WAV file reader implementation
+ */
+
+#include "audio/wav_reader.h"
+#include "audio/decimator.h"
+#include "audio/resampler.h"
+#include "util/error.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* Buffered mode refill size (bytes) - large sequential reads */
+#define WAV_READ_CHUNK_BYTES (128 * 1024)
+
+/* Mapped mode: hand consumed pages back to the kernel in steps of this
+ * size so resident memory stays bounded on multi-hour recordings */
+#define WAV_RELEASE_BYTES (8 * 1024 * 1024)
+
+/* Converted mode: output samples per block, and half-band stages */
+#define CONVERT_BLOCK 4096
+#define CONVERT_MAX_STAGES 4
+
+#define WAV_FORMAT_PCM        0x0001
+#define WAV_FORMAT_IEEE_FLOAT 0x0003
+#define WAV_FORMAT_ALAW       0x0006
+#define WAV_FORMAT_MULAW      0x0007
+#define WAV_FORMAT_EXTENSIBLE 0xFFFE
+
+/* Decodes one sample of one channel to Q31 */
+typedef int32_t (*wav_decode_fn)(const uint8_t *p);
+
+struct vu_wav_reader {
+    int fd;
+    vu_wav_info_t info;
+    uint64_t data_offset;      /* File offset of the data chunk */
+    uint64_t position;         /* Samples consumed */
+
+    /* Decoding: one sample per frame of frame_bytes, from the selected
+     * channel or the mean of all */
+    wav_decode_fn decode;
+    size_t frame_bytes;        /* Bytes per sample frame (all channels) */
+    size_t sample_bytes;       /* Bytes per sample of one channel */
+    int channel;               /* Channel read, or VU_WAV_CHANNEL_MIX */
+    bool passthrough;          /* 16-bit PCM mono: the data is the samples */
+
+    /* Memory-mapped mode */
+    void *map;
+    size_t map_size;
+    const uint8_t *data;       /* Data chunk inside the mapping */
+    size_t released;           /* Mapping bytes already released */
+    size_t page_size;
+
+    /* Buffered mode (mapping unavailable, or passthrough data misaligned):
+     * bytes of the data chunk from frame buffer_frame on */
+    uint8_t *buffer;
+    size_t buffer_capacity;    /* Bytes */
+    size_t buffer_len;         /* Valid bytes in buffer */
+    uint64_t buffer_frame;     /* Frame at the start of buffer */
+
+    /* Decoded samples from `position` on, unless passthrough */
+    int16_t *pcm;
+    size_t pcm_capacity;       /* Samples */
+    size_t pcm_start;          /* Index of the current position in pcm */
+    size_t pcm_len;            /* Valid samples in pcm */
+
+    /* Samples in the data chunk and their rate, as in the file */
+    uint64_t raw_count;
+    uint32_t raw_rate;
+
+    /* Converted mode: position and info are in output samples, computed
+     * a block at a time through half-band stages and the resampler */
+    bool converting;
+    int stages;
+    vu_resampler_t *resampler;            /* Remaining ratio, if any */
+    int16_t *stage[CONVERT_MAX_STAGES + 1];  /* Input of each stage */
+    int16_t *out;
+    size_t out_capacity;
+    size_t out_start;          /* Index of the current position in out */
+    size_t out_len;            /* Valid samples in out */
+    uint64_t out_position;     /* Output samples consumed */
+};
+
+static uint16_t read_le16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t read_le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* Sample decoders: every format is brought to Q31 so that mixing channels
+ * and the final rounding to 16 bits are the same for all of them */
+
+static int32_t float_to_q31(double x)
+{
+    double scaled = x * 2147483648.0;
+    if (scaled >= 2147483647.0) return INT32_MAX;
+    if (scaled <= -2147483648.0) return INT32_MIN;
+    if (scaled != scaled) return 0;  /* NaN */
+    return (int32_t)lrint(scaled);
+}
+
+static int32_t decode_u8(const uint8_t *p)
+{
+    return ((int32_t)p[0] - 128) * (1 << 24);
+}
+
+static int32_t decode_s16(const uint8_t *p)
+{
+    return (int16_t)read_le16(p) * (1 << 16);
+}
+
+static int32_t decode_s24(const uint8_t *p)
+{
+    return (int32_t)(((uint32_t)p[0] << 8) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 24));
+}
+
+static int32_t decode_s32(const uint8_t *p)
+{
+    return (int32_t)read_le32(p);
+}
+
+static int32_t decode_f32(const uint8_t *p)
+{
+    uint32_t bits = read_le32(p);
+    float x;
+    memcpy(&x, &bits, sizeof(x));
+    return float_to_q31(x);
+}
+
+static int32_t decode_f64(const uint8_t *p)
+{
+    uint64_t bits = read_le32(p) | ((uint64_t)read_le32(p + 4) << 32);
+    double x;
+    memcpy(&x, &bits, sizeof(x));
+    return float_to_q31(x);
+}
+
+/* G.711 expansions to 16-bit linear (ITU-T G.711, as in the reference
+ * coder) */
+static int32_t decode_mulaw(const uint8_t *p)
+{
+    int u = ~p[0] & 0xFF;
+    int t = (((u & 0x0F) << 3) + 0x84) << ((u & 0x70) >> 4);
+    return ((u & 0x80) ? 0x84 - t : t - 0x84) * (1 << 16);
+}
+
+static int32_t decode_alaw(const uint8_t *p)
+{
+    int a = p[0] ^ 0x55;
+    int seg = (a & 0x70) >> 4;
+    int t = (a & 0x0F) << 4;
+    t = seg == 0 ? t + 8 : (t + 0x108) << (seg - 1);
+    return ((a & 0x80) ? t : -t) * (1 << 16);
+}
+
+/* Pick the decoder for a format tag and container size, or NULL */
+static wav_decode_fn find_decoder(uint16_t format, size_t sample_bytes)
+{
+    switch (format) {
+    case WAV_FORMAT_PCM:
+        switch (sample_bytes) {
+        case 1: return decode_u8;
+        case 2: return decode_s16;
+        case 3: return decode_s24;
+        case 4: return decode_s32;
+        default: return NULL;
+        }
+    case WAV_FORMAT_IEEE_FLOAT:
+        return sample_bytes == 4 ? decode_f32 : sample_bytes == 8 ? decode_f64 : NULL;
+    case WAV_FORMAT_MULAW:
+        return sample_bytes == 1 ? decode_mulaw : NULL;
+    case WAV_FORMAT_ALAW:
+        return sample_bytes == 1 ? decode_alaw : NULL;
+    default:
+        return NULL;
+    }
+}
+
+/* Round Q31 to Q15, saturating */
+static int16_t q31_to_q15(int64_t value)
+{
+    value = (value + (1 << 15)) >> 16;
+    if (value > INT16_MAX) return INT16_MAX;
+    if (value < INT16_MIN) return INT16_MIN;
+    return (int16_t)value;
+}
+
+/* Decode `count` frames at `src` into one sample each */
+static void decode_frames(const vu_wav_reader_t *reader, const uint8_t *src, size_t count,
+                          int16_t *dst)
+{
+    size_t frame_bytes = reader->frame_bytes;
+    wav_decode_fn decode = reader->decode;
+
+    if (reader->channel != VU_WAV_CHANNEL_MIX) {
+        src += (size_t)reader->channel * reader->sample_bytes;
+        for (size_t i = 0; i < count; i++, src += frame_bytes) {
+            dst[i] = q31_to_q15(decode(src));
+        }
+        return;
+    }
+
+    int channels = reader->info.num_channels;
+    for (size_t i = 0; i < count; i++, src += frame_bytes) {
+        int64_t sum = 0;
+        for (int c = 0; c < channels; c++) {
+            sum += decode(src + (size_t)c * reader->sample_bytes);
+        }
+        dst[i] = q31_to_q15(sum / channels);
+    }
+}
+
+/* Read `len` bytes at `offset` from the mapping or the file */
+static bool read_at(const vu_wav_reader_t *reader, uint64_t offset,
+                    void *buf, size_t len)
+{
+    if (reader->map) {
+        if (offset + len > reader->map_size) return false;
+        memcpy(buf, (const uint8_t *)reader->map + offset, len);
+        return true;
+    }
+    return pread(reader->fd, buf, len, (off_t)offset) == (ssize_t)len;
+}
+
+/*
+ * Walk the RIFF chunk list for fmt and data. RF64/BW64 files (over 4 GB)
+ * mark the sizes that overflow 32 bits as 0xFFFFFFFF and give the real
+ * ones in a ds64 chunk ahead of them.
+ */
+static vu_error_t parse_header(vu_wav_reader_t *reader, uint64_t file_size)
+{
+    uint8_t hdr[12];
+    if (!read_at(reader, 0, hdr, sizeof(hdr)) ||
+        (memcmp(hdr, "RIFF", 4) != 0 && memcmp(hdr, "RF64", 4) != 0 &&
+         memcmp(hdr, "BW64", 4) != 0) || memcmp(hdr + 8, "WAVE", 4) != 0) {
+        VU_SET_ERROR(VU_ERR_FILE_FORMAT, "Not a RIFF/WAVE file");
+        return VU_ERR_FILE_FORMAT;
+    }
+
+    bool rf64 = memcmp(hdr, "RIFF", 4) != 0;
+    bool found_fmt = false, found_data = false;
+    uint16_t format = 0;
+    uint64_t ds64_data_size = 0;
+    uint64_t offset = sizeof(hdr);
+
+    while ((!found_fmt || !found_data) && offset + 8 <= file_size) {
+        uint8_t chunk[8];
+        if (!read_at(reader, offset, chunk, sizeof(chunk))) break;
+        uint64_t chunk_size = read_le32(chunk + 4);
+        uint64_t body = offset + sizeof(chunk);
+
+        if (rf64 && memcmp(chunk, "data", 4) == 0 && chunk_size == UINT32_MAX) {
+            chunk_size = ds64_data_size;
+        }
+
+        if (rf64 && memcmp(chunk, "ds64", 4) == 0) {
+            /* riffSize, dataSize, sampleCount (64-bit), then a table */
+            uint8_t ds64[16];
+            if (chunk_size < sizeof(ds64) || !read_at(reader, body, ds64, sizeof(ds64))) break;
+            ds64_data_size = read_le32(ds64 + 8) | ((uint64_t)read_le32(ds64 + 12) << 32);
+        } else if (memcmp(chunk, "fmt ", 4) == 0) {
+            /* WAVEFORMATEX, plus the WAVEFORMATEXTENSIBLE tail if present */
+            uint8_t fmt[40];
+            size_t fmt_len = chunk_size < sizeof(fmt) ? chunk_size : sizeof(fmt);
+            if (fmt_len < 16 || !read_at(reader, body, fmt, fmt_len)) break;
+            reader->info.audio_format = read_le16(fmt);
+            reader->info.num_channels = read_le16(fmt + 2);
+            reader->info.sample_rate = read_le32(fmt + 4);
+            reader->info.block_align = read_le16(fmt + 12);
+            reader->info.bits_per_sample = read_le16(fmt + 14);
+
+            /* EXTENSIBLE: the real format tag leads the SubFormat GUID */
+            format = reader->info.audio_format;
+            if (format == WAV_FORMAT_EXTENSIBLE) {
+                format = fmt_len >= 26 ? read_le16(fmt + 24) : 0;
+            }
+            found_fmt = true;
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            reader->data_offset = body;
+            /* Recorders that crash leave a stale size; trust the file length */
+            uint64_t available = file_size > body ? file_size - body : 0;
+            reader->info.data_size = chunk_size < available ? chunk_size : available;
+            found_data = true;
+        }
+
+        /* Chunks are word-aligned: odd sizes carry a pad byte */
+        offset = body + chunk_size + (chunk_size & 1);
+    }
+
+    if (!found_fmt || !found_data) {
+        VU_SET_ERROR(VU_ERR_FILE_FORMAT, "Missing fmt or data chunk");
+        return VU_ERR_FILE_FORMAT;
+    }
+
+    size_t channels = reader->info.num_channels;
+    reader->sample_bytes = (reader->info.bits_per_sample + 7u) / 8u;
+    reader->frame_bytes = reader->sample_bytes * channels;
+    reader->decode = find_decoder(format, reader->sample_bytes);
+    if (!reader->decode || channels == 0 || reader->info.block_align != reader->frame_bytes) {
+        VU_SET_ERROR(VU_ERR_FILE_FORMAT,
+                     "Unsupported WAV format (format=0x%04x, bits=%u, channels=%u, block=%u)",
+                     format, reader->info.bits_per_sample, reader->info.num_channels,
+                     reader->info.block_align);
+        return VU_ERR_FILE_FORMAT;
+    }
+    reader->passthrough = format == WAV_FORMAT_PCM && reader->sample_bytes == 2 && channels == 1;
+
+    reader->info.sample_count = reader->info.data_size / reader->frame_bytes;
+    reader->info.source_rate = reader->info.sample_rate;
+    reader->raw_count = reader->info.sample_count;
+    reader->raw_rate = reader->info.sample_rate;
+    return VU_OK;
+}
+
+vu_wav_reader_t *vu_wav_reader_open(const char *path)
+{
+    if (!path) {
+        VU_SET_ERROR(VU_ERR_INVALID_ARG, "path is NULL");
+        return NULL;
+    }
+
+    vu_wav_reader_t *reader = calloc(1, sizeof(vu_wav_reader_t));
+    if (!reader) {
+        VU_SET_ERROR(VU_ERR_NO_MEMORY, "Failed to allocate WAV reader");
+        return NULL;
+    }
+
+    reader->fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (reader->fd < 0) {
+        VU_SET_ERROR(VU_ERR_FILE_OPEN, "Failed to open %s", path);
+        free(reader);
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(reader->fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        VU_SET_ERROR(VU_ERR_FILE_OPEN, "Not a regular file: %s", path);
+        vu_wav_reader_close(reader);
+        return NULL;
+    }
+
+    uint64_t file_size = (uint64_t)st.st_size;
+
+    /* Map the whole file; fall back to buffered reads if that fails
+     * (e.g. a multi-GB file on a 32-bit target) */
+    if (file_size > 0 && file_size <= SIZE_MAX) {
+        void *map = mmap(NULL, (size_t)file_size, PROT_READ, MAP_PRIVATE, reader->fd, 0);
+        if (map != MAP_FAILED) {
+            reader->map = map;
+            reader->map_size = (size_t)file_size;
+        }
+    }
+
+    if (parse_header(reader, file_size) != VU_OK) {
+        vu_wav_reader_close(reader);
+        return NULL;
+    }
+
+    /* Decoded formats are read bytewise; only passthrough samples are
+     * handed out in place and need int16 alignment */
+    if (reader->map && (!reader->passthrough || reader->data_offset % sizeof(int16_t) == 0)) {
+        reader->data = (const uint8_t *)reader->map + reader->data_offset;
+        reader->page_size = (size_t)sysconf(_SC_PAGESIZE);
+        madvise(reader->map, reader->map_size, MADV_SEQUENTIAL);
+    } else {
+        if (reader->map) {
+            munmap(reader->map, reader->map_size);
+            reader->map = NULL;
+        }
+        reader->buffer_capacity = WAV_READ_CHUNK_BYTES;
+        reader->buffer = malloc(reader->buffer_capacity);
+        if (!reader->buffer) {
+            VU_SET_ERROR(VU_ERR_NO_MEMORY, "Failed to allocate WAV read buffer");
+            vu_wav_reader_close(reader);
+            return NULL;
+        }
+        posix_fadvise(reader->fd, (off_t)reader->data_offset,
+                      (off_t)reader->info.data_size, POSIX_FADV_SEQUENTIAL);
+    }
+
+    return reader;
+}
+
+void vu_wav_reader_close(vu_wav_reader_t *reader)
+{
+    if (!reader) return;
+
+    if (reader->map) munmap(reader->map, reader->map_size);
+    if (reader->fd >= 0) close(reader->fd);
+    free(reader->buffer);
+    free(reader->pcm);
+    for (int s = 0; s <= CONVERT_MAX_STAGES; s++) free(reader->stage[s]);
+    vu_resampler_destroy(reader->resampler);
+    free(reader->out);
+    free(reader);
+}
+
+const vu_wav_info_t *vu_wav_reader_get_info(const vu_wav_reader_t *reader)
+{
+    return reader ? &reader->info : NULL;
+}
+
+bool vu_wav_reader_set_channel(vu_wav_reader_t *reader, int channel)
+{
+    if (!reader) return false;
+    if (channel != VU_WAV_CHANNEL_MIX &&
+        (channel < 0 || channel >= reader->info.num_channels)) {
+        return false;
+    }
+
+    /* Passthrough is mono only, where both selectors give the samples as
+     * they are, so it stays on */
+    reader->channel = channel;
+    reader->pcm_start = 0;
+    reader->pcm_len = 0;
+    return true;
+}
+
+/*
+ * Get the bytes of frames [frame, frame + count), which must lie in the
+ * data chunk. Buffered mode keeps what is still ahead of `frame` and tops
+ * up with one large read, so reading on never reads a byte twice.
+ */
+static const uint8_t *source_bytes(vu_wav_reader_t *reader, uint64_t frame, size_t count)
+{
+    size_t frame_bytes = reader->frame_bytes;
+    if (reader->data) return reader->data + frame * frame_bytes;
+
+    uint64_t buffered = reader->buffer_len / frame_bytes;
+    if (frame >= reader->buffer_frame && frame + count <= reader->buffer_frame + buffered) {
+        return reader->buffer + (frame - reader->buffer_frame) * frame_bytes;
+    }
+
+    size_t want = count * frame_bytes;
+    if (want > reader->buffer_capacity) {
+        size_t new_cap = want + WAV_READ_CHUNK_BYTES;
+        uint8_t *new_buf = realloc(reader->buffer, new_cap);
+        if (!new_buf) return NULL;
+        reader->buffer = new_buf;
+        reader->buffer_capacity = new_cap;
+    }
+
+    /* Compact the part at or after `frame`; anything else starts over */
+    size_t keep = 0;
+    if (frame >= reader->buffer_frame && frame < reader->buffer_frame + buffered) {
+        size_t skip = (size_t)(frame - reader->buffer_frame) * frame_bytes;
+        keep = reader->buffer_len - skip;
+        memmove(reader->buffer, reader->buffer + skip, keep);
+    }
+    reader->buffer_frame = frame;
+    reader->buffer_len = keep;
+
+    uint64_t data_end = reader->data_offset + reader->raw_count * frame_bytes;
+    uint64_t file_pos = reader->data_offset + frame * frame_bytes + keep;
+    while (reader->buffer_len < want && file_pos < data_end) {
+        size_t space = reader->buffer_capacity - reader->buffer_len;
+        uint64_t left = data_end - file_pos;
+        size_t len = left < space ? (size_t)left : space;
+
+        ssize_t n = pread(reader->fd, reader->buffer + reader->buffer_len, len, (off_t)file_pos);
+        if (n <= 0) return NULL;
+
+        file_pos += (uint64_t)n;
+        reader->buffer_len += (size_t)n;
+    }
+
+    return reader->buffer_len >= want ? reader->buffer : NULL;
+}
+
+static const int16_t *raw_peek(vu_wav_reader_t *reader, size_t count)
+{
+    if (reader->position + count > reader->raw_count) return NULL;
+
+    if (reader->passthrough) {
+        return (const int16_t *)source_bytes(reader, reader->position, count);
+    }
+
+    /* Decode only the samples not already decoded by an earlier peek */
+    size_t avail = reader->pcm_len - reader->pcm_start;
+    if (avail >= count) return reader->pcm + reader->pcm_start;
+
+    if (count > reader->pcm_capacity) {
+        int16_t *new_pcm = realloc(reader->pcm, count * sizeof(int16_t));
+        if (!new_pcm) return NULL;
+        reader->pcm = new_pcm;
+        reader->pcm_capacity = count;
+    }
+    memmove(reader->pcm, reader->pcm + reader->pcm_start, avail * sizeof(int16_t));
+    reader->pcm_start = 0;
+    reader->pcm_len = avail;
+
+    const uint8_t *src = source_bytes(reader, reader->position + avail, count - avail);
+    if (!src) return NULL;
+    decode_frames(reader, src, count - avail, reader->pcm + avail);
+    reader->pcm_len = count;
+    return reader->pcm;
+}
+
+static void raw_advance(vu_wav_reader_t *reader, size_t count)
+{
+    uint64_t left = reader->raw_count - reader->position;
+    if (count > left) count = (size_t)left;
+    reader->position += count;
+
+    if (reader->data) {
+        size_t consumed = (size_t)(reader->data_offset + reader->position * reader->frame_bytes);
+        consumed &= ~(reader->page_size - 1);
+        if (consumed - reader->released >= WAV_RELEASE_BYTES) {
+            madvise((uint8_t *)reader->map + reader->released,
+                    consumed - reader->released, MADV_DONTNEED);
+            reader->released = consumed;
+        }
+    }
+
+    size_t decoded = reader->pcm_len - reader->pcm_start;
+    if (count <= decoded) {
+        reader->pcm_start += count;
+    } else {
+        reader->pcm_start = 0;
+        reader->pcm_len = 0;
+    }
+}
+
+static void raw_seek(vu_wav_reader_t *reader, uint64_t sample)
+{
+    if (sample > reader->raw_count) sample = reader->raw_count;
+    reader->position = sample;
+    reader->pcm_start = 0;
+    reader->pcm_len = 0;
+
+    if (reader->data) {
+        /* Release whatever was skipped over so jumping forward through the
+         * file keeps resident memory bounded, and restart accounting here */
+        size_t mark = (size_t)(reader->data_offset + sample * reader->frame_bytes);
+        mark &= ~(reader->page_size - 1);
+        if (mark > reader->released) {
+            madvise((uint8_t *)reader->map + reader->released,
+                    mark - reader->released, MADV_DONTNEED);
+        }
+        reader->released = mark;
+    }
+}
+
+/* Converted mode: output samples in CONVERT_BLOCK steps */
+
+/* Compute output samples [start, start + count) into `out` */
+static bool convert_block(vu_wav_reader_t *reader, uint64_t start, size_t count,
+                          int16_t *out)
+{
+    int stages = reader->stages;
+    int top = stages + (reader->resampler ? 1 : 0);
+
+    /* Walk back from the output to the input range each stage reads. A
+     * half-band stage s needs stage s - 1 from 2 * start - radius, for
+     * 2 * count - 1 + 2 * radius samples */
+    int64_t first[CONVERT_MAX_STAGES + 2];
+    size_t len[CONVERT_MAX_STAGES + 2];
+    first[top] = (int64_t)start;
+    len[top] = count;
+    if (reader->resampler) {
+        vu_resampler_span(reader->resampler, start, count, &first[stages], &len[stages]);
+    }
+    for (int s = stages; s > 0; s--) {
+        first[s - 1] = 2 * first[s] - VU_HALFBAND_RADIUS;
+        len[s - 1] = 2 * len[s] - 1 + 2 * VU_HALFBAND_RADIUS;
+    }
+
+    /* Input, zero outside the data chunk. Blocks overlap by the filter
+     * span, so the raw cursor only moves forward while reading through */
+    int16_t *in = reader->stage[0];
+    int64_t raw_end = first[0] + (int64_t)len[0];
+    uint64_t from = first[0] > 0 ? (uint64_t)first[0] : 0;
+    uint64_t to = raw_end < (int64_t)reader->raw_count ? (uint64_t)raw_end : reader->raw_count;
+    memset(in, 0, len[0] * sizeof(int16_t));
+    if (to > from) {
+        if (reader->position <= from) {
+            raw_advance(reader, (size_t)(from - reader->position));
+        } else {
+            raw_seek(reader, from);
+        }
+        const int16_t *raw = raw_peek(reader, (size_t)(to - from));
+        if (!raw) return false;
+        memcpy(in + (from - first[0]), raw, (size_t)(to - from) * sizeof(int16_t));
+    }
+
+    for (int s = 1; s <= top; s++) {
+        int16_t *dst = s == top ? out : reader->stage[s];
+        if (s <= stages) {
+            vu_halfband_decimate(reader->stage[s - 1] + VU_HALFBAND_RADIUS, len[s], dst);
+        } else {
+            vu_resampler_run(reader->resampler, reader->stage[s - 1], first[s - 1],
+                             (uint64_t)first[s], len[s], dst);
+        }
+    }
+    return true;
+}
+
+bool vu_wav_reader_set_output_rate(vu_wav_reader_t *reader, uint32_t rate)
+{
+    if (!reader || rate == 0 || rate > reader->raw_rate) return false;
+
+    /* Whole halvings first: they are the cheapest way down */
+    uint32_t stage_rate = reader->raw_rate;
+    int stages = 0;
+    while (stages < CONVERT_MAX_STAGES && stage_rate % 2 == 0 && stage_rate / 2 >= rate) {
+        stage_rate /= 2;
+        stages++;
+    }
+
+    vu_resampler_destroy(reader->resampler);
+    reader->resampler = NULL;
+    if (stage_rate != rate) {
+        reader->resampler = vu_resampler_create(stage_rate, rate);
+        if (!reader->resampler) return false;
+    }
+
+    reader->stages = stages;
+    reader->info.sample_rate = rate;
+    reader->info.sample_count = reader->resampler ?
+        vu_resampler_output_count(reader->resampler, reader->raw_count >> stages) :
+        reader->raw_count >> stages;
+    reader->converting = stages > 0 || reader->resampler;
+    if (!reader->converting) return true;
+
+    /* Stage 0 is the widest: every stage's input for a whole block plus
+     * the filter margins */
+    int top = stages + (reader->resampler ? 1 : 0);
+    int64_t first;
+    size_t len = CONVERT_BLOCK;
+    for (int s = top; s > 0; s--) {
+        if (s > stages) {
+            /* Plus one: where floor(m * M / L) falls varies with the start */
+            vu_resampler_span(reader->resampler, 0, len, &first, &len);
+            len++;
+        } else {
+            len = 2 * len - 1 + 2 * VU_HALFBAND_RADIUS;
+        }
+        free(reader->stage[s - 1]);
+        reader->stage[s - 1] = malloc(len * sizeof(int16_t));
+        if (!reader->stage[s - 1]) return false;
+    }
+    if (!reader->out) {
+        reader->out_capacity = CONVERT_BLOCK;
+        reader->out = malloc(reader->out_capacity * sizeof(int16_t));
+        if (!reader->out) return false;
+    }
+
+    reader->out_position = 0;
+    reader->out_start = 0;
+    reader->out_len = 0;
+    return true;
+}
+
+const int16_t *vu_wav_reader_peek(vu_wav_reader_t *reader, size_t count)
+{
+    if (!reader) return NULL;
+    if (!reader->converting) return raw_peek(reader, count);
+
+    if (reader->out_position + count > reader->info.sample_count) return NULL;
+
+    size_t avail = reader->out_len - reader->out_start;
+    if (avail >= count) return reader->out + reader->out_start;
+
+    /* Compact, grow to whole blocks, and convert until `count` are ready */
+    size_t want = (count + CONVERT_BLOCK - 1) / CONVERT_BLOCK * CONVERT_BLOCK;
+    if (want > reader->out_capacity) {
+        int16_t *new_out = realloc(reader->out, want * sizeof(int16_t));
+        if (!new_out) return NULL;
+        reader->out = new_out;
+        reader->out_capacity = want;
+    }
+    memmove(reader->out, reader->out + reader->out_start, avail * sizeof(int16_t));
+    reader->out_start = 0;
+    reader->out_len = avail;
+
+    while (reader->out_len < count) {
+        uint64_t next = reader->out_position + reader->out_len;
+        uint64_t left = reader->info.sample_count - next;
+        size_t n = reader->out_capacity - reader->out_len;
+        if (n > CONVERT_BLOCK) n = CONVERT_BLOCK;
+        if (n > left) n = (size_t)left;
+        if (!convert_block(reader, next, n, reader->out + reader->out_len)) return NULL;
+        reader->out_len += n;
+    }
+    return reader->out;
+}
+
+void vu_wav_reader_advance(vu_wav_reader_t *reader, size_t count)
+{
+    if (!reader) return;
+    if (!reader->converting) {
+        raw_advance(reader, count);
+        return;
+    }
+
+    uint64_t left = reader->info.sample_count - reader->out_position;
+    if (count > left) count = (size_t)left;
+    reader->out_position += count;
+
+    size_t buffered = reader->out_len - reader->out_start;
+    if (count <= buffered) {
+        reader->out_start += count;
+    } else {
+        reader->out_start = 0;
+        reader->out_len = 0;
+    }
+}
+
+void vu_wav_reader_seek(vu_wav_reader_t *reader, uint64_t sample)
+{
+    if (!reader) return;
+    if (!reader->converting) {
+        raw_seek(reader, sample);
+        return;
+    }
+
+    /* Every output sample is a function of the input alone, so a seek
+     * reproduces exactly what reading through would have returned */
+    if (sample > reader->info.sample_count) sample = reader->info.sample_count;
+    reader->out_position = sample;
+    reader->out_start = 0;
+    reader->out_len = 0;
+}
+
+uint64_t vu_wav_reader_tell(const vu_wav_reader_t *reader)
+{
+    if (!reader) return 0;
+    return !reader->converting ? reader->position : reader->out_position;
+}
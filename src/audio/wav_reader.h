@@ -0,0 +1,99 @@
+/*
+ * voip-utility - SIP VoIP Testing Utility
+ * Streaming WAV file reader
+ */
+
+#ifndef VU_WAV_READER_H
+#define VU_WAV_READER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/* vu_wav_reader_set_channel: the mean of all channels */
+#define VU_WAV_CHANNEL_MIX (-1)
+
+/* WAV stream format (from the fmt chunk) */
+typedef struct vu_wav_info {
+    uint16_t audio_format;    /* WAVE format tag (1 = PCM, 3 = float,
+                               * 6 = A-law, 7 = mu-law, 0xFFFE = extensible) */
+    uint16_t num_channels;    /* Interleaved channel count */
+    uint32_t sample_rate;     /* Sample rate in Hz */
+    uint16_t block_align;     /* Bytes per sample frame */
+    uint16_t bits_per_sample; /* Bits per sample */
+    uint64_t data_size;       /* Size of the data chunk in bytes */
+    uint64_t sample_count;    /* Number of samples read: one per sample frame */
+    uint32_t source_rate;     /* Sample rate in the file (sample_rate is
+                               * the rate read, see set_output_rate) */
+} vu_wav_info_t;
+
+/* Opaque reader handle */
+typedef struct vu_wav_reader vu_wav_reader_t;
+
+/*
+ * Open WAV file for sequential reading.
+ * The data chunk is memory-mapped when possible, otherwise it is read
+ * through a large internal buffer. Either way each byte is read once.
+ * Every format is decoded on the fly to one int16 sample per sample frame
+ * (channel 0 unless set_channel says otherwise): 8/16/24/32-bit PCM,
+ * 32/64-bit float, mu-law and A-law, plain or WAVE_FORMAT_EXTENSIBLE.
+ * 16-bit mono PCM is returned in place, without a copy. RF64/BW64 files
+ * (over 4 GB) read like any other.
+ * Returns NULL on failure (check vu_get_last_error).
+ */
+vu_wav_reader_t *vu_wav_reader_open(const char *path);
+
+/*
+ * Close reader and release the mapping/buffer
+ */
+void vu_wav_reader_close(vu_wav_reader_t *reader);
+
+/*
+ * Get stream format
+ */
+const vu_wav_info_t *vu_wav_reader_get_info(const vu_wav_reader_t *reader);
+
+/*
+ * Read channel `channel` (0-based) of a multi-channel file, or with
+ * VU_WAV_CHANNEL_MIX the mean of all channels. Call before the first peek.
+ * Returns false if the file has no such channel.
+ */
+bool vu_wav_reader_set_channel(vu_wav_reader_t *reader, int channel);
+
+/*
+ * Get a pointer to the next `count` samples without consuming them.
+ * The pointer stays valid until the next peek/advance call.
+ * Returns NULL if fewer than `count` samples remain.
+ */
+const int16_t *vu_wav_reader_peek(vu_wav_reader_t *reader, size_t count);
+
+/*
+ * Consume `count` samples (e.g. one hop of an overlapping window)
+ */
+void vu_wav_reader_advance(vu_wav_reader_t *reader, size_t count);
+
+/*
+ * Reposition to sample `sample` (clamped to the end of the data).
+ * Used to start a reader in the middle of the file, e.g. one reader per
+ * worker thread each covering a different time range.
+ */
+void vu_wav_reader_seek(vu_wav_reader_t *reader, uint64_t sample);
+
+/*
+ * Read the stream converted to `rate`: low-pass filtered and halved by
+ * half-band stages while that stays at or above `rate`, then resampled
+ * by a polyphase filter for any ratio left (44.1 kHz -> 8 kHz is two
+ * halvings and 11025 -> 8000). sample_rate and sample_count in the info,
+ * and every position, are then in output samples; seeking returns
+ * exactly what reading through would. Call before the first peek.
+ * Returns false on failure or if `rate` is above the file's rate (only
+ * downsampling is supported).
+ */
+bool vu_wav_reader_set_output_rate(vu_wav_reader_t *reader, uint32_t rate);
+
+/*
+ * Get number of samples consumed so far
+ */
+uint64_t vu_wav_reader_tell(const vu_wav_reader_t *reader);
+
+#endif /* VU_WAV_READER_H */
@@ -8,6 +8,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
 #include <getopt.h>
 
 #define VERSION "0.1.0"
@@ -131,6 +132,12 @@ void vu_cli_print_command_help(vu_command_t cmd)
         printf("  -b, --beeps          Show detected beeps\n");
         printf("  -D, --dtmf           Show detected DTMF tones\n");
         printf("  -s, --stats          Show audio statistics\n");
+        printf("  -A, --vad            Show voice activity segments\n");
+        printf("  -P, --tones          Show call progress tones (dial, ringback, busy)\n");
+        printf("  -T, --threads <n>    Analysis worker threads (default: 1, 0 = all cores)\n");
+        printf("  -H, --hop <ms>       Frame step for finer beep timing (default: half a frame)\n");
+        printf("  -R, --rate <hz>      Resample faster input to this rate (default: file rate)\n");
+        printf("  -C, --channel <n>    Channel of multi-channel files, or 'mix' (default: 0)\n");
         break;
 
     default:
@@ -163,6 +170,54 @@ static vu_command_t parse_command(const char *str)
     return VU_CMD_NONE;
 }
 
+/*
+ * Parse option `name`'s argument `text` as a whole integer in [min, max].
+ * Returns false with the error set if it is not one.
+ */
+static bool parse_int_arg(const char *name, const char *text, long min, long max, int *value)
+{
+    char *end;
+    errno = 0;
+    long parsed = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || errno == ERANGE || parsed < min || parsed > max) {
+        VU_SET_ERROR(VU_ERR_INVALID_ARG, "Invalid %s '%s' (expected %ld to %ld)",
+                     name, text, min, max);
+        return false;
+    }
+    *value = (int)parsed;
+    return true;
+}
+
+/*
+ * Parse option `name`'s argument `text` as a number in [min, max].
+ * Returns false with the error set if it is not one.
+ */
+static bool parse_float_arg(const char *name, const char *text, double min, double max,
+                            float *value)
+{
+    char *end;
+    errno = 0;
+    double parsed = strtod(text, &end);
+    if (end == text || *end != '\0' || errno == ERANGE || !(parsed >= min && parsed <= max)) {
+        VU_SET_ERROR(VU_ERR_INVALID_ARG, "Invalid %s '%s' (expected %g to %g)",
+                     name, text, min, max);
+        return false;
+    }
+    *value = (float)parsed;
+    return true;
+}
+
+/* Largest --threads accepted (the analyzer caps it lower) */
+#define MAX_THREADS_ARG 1024
+
+/* Longest --hop accepted, in ms (0 = half a frame) */
+#define MAX_HOP_MS_ARG 1000.0
+
+/* --rate bounds in Hz (0 = the file's rate): the telephony band up to
+ * the fastest WAV rates in use */
+#define MIN_RATE_ARG 8000
+#define MAX_RATE_ARG 384000
+
 /* Long-only global option values (no short equivalent) */
 #define VU_OPT_SIP_PORT 1000
 #define VU_OPT_CODECS   1001
@@ -240,6 +295,12 @@ static struct option analyze_options[] = {
     {"beeps", no_argument, 0, 'b'},
     {"dtmf",  no_argument, 0, 'D'},
     {"stats", no_argument, 0, 's'},
+    {"vad",   no_argument, 0, 'A'},
+    {"tones", no_argument, 0, 'P'},
+    {"threads", required_argument, 0, 'T'},
+    {"hop",   required_argument, 0, 'H'},
+    {"rate",  required_argument, 0, 'R'},
+    {"channel", required_argument, 0, 'C'},
     {"help",  no_argument, 0, 'h'},
     {0, 0, 0, 0}
 };
@@ -382,11 +443,42 @@ vu_error_t vu_cli_parse(int argc, char **argv, vu_cli_args_t *args)
         break;
 
     case VU_CMD_ANALYZE:
-        while ((opt = getopt_long(cmd_argc, cmd_argv, "bDsh", analyze_options, NULL)) != -1) {
+        args->cmd.analyze.threads = 1;  /* default: serial */
+        while ((opt = getopt_long(cmd_argc, cmd_argv, "bDsAPT:H:R:C:h", analyze_options, NULL)) != -1) {
             switch (opt) {
             case 'b': args->cmd.analyze.show_beeps = true; break;
             case 'D': args->cmd.analyze.show_dtmf = true; break;
             case 's': args->cmd.analyze.show_stats = true; break;
+            case 'A': args->cmd.analyze.show_vad = true; break;
+            case 'P': args->cmd.analyze.show_tones = true; break;
+            case 'T':
+                if (!parse_int_arg("--threads", optarg, 0, MAX_THREADS_ARG,
+                                   &args->cmd.analyze.threads)) {
+                    return VU_ERR_INVALID_ARG;
+                }
+                break;
+            case 'H':
+                if (!parse_float_arg("--hop", optarg, 0.0, MAX_HOP_MS_ARG,
+                                     &args->cmd.analyze.hop_ms)) {
+                    return VU_ERR_INVALID_ARG;
+                }
+                break;
+            case 'R':
+                if (strcmp(optarg, "0") != 0 &&
+                    !parse_int_arg("--rate", optarg, MIN_RATE_ARG, MAX_RATE_ARG,
+                                   &args->cmd.analyze.analysis_rate)) {
+                    return VU_ERR_INVALID_ARG;
+                }
+                break;
+            case 'C':
+                /* -1 is 'mix'; the file's channel count is checked when it is opened */
+                if (strcmp(optarg, "mix") == 0) {
+                    args->cmd.analyze.channel = -1;
+                } else if (!parse_int_arg("--channel", optarg, -1, UINT16_MAX - 1,
+                                          &args->cmd.analyze.channel)) {
+                    return VU_ERR_INVALID_ARG;
+                }
+                break;
             case 'h': vu_cli_print_command_help(VU_CMD_ANALYZE); exit(0);
             }
         }
@@ -85,6 +85,12 @@ typedef struct vu_analyze_opts {
     bool show_beeps;            /* Show detected beeps */
     bool show_dtmf;             /* Show detected DTMF */
     bool show_stats;            /* Show audio statistics */
+    bool show_vad;              /* Show voice activity segments */
+    bool show_tones;            /* Show call progress tones */
+    int threads;                /* Analysis worker threads (0 = all cores) */
+    float hop_ms;               /* Frame step in ms (0 = half a frame) */
+    int analysis_rate;          /* Resample to this rate (0 = file rate) */
+    int channel;                /* Channel to analyze (-1 = mix of all) */
 } vu_analyze_opts_t;
 
 /* Parsed CLI arguments */
@@ -6,9 +6,125 @@
 #include "cli/cli.h"
 #include "audio/analyzer.h"
 #include "audio/beep_detector.h"
+#include "audio/call_progress.h"
+#include "audio/dtmf_detector.h"
+#include "audio/pipeline.h"
+#include "audio/vad.h"
 #include "util/log.h"
 #include <stdio.h>
 
+/* Level statistics over the whole file */
+typedef struct {
+    float freq_sum;
+    float level_sum;
+    float max_level;
+    int valid_count;
+} level_stats_t;
+
+/* Detectors fed by the analysis pipeline (NULL = not requested) */
+typedef struct {
+    level_stats_t *stats;
+    vu_beep_detector_t *beeps;
+    vu_dtmf_detector_t *dtmf;
+    vu_vad_t *vad;
+    vu_call_progress_t *tones;
+} analyze_ctx_t;
+
+static bool on_level_frame(void *user_data, const vu_analysis_frame_t *frame)
+{
+    level_stats_t *stats = user_data;
+    const vu_freq_result_t *result = &frame->freq;
+
+    if (result->magnitude_db > stats->max_level) {
+        stats->max_level = result->magnitude_db;
+    }
+    if (result->valid) {
+        stats->freq_sum += result->frequency;
+        stats->level_sum += result->magnitude_db;
+        stats->valid_count++;
+    }
+
+    /* Show first few frame details for debugging */
+    if (frame->index == 0) {
+        VU_LOG_DEBUG("First 5 frames:");
+    }
+    if (frame->index < 5) {
+        VU_LOG_DEBUG("  Frame %zu: freq=%.1f Hz, level=%.1f dB, valid=%d",
+                    frame->index, result->frequency, result->magnitude_db, result->valid);
+    }
+    return true;
+}
+
+static bool on_beep_frame(void *user_data, const vu_analysis_frame_t *frame)
+{
+    vu_beep_event_t event;
+    if (vu_beep_detector_process_frame(user_data, frame, &event)) {
+        VU_LOG_INFO("  Beep #%d: %.3fs - %.3fs (%.0fms) @ %.0fHz, %.1fdB",
+                    event.beep_index + 1,
+                    event.start_time_sec,
+                    event.end_time_sec,
+                    event.duration_sec * 1000,
+                    event.frequency_hz,
+                    event.avg_level_db);
+    }
+    return true;
+}
+
+static void log_digit(const vu_dtmf_event_t *event)
+{
+    VU_LOG_INFO("  DTMF '%c': %.3fs - %.3fs (%.0fms), %.1f/%.1fdB",
+                event->digit, event->start_time_sec, event->end_time_sec,
+                event->duration_sec * 1000, event->low_level_db, event->high_level_db);
+}
+
+static bool on_dtmf_frame(void *user_data, const vu_analysis_frame_t *frame)
+{
+    vu_dtmf_event_t event;
+    if (vu_dtmf_detector_process_frame(user_data, frame, &event)) {
+        log_digit(&event);
+    }
+    return true;
+}
+
+static void log_segment(const vu_vad_segment_t *segment)
+{
+    VU_LOG_INFO("  Voice: %.3fs - %.3fs (%.0fms)", segment->start_time_sec,
+                segment->end_time_sec, segment->duration_sec * 1000);
+}
+
+static bool on_vad_frame(void *user_data, const vu_analysis_frame_t *frame)
+{
+    vu_vad_segment_t segment;
+    if (vu_vad_process_frame(user_data, frame, &segment)) {
+        log_segment(&segment);
+    }
+    return true;
+}
+
+static void log_tone(const vu_tone_event_t *event)
+{
+    VU_LOG_INFO("  Tone: %s %.3fs - %.3fs (%.0fms), %.1fdB", vu_tone_kind_name(event->kind),
+                event->start_time_sec, event->end_time_sec, event->duration_sec * 1000,
+                event->level_db);
+}
+
+static bool on_tone_frame(void *user_data, const vu_analysis_frame_t *frame)
+{
+    vu_tone_event_t event;
+    if (vu_call_progress_process_frame(user_data, frame, &event)) {
+        log_tone(&event);
+    }
+    return true;
+}
+
+static void destroy_detectors(analyze_ctx_t *ctx)
+{
+    vu_beep_detector_destroy(ctx->beeps);
+    vu_dtmf_detector_destroy(ctx->dtmf);
+    vu_vad_destroy(ctx->vad);
+    vu_call_progress_destroy(ctx->tones);
+}
+
 int vu_cmd_analyze(const vu_cli_args_t *args, vu_config_t *config)
 {
     if (!args) return 1;
@@ -29,99 +145,134 @@ int vu_cmd_analyze(const vu_cli_args_t *args, vu_config_t *config)
         analyzer_config.min_level_db = config->beep.min_level_db;
         analyzer_config.freq_tolerance_hz = config->beep.freq_tolerance_hz;
     }
+    analyzer_config.num_threads = opts->threads > 0 ? opts->threads : VU_ANALYZER_THREADS_AUTO;
+    analyzer_config.hop_ms = opts->hop_ms;
+    analyzer_config.analysis_rate = opts->analysis_rate;
+    analyzer_config.channel = opts->channel < 0 ? VU_ANALYZER_CHANNEL_MIX : opts->channel;
+
+    bool want_stats = opts->show_stats || (!opts->show_beeps && !opts->show_dtmf &&
+                                           !opts->show_vad && !opts->show_tones);
+    bool want_spectrum = opts->show_dtmf || opts->show_vad || opts->show_tones;
+
+    level_stats_t stats = {.max_level = -200};
+    analyze_ctx_t ctx = {.stats = want_stats ? &stats : NULL};
+
+    vu_beep_config_t beep_config = config ? config->beep : (vu_beep_config_t){
+        .min_level_db = -40,
+        .min_duration_sec = 0.05,
+        .max_duration_sec = 2.0,
+        .target_freq_hz = 0,
+        .freq_tolerance_hz = 50,
+        .gap_duration_sec = 0.1
+    };
+
+    /* One detector per requested report; the spectral ones share the
+     * frame's FFT through the pipeline */
+    if (opts->show_beeps) {
+        /* The sample rate comes with the frames */
+        ctx.beeps = vu_beep_detector_create(&beep_config, 0);
+
+        /* Beeps only: a known target needs just its own Goertzel filter */
+        if (!want_stats && !want_spectrum) {
+            vu_beep_detector_configure_analyzer(&beep_config, &analyzer_config);
+        }
+    }
+    if (opts->show_dtmf) ctx.dtmf = vu_dtmf_detector_create(NULL);
+    if (opts->show_vad) ctx.vad = vu_vad_create(NULL);
+    if (opts->show_tones) ctx.tones = vu_call_progress_create(NULL);
+
+    if ((opts->show_beeps && !ctx.beeps) || (opts->show_dtmf && !ctx.dtmf) ||
+        (opts->show_vad && !ctx.vad) || (opts->show_tones && !ctx.tones)) {
+        VU_LOG_ERROR("Failed to create detectors");
+        destroy_detectors(&ctx);
+        return 1;
+    }
+
+    /* Fine hops on a few target bins: a sliding DFT costs far less than
+     * re-running the filters over every overlapping frame */
+    if (opts->hop_ms > 0 && analyzer_config.target_count > 0) {
+        analyzer_config.sliding_dft = true;
+    }
 
-    size_t result_count = 0;
-    vu_freq_result_t *results = vu_analyzer_analyze_file(opts->input_file, &analyzer_config, &result_count);
+    vu_pipeline_t *pipeline = vu_pipeline_create(&analyzer_config);
+    if (!pipeline) {
+        destroy_detectors(&ctx);
+        return 1;
+    }
+    if (ctx.stats) vu_pipeline_subscribe(pipeline, "level", on_level_frame, ctx.stats, false);
+    if (ctx.beeps) vu_pipeline_subscribe(pipeline, "beep", on_beep_frame, ctx.beeps, false);
+    if (ctx.dtmf) vu_pipeline_subscribe(pipeline, "dtmf", on_dtmf_frame, ctx.dtmf, true);
+    if (ctx.vad) vu_pipeline_subscribe(pipeline, "vad", on_vad_frame, ctx.vad, true);
+    if (ctx.tones) vu_pipeline_subscribe(pipeline, "tones", on_tone_frame, ctx.tones, true);
 
-    if (!results) {
+    vu_analysis_summary_t summary;
+    vu_error_t err = vu_pipeline_run_file(pipeline, opts->input_file, &summary);
+    vu_pipeline_destroy(pipeline);
+    if (err != VU_OK || summary.frame_count == 0) {
         VU_LOG_ERROR("Failed to analyze file: %s", opts->input_file);
+        destroy_detectors(&ctx);
         return 1;
     }
 
-    VU_LOG_INFO("Analyzed %zu frames", result_count);
+    /* Events still open when the audio ran out */
+    vu_dtmf_event_t digit;
+    if (vu_dtmf_detector_flush(ctx.dtmf, summary.duration_sec, &digit)) log_digit(&digit);
+    vu_vad_segment_t segment;
+    if (vu_vad_flush(ctx.vad, summary.duration_sec, &segment)) log_segment(&segment);
+    vu_tone_event_t tone;
+    if (vu_call_progress_flush(ctx.tones, summary.duration_sec, &tone)) log_tone(&tone);
 
-    /* Show frequency statistics */
-    if (opts->show_stats || (!opts->show_beeps && !opts->show_dtmf)) {
-        /* Find dominant frequencies */
-        float freq_sum = 0;
-        float level_sum = 0;
-        float max_level = -200;
-        int valid_count = 0;
-
-        for (size_t i = 0; i < result_count; i++) {
-            if (results[i].magnitude_db > max_level) {
-                max_level = results[i].magnitude_db;
-            }
-            if (results[i].valid) {
-                freq_sum += results[i].frequency;
-                level_sum += results[i].magnitude_db;
-                valid_count++;
-            }
-        }
+    if (summary.cached) {
+        VU_LOG_INFO("Analyzed %zu frames (cached results, file unchanged)", summary.frame_count);
+    } else {
+        VU_LOG_INFO("Analyzed %zu frames", summary.frame_count);
+    }
+    if (summary.sample_rate != summary.source_rate) {
+        VU_LOG_INFO("Resampled %u Hz to %u Hz for analysis", summary.source_rate,
+                    summary.sample_rate);
+    }
 
+    /* Show frequency statistics */
+    if (ctx.stats) {
         VU_LOG_INFO("Audio statistics:");
-        VU_LOG_INFO("  Total frames: %zu", result_count);
-        VU_LOG_INFO("  Valid frames (above threshold): %d", valid_count);
-        VU_LOG_INFO("  Peak level: %.1f dB", max_level);
+        VU_LOG_INFO("  Total frames: %zu", summary.frame_count);
+        VU_LOG_INFO("  Valid frames (above threshold): %d", stats.valid_count);
+        VU_LOG_INFO("  Peak level: %.1f dB", stats.max_level);
         VU_LOG_INFO("  Threshold: %.1f dB", analyzer_config.min_level_db);
-
-        /* Show first few frame details for debugging */
-        VU_LOG_DEBUG("First 5 frames:");
-        for (size_t i = 0; i < result_count && i < 5; i++) {
-            VU_LOG_DEBUG("  Frame %zu: freq=%.1f Hz, level=%.1f dB, valid=%d",
-                        i, results[i].frequency, results[i].magnitude_db, results[i].valid);
+        if (!summary.cached) {
+            VU_LOG_INFO("  FFTs skipped (below threshold): %llu of %zu",
+                        (unsigned long long)summary.ffts_skipped, summary.frame_count);
         }
-        if (valid_count > 0) {
-            VU_LOG_INFO("  Average frequency: %.1f Hz", freq_sum / valid_count);
-            VU_LOG_INFO("  Average level: %.1f dB", level_sum / valid_count);
+
+        if (stats.valid_count > 0) {
+            VU_LOG_INFO("  Average frequency: %.1f Hz", stats.freq_sum / stats.valid_count);
+            VU_LOG_INFO("  Average level: %.1f dB", stats.level_sum / stats.valid_count);
         }
     }
 
-    /* Detect beeps */
-    if (opts->show_beeps) {
-        vu_beep_config_t beep_config = config ? config->beep : (vu_beep_config_t){
-            .min_level_db = -40,
-            .min_duration_sec = 0.05,
-            .max_duration_sec = 2.0,
-            .target_freq_hz = 0,
-            .freq_tolerance_hz = 50,
-            .gap_duration_sec = 0.1
-        };
-
-        /* Use sample rate from file (assume 8000 if not available) */
-        vu_beep_detector_t *detector = vu_beep_detector_create(&beep_config, 8000);
-        if (detector) {
-            double frame_duration = (double)analyzer_config.fft_size / 2 / 8000.0;  /* 50% overlap */
-            vu_level_result_t level = {0};
-
-            for (size_t i = 0; i < result_count; i++) {
-                double time = i * frame_duration;
-                level.rms_db = results[i].magnitude_db;
-                level.is_silence = !results[i].valid;
-
-                vu_beep_event_t event;
-                if (vu_beep_detector_process(detector, &results[i], &level, time, &event)) {
-                    VU_LOG_INFO("  Beep #%d: %.3fs - %.3fs (%.0fms) @ %.0fHz, %.1fdB",
-                                event.beep_index + 1,
-                                event.start_time_sec,
-                                event.end_time_sec,
-                                event.duration_sec * 1000,
-                                event.frequency_hz,
-                                event.avg_level_db);
-                }
-            }
-
-            const vu_beep_result_t *result = vu_beep_detector_get_result(detector);
-            VU_LOG_INFO("Detected beeps: %d", result->valid_beep_count);
-
-            vu_beep_detector_destroy(detector);
-        }
+    if (ctx.beeps) {
+        const vu_beep_result_t *result = vu_beep_detector_get_result(ctx.beeps);
+        VU_LOG_INFO("Detected beeps: %d", result->valid_beep_count);
+    }
+
+    if (ctx.dtmf) {
+        const char *digits = vu_dtmf_detector_get_digits(ctx.dtmf);
+        VU_LOG_INFO("Detected DTMF digits: %s", digits[0] ? digits : "(none)");
+    }
+
+    if (ctx.vad) {
+        const vu_vad_result_t *result = vu_vad_get_result(ctx.vad);
+        VU_LOG_INFO("Voice activity: %d segments, %.2fs of %.2fs", result->segment_count,
+                    result->active_sec, summary.duration_sec);
     }
 
-    if (opts->show_dtmf) {
-        VU_LOG_INFO("DTMF detection: (not yet implemented)");
+    if (ctx.tones) {
+        const int *counts = vu_call_progress_get_counts(ctx.tones);
+        VU_LOG_INFO("Call progress tones: dial %d, ringback %d, busy %d, reorder %d",
+                    counts[VU_TONE_DIAL], counts[VU_TONE_RINGBACK], counts[VU_TONE_BUSY],
+                    counts[VU_TONE_REORDER]);
     }
 
-    vu_analyzer_free_results(results);
+    destroy_detectors(&ctx);
     return 0;
 }
@@ -54,6 +54,18 @@ static bool json_get_bool(const cJSON *obj, const char *key, bool def)
     return def;
 }
 
+/* Get home directory */
+static const char *get_home_dir(void)
+{
+    const char *home = getenv("HOME");
+    if (home) return home;
+
+    struct passwd *pw = getpwuid(getuid());
+    if (pw) return pw->pw_dir;
+
+    return "/tmp";
+}
+
 vu_config_t vu_config_defaults(void)
 {
     vu_config_t config = {0};
@@ -62,6 +74,7 @@ vu_config_t vu_config_defaults(void)
     config.audio.sample_rate = 16000;
     config.audio.frame_duration_ms = 20;
     safe_strcpy(config.audio.default_codec, sizeof(config.audio.default_codec), "PCMU");
+    safe_strcpy(config.audio.recorder_backend, sizeof(config.audio.recorder_backend), "thread");
 
     /* Beep detection defaults */
     config.beep.min_level_db = -40.0;
@@ -71,6 +84,18 @@ vu_config_t vu_config_defaults(void)
     config.beep.freq_tolerance_hz = 50.0;
     config.beep.gap_duration_sec = 0.1;
 
+    /* Analysis defaults */
+    safe_strcpy(config.analysis.fft_planner, sizeof(config.analysis.fft_planner), "estimate");
+    config.analysis.fft_wisdom = true;
+    snprintf(config.analysis.wisdom_file, sizeof(config.analysis.wisdom_file),
+             "%s/.config/voip-utility/fftw_wisdom", get_home_dir());
+    config.analysis.result_cache = false;
+    snprintf(config.analysis.cache_dir, sizeof(config.analysis.cache_dir),
+             "%s/.cache/voip-utility/analysis", get_home_dir());
+    config.analysis.cache_max_mb = 256;
+    config.analysis.live_workers = 0;
+    config.analysis.live_queue_frames = 50;
+
     /* Paths - use current directory by default */
     safe_strcpy(config.recordings_dir, sizeof(config.recordings_dir), ".");
     safe_strcpy(config.tests_dir, sizeof(config.tests_dir), ".");
@@ -213,18 +238,6 @@ static bool file_exists(const char *path)
     return stat(path, &st) == 0 && S_ISREG(st.st_mode);
 }
 
-/* Get home directory */
-static const char *get_home_dir(void)
-{
-    const char *home = getenv("HOME");
-    if (home) return home;
-
-    struct passwd *pw = getpwuid(getuid());
-    if (pw) return pw->pw_dir;
-
-    return "/tmp";
-}
-
 vu_error_t vu_config_load(vu_config_t *config, const char *path)
 {
     if (!config) {
@@ -320,6 +333,8 @@ vu_error_t vu_config_load(vu_config_t *config, const char *path)
                                                                      config->audio.frame_duration_ms);
         safe_strcpy(config->audio.default_codec, sizeof(config->audio.default_codec),
                     json_get_string(audio, "default_codec", config->audio.default_codec));
+        safe_strcpy(config->audio.recorder_backend, sizeof(config->audio.recorder_backend),
+                    json_get_string(audio, "recorder_backend", config->audio.recorder_backend));
     }
 
     /* Parse beep detection settings */
@@ -333,6 +348,25 @@ vu_error_t vu_config_load(vu_config_t *config, const char *path)
         config->beep.gap_duration_sec = json_get_number(beep, "gap_duration_sec", config->beep.gap_duration_sec);
     }
 
+    /* Parse analysis settings */
+    cJSON *analysis = cJSON_GetObjectItem(root, "analysis");
+    if (cJSON_IsObject(analysis)) {
+        safe_strcpy(config->analysis.fft_planner, sizeof(config->analysis.fft_planner),
+                    json_get_string(analysis, "fft_planner", config->analysis.fft_planner));
+        config->analysis.fft_wisdom = json_get_bool(analysis, "fft_wisdom", config->analysis.fft_wisdom);
+        safe_strcpy(config->analysis.wisdom_file, sizeof(config->analysis.wisdom_file),
+                    json_get_string(analysis, "wisdom_file", config->analysis.wisdom_file));
+        config->analysis.result_cache = json_get_bool(analysis, "result_cache", config->analysis.result_cache);
+        safe_strcpy(config->analysis.cache_dir, sizeof(config->analysis.cache_dir),
+                    json_get_string(analysis, "cache_dir", config->analysis.cache_dir));
+        config->analysis.cache_max_mb = (uint32_t)json_get_number(analysis, "cache_max_mb",
+                                                                  config->analysis.cache_max_mb);
+        config->analysis.live_workers = (int)json_get_number(analysis, "live_workers",
+                                                             config->analysis.live_workers);
+        config->analysis.live_queue_frames = (uint32_t)json_get_number(analysis, "live_queue_frames",
+                                                                       config->analysis.live_queue_frames);
+    }
+
     /* Parse TLS settings */
     cJSON *tls = cJSON_GetObjectItem(root, "tls");
     if (cJSON_IsObject(tls)) {
@@ -405,6 +439,7 @@ vu_error_t vu_config_save(const vu_config_t *config, const char *path)
     cJSON_AddNumberToObject(audio, "sample_rate", config->audio.sample_rate);
     cJSON_AddNumberToObject(audio, "frame_duration_ms", config->audio.frame_duration_ms);
     cJSON_AddStringToObject(audio, "default_codec", config->audio.default_codec);
+    cJSON_AddStringToObject(audio, "recorder_backend", config->audio.recorder_backend);
 
     /* Add beep detection settings */
     cJSON *beep = cJSON_AddObjectToObject(root, "beep_detection");
@@ -415,6 +450,17 @@ vu_error_t vu_config_save(const vu_config_t *config, const char *path)
     cJSON_AddNumberToObject(beep, "freq_tolerance_hz", config->beep.freq_tolerance_hz);
     cJSON_AddNumberToObject(beep, "gap_duration_sec", config->beep.gap_duration_sec);
 
+    /* Add analysis settings */
+    cJSON *analysis = cJSON_AddObjectToObject(root, "analysis");
+    cJSON_AddStringToObject(analysis, "fft_planner", config->analysis.fft_planner);
+    cJSON_AddBoolToObject(analysis, "fft_wisdom", config->analysis.fft_wisdom);
+    cJSON_AddStringToObject(analysis, "wisdom_file", config->analysis.wisdom_file);
+    cJSON_AddBoolToObject(analysis, "result_cache", config->analysis.result_cache);
+    cJSON_AddStringToObject(analysis, "cache_dir", config->analysis.cache_dir);
+    cJSON_AddNumberToObject(analysis, "cache_max_mb", config->analysis.cache_max_mb);
+    cJSON_AddNumberToObject(analysis, "live_workers", config->analysis.live_workers);
+    cJSON_AddNumberToObject(analysis, "live_queue_frames", config->analysis.live_queue_frames);
+
     /* Add TLS settings */
     cJSON *tls = cJSON_AddObjectToObject(root, "tls");
     cJSON_AddStringToObject(tls, "ca_file", config->tls_ca_file);
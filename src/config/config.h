@@ -73,8 +73,28 @@ typedef struct vu_audio_config {
     uint32_t sample_rate;                    /* Sample rate (default 16000) */
     uint32_t frame_duration_ms;              /* Frame size in ms (default 20) */
     char default_codec[32];                  /* Preferred codec (default "PCMU") */
+    char recorder_backend[16];               /* "thread" or "io_uring" (default "thread") */
 } vu_audio_config_t;
 
+/* Analysis engine configuration */
+typedef struct vu_analysis_config {
+    char fft_planner[16];                    /* FFTW planner: "estimate" (default),
+                                                "measure" or "patient" */
+    bool fft_wisdom;                         /* Load/save FFTW wisdom (default true) */
+    char wisdom_file[VU_MAX_PATH_LEN];       /* Wisdom file (default
+                                                ~/.config/voip-utility/fftw_wisdom) */
+    bool result_cache;                       /* Reuse results of unchanged files
+                                                in `analyze` (default false) */
+    char cache_dir[VU_MAX_PATH_LEN];         /* Result cache (default
+                                                ~/.cache/voip-utility/analysis) */
+    uint32_t cache_max_mb;                   /* Cache size cap, least recently
+                                                used pruned first (default 256) */
+    int live_workers;                        /* Live call analysis threads
+                                                (default 0 = one per CPU) */
+    uint32_t live_queue_frames;              /* Frames queued per call for its
+                                                worker (default 50) */
+} vu_analysis_config_t;
+
 /* Main configuration structure */
 typedef struct vu_config {
     /* Accounts */
@@ -87,6 +107,9 @@ typedef struct vu_config {
     /* Beep detection defaults */
     vu_beep_config_t beep;
 
+    /* Analysis engine */
+    vu_analysis_config_t analysis;
+
     /* Paths */
     char recordings_dir[VU_MAX_PATH_LEN];    /* Directory for recordings */
     char tests_dir[VU_MAX_PATH_LEN];         /* Directory for test files */
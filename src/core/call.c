@@ -53,9 +53,21 @@ void vu_call_manager_cleanup(vu_call_manager_t *mgr)
     if (!mgr) return;
 
     vu_call_hangup_all(mgr);
+    for (int i = 0; i < VU_MAX_CALLS; i++) {
+        vu_media_disconnect_analysis(&mgr->calls[i]);
+    }
     memset(mgr, 0, sizeof(*mgr));
 }
 
+/* Clear a slot for a new call. A previous call's live analysis outlives
+ * its hangup so the results can still be read; it is released here at
+ * the latest, before the slot forgets it. */
+static void reset_slot(vu_call_t *call)
+{
+    vu_media_disconnect_analysis(call);
+    memset(call, 0, sizeof(*call));
+}
+
 /* Find a free call slot */
 static vu_call_t *find_free_slot(vu_call_manager_t *mgr)
 {
@@ -93,7 +105,7 @@ vu_call_t *vu_call_make(vu_call_manager_t *mgr, vu_account_t *account,
     }
 
     /* Initialize call */
-    memset(call, 0, sizeof(*call));
+    reset_slot(call);
     call->pjsua_id = PJSUA_INVALID_ID;
     call->direction = VU_CALL_DIR_OUTBOUND;
     strncpy(call->remote_uri, uri, sizeof(call->remote_uri) - 1);
@@ -316,7 +328,9 @@ void vu_call_on_state_change(vu_call_t *call, pjsua_call_info *ci)
         }
         break;
     case PJSIP_INV_STATE_DISCONNECTED:
-        /* Cleanup media before marking call as disconnected */
+        /* Cleanup media before marking call as disconnected; live analysis
+         * stays until the call manager is cleaned up, so its results can
+         * still be read after hangup */
         vu_media_stop_recording(call);
         vu_media_stop_playback(call, -1);
         call->state = VU_CALL_STATE_DISCONNECTED;
@@ -339,6 +353,7 @@ void vu_call_on_media_state(vu_call_t *call, pjsua_call_info *ci)
     case PJSUA_CALL_MEDIA_ACTIVE:
         call->media_state = VU_CALL_MEDIA_ACTIVE;
         call->conf_port = ci->conf_slot;
+        vu_media_reconnect_analysis(call, ci->conf_slot);
         break;
     case PJSUA_CALL_MEDIA_LOCAL_HOLD:
         call->media_state = VU_CALL_MEDIA_LOCAL_HOLD;
@@ -369,7 +384,7 @@ vu_call_t *vu_call_on_incoming(vu_call_manager_t *mgr, pjsua_call_id call_id,
     }
 
     /* Initialize call */
-    memset(call, 0, sizeof(*call));
+    reset_slot(call);
     call->pjsua_id = call_id;
     call->direction = VU_CALL_DIR_INBOUND;
     call->state = VU_CALL_STATE_INCOMING;
@@ -4,10 +4,12 @@
  */
 
 #include "core/media.h"
+#include "audio/audio_port.h"
 #include "util/log.h"
 #include "util/error.h"
 #include <string.h>
 #include <stdlib.h>
+#include <unistd.h>
 
 /* Player info stored in call */
 typedef struct {
@@ -17,30 +19,143 @@ typedef struct {
 
 /* Recorder info stored in call */
 typedef struct {
-    pjsua_recorder_id id;
-    pjsua_conf_port_id port;
+    vu_audio_port_t *port;     /* Holds the vu_recorder_t */
+    pjsua_conf_port_id slot;
 } recorder_info_t;
 
-vu_error_t vu_media_connect_analysis(vu_call_t *call)
+/* Analysis port info stored in call */
+typedef struct {
+    pj_pool_t *pool;
+    vu_audio_port_t *port;
+    pjsua_conf_port_id slot;
+} analysis_info_t;
+
+vu_error_t vu_media_connect_analysis(vu_call_t *call, const vu_beep_config_t *beep_config)
 {
     if (!call) {
         VU_SET_ERROR(VU_ERR_INVALID_ARG, "call is NULL");
         return VU_ERR_INVALID_ARG;
     }
 
-    /* TODO: Create and connect custom audio analysis port */
-    VU_LOG_DEBUG("Media analysis connected for call %d", call->pjsua_id);
+    if (call->pjsua_id == PJSUA_INVALID_ID) {
+        VU_SET_ERROR(VU_ERR_CALL_NOT_ACTIVE, "Call not active");
+        return VU_ERR_CALL_NOT_ACTIVE;
+    }
+
+    if (call->analysis_port) {
+        VU_LOG_WARN("Analysis already connected for call %d", call->pjsua_id);
+        return VU_OK;
+    }
+
+    pjsua_call_info ci;
+    pj_status_t status = pjsua_call_get_info(call->pjsua_id, &ci);
+    if (status != PJ_SUCCESS || ci.conf_slot == PJSUA_INVALID_ID) {
+        VU_SET_ERROR(VU_ERR_MEDIA_ERROR, "Call has no active media");
+        return VU_ERR_MEDIA_ERROR;
+    }
+
+    /* Run at the call's own rate (the codec's, e.g. 8 kHz for G.711) so
+     * the bridge does not resample for us */
+    pjsua_conf_port_info slot_info;
+    status = pjsua_conf_get_port_info(ci.conf_slot, &slot_info);
+    if (status != PJ_SUCCESS) {
+        VU_SET_PJSIP_ERROR(VU_ERR_MEDIA_ERROR, status, "Failed to get call media port info");
+        return VU_ERR_MEDIA_ERROR;
+    }
+
+    analysis_info_t *info = calloc(1, sizeof(analysis_info_t));
+    if (!info) {
+        VU_SET_ERROR(VU_ERR_NO_MEMORY, "Failed to allocate analysis info");
+        return VU_ERR_NO_MEMORY;
+    }
+    info->slot = PJSUA_INVALID_ID;
+
+    info->pool = pjsua_pool_create("vu_analysis", 4096, 4096);
+    if (info->pool) {
+        info->port = vu_audio_port_create(info->pool, slot_info.clock_rate,
+                                          slot_info.samples_per_frame / slot_info.channel_count,
+                                          0);
+    }
+    if (!info->port) {
+        if (info->pool) pj_pool_release(info->pool);
+        free(info);
+        VU_SET_ERROR(VU_ERR_NO_MEMORY, "Failed to create analysis port");
+        return VU_ERR_NO_MEMORY;
+    }
+
+    /* A known beep frequency needs just its own Goertzel filter */
+    vu_analyzer_config_t analyzer_config = vu_analyzer_default_config();
+    if (beep_config) {
+        analyzer_config.min_level_db = (float)beep_config->min_level_db;
+        analyzer_config.freq_tolerance_hz = (float)beep_config->freq_tolerance_hz;
+        vu_beep_detector_configure_analyzer(beep_config, &analyzer_config);
+    }
+
+    vu_error_t err = vu_audio_port_enable_analysis(info->port, &analyzer_config, beep_config);
+    if (err == VU_OK) {
+        status = pjsua_conf_add_port(info->pool, vu_audio_port_get_pjmedia_port(info->port),
+                                     &info->slot);
+        if (status != PJ_SUCCESS) {
+            VU_SET_PJSIP_ERROR(VU_ERR_MEDIA_ERROR, status, "Failed to add analysis port");
+            err = VU_ERR_MEDIA_ERROR;
+        }
+    }
+
+    /* Connect call's receive audio to the port (what we hear from remote) */
+    if (err == VU_OK) {
+        status = pjsua_conf_connect(ci.conf_slot, info->slot);
+        if (status != PJ_SUCCESS) {
+            VU_SET_PJSIP_ERROR(VU_ERR_MEDIA_ERROR, status, "Failed to connect analysis port");
+            err = VU_ERR_MEDIA_ERROR;
+        }
+    }
+
+    if (err != VU_OK) {
+        /* The port releases the pool once the bridge has let go of it */
+        if (info->slot != PJSUA_INVALID_ID) pjsua_conf_remove_port(info->slot);
+        vu_audio_port_destroy(info->port);
+        free(info);
+        return err;
+    }
+
+    call->analysis_port = info;
+
+    VU_LOG_INFO("Live analysis connected for call %d (%u Hz)", call->pjsua_id,
+                slot_info.clock_rate);
     return VU_OK;
 }
 
 void vu_media_disconnect_analysis(vu_call_t *call)
 {
-    if (!call) return;
+    if (!call || !call->analysis_port) return;
+
+    analysis_info_t *info = (analysis_info_t *)call->analysis_port;
+
+    /* Removing the slot also drops its connection from the call. Removal
+     * is asynchronous: the port, and the pool it releases, stay alive
+     * until the bridge's clock thread has let go of it */
+    pjsua_conf_remove_port(info->slot);
+    vu_audio_port_destroy(info->port);
+    free(info);
+    call->analysis_port = NULL;
 
-    /* TODO: Disconnect and destroy analysis port */
     VU_LOG_DEBUG("Media analysis disconnected for call %d", call->pjsua_id);
 }
 
+vu_audio_port_t *vu_media_get_analysis(const vu_call_t *call)
+{
+    if (!call || !call->analysis_port) return NULL;
+    return ((const analysis_info_t *)call->analysis_port)->port;
+}
+
+void vu_media_reconnect_analysis(vu_call_t *call, pjsua_conf_port_id conf_slot)
+{
+    if (!call || !call->analysis_port || conf_slot == PJSUA_INVALID_ID) return;
+
+    analysis_info_t *info = (analysis_info_t *)call->analysis_port;
+    pjsua_conf_connect(conf_slot, info->slot);
+}
+
 vu_error_t vu_media_start_recording(vu_call_t *call, const char *path)
 {
     if (!call || !path) {
@@ -59,49 +174,84 @@ vu_error_t vu_media_start_recording(vu_call_t *call, const char *path)
         return VU_OK;
     }
 
-    /* Create WAV recorder */
-    pjsua_recorder_id rec_id;
-    pj_str_t filename = pj_str((char *)path);
-
-    pj_status_t status = pjsua_recorder_create(&filename, 0, NULL, 0, 0, &rec_id);
-    if (status != PJ_SUCCESS) {
-        VU_SET_PJSIP_ERROR(VU_ERR_MEDIA_ERROR, status, "Failed to create recorder");
-        return VU_ERR_MEDIA_ERROR;
-    }
-
-    /* Get recorder's conference port */
-    pjsua_conf_port_id rec_port = pjsua_recorder_get_conf_port(rec_id);
-
-    /* Connect call's audio to recorder */
     pjsua_call_info ci;
-    status = pjsua_call_get_info(call->pjsua_id, &ci);
+    pj_status_t status = pjsua_call_get_info(call->pjsua_id, &ci);
     if (status != PJ_SUCCESS || ci.conf_slot == PJSUA_INVALID_ID) {
-        pjsua_recorder_destroy(rec_id);
         VU_SET_ERROR(VU_ERR_MEDIA_ERROR, "Call has no active media");
         return VU_ERR_MEDIA_ERROR;
     }
 
-    /* Connect call's receive audio to recorder (what we hear from remote) */
-    status = pjsua_conf_connect(ci.conf_slot, rec_port);
+    /* Record at the call's own rate, like the analysis port */
+    pjsua_conf_port_info slot_info;
+    status = pjsua_conf_get_port_info(ci.conf_slot, &slot_info);
     if (status != PJ_SUCCESS) {
-        pjsua_recorder_destroy(rec_id);
-        VU_SET_PJSIP_ERROR(VU_ERR_MEDIA_ERROR, status, "Failed to connect recorder");
+        VU_SET_PJSIP_ERROR(VU_ERR_MEDIA_ERROR, status, "Failed to get call media port info");
         return VU_ERR_MEDIA_ERROR;
     }
 
-    /* Store recorder info */
-    recorder_info_t *rec_info = malloc(sizeof(recorder_info_t));
+    /* The bridge's clock thread only queues frames to the port; a worker
+     * hands them to the recorder, whose backend writes them to disk */
+    vu_recorder_t *recorder = vu_recorder_create(path, slot_info.clock_rate, 1);
+    if (!recorder) {
+        VU_SET_ERROR(VU_ERR_FILE_OPEN, "Failed to create recording %s", path);
+        return VU_ERR_FILE_OPEN;
+    }
+
+    recorder_info_t *rec_info = calloc(1, sizeof(recorder_info_t));
     if (!rec_info) {
-        pjsua_conf_disconnect(ci.conf_slot, rec_port);
-        pjsua_recorder_destroy(rec_id);
+        vu_recorder_destroy(recorder);
+        unlink(path);
         VU_SET_ERROR(VU_ERR_NO_MEMORY, "Failed to allocate recorder info");
         return VU_ERR_NO_MEMORY;
     }
-    rec_info->id = rec_id;
-    rec_info->port = rec_port;
+    rec_info->slot = PJSUA_INVALID_ID;
+
+    pj_pool_t *pool = pjsua_pool_create("vu_recording", 4096, 4096);
+    if (pool) {
+        rec_info->port = vu_audio_port_create(pool, slot_info.clock_rate,
+                                              slot_info.samples_per_frame /
+                                              slot_info.channel_count, 0);
+    }
+    if (!rec_info->port) {
+        if (pool) pj_pool_release(pool);
+        free(rec_info);
+        vu_recorder_destroy(recorder);
+        unlink(path);
+        VU_SET_ERROR(VU_ERR_NO_MEMORY, "Failed to create recording port");
+        return VU_ERR_NO_MEMORY;
+    }
+    vu_audio_port_set_recorder(rec_info->port, recorder);
+
+    vu_error_t err = VU_OK;
+    status = pjsua_conf_add_port(pool, vu_audio_port_get_pjmedia_port(rec_info->port),
+                                 &rec_info->slot);
+    if (status != PJ_SUCCESS) {
+        VU_SET_PJSIP_ERROR(VU_ERR_MEDIA_ERROR, status, "Failed to add recording port");
+        err = VU_ERR_MEDIA_ERROR;
+    }
+
+    /* Connect call's receive audio to recorder (what we hear from remote) */
+    if (err == VU_OK) {
+        status = pjsua_conf_connect(ci.conf_slot, rec_info->slot);
+        if (status != PJ_SUCCESS) {
+            VU_SET_PJSIP_ERROR(VU_ERR_MEDIA_ERROR, status, "Failed to connect recorder");
+            err = VU_ERR_MEDIA_ERROR;
+        }
+    }
+
+    if (err != VU_OK) {
+        /* The port closes the recording and releases the pool once the
+         * bridge has let go of it */
+        if (rec_info->slot != PJSUA_INVALID_ID) pjsua_conf_remove_port(rec_info->slot);
+        vu_audio_port_destroy(rec_info->port);
+        free(rec_info);
+        return err;
+    }
+
     call->recorder = rec_info;
 
-    VU_LOG_INFO("Started recording call %d to %s", call->pjsua_id, path);
+    VU_LOG_INFO("Started recording call %d to %s (%u Hz)", call->pjsua_id, path,
+                slot_info.clock_rate);
     return VU_OK;
 }
 
@@ -111,16 +261,12 @@ void vu_media_stop_recording(vu_call_t *call)
 
     recorder_info_t *rec_info = (recorder_info_t *)call->recorder;
 
-    /* Disconnect and destroy recorder */
-    if (call->pjsua_id != PJSUA_INVALID_ID) {
-        pjsua_call_info ci;
-        if (pjsua_call_get_info(call->pjsua_id, &ci) == PJ_SUCCESS &&
-            ci.conf_slot != PJSUA_INVALID_ID && ci.conf_slot >= 0) {
-            pjsua_conf_disconnect(ci.conf_slot, rec_info->port);
-        }
-    }
-
-    pjsua_recorder_destroy(rec_info->id);
+    /* Removing the slot also drops its connection from the call. The port
+     * may outlive this (removal is asynchronous), so the recording is
+     * taken back and finished here: the file is complete on return */
+    pjsua_conf_remove_port(rec_info->slot);
+    vu_recorder_destroy(vu_audio_port_take_recorder(rec_info->port));
+    vu_audio_port_destroy(rec_info->port);
     free(rec_info);
     call->recorder = NULL;
 
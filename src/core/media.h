@@ -8,19 +8,33 @@
 
 #include "util/error.h"
 #include "core/call.h"
+#include "audio/audio_port.h"
+#include "config/config.h"
 #include <pjsua-lib/pjsua.h>
 
 /*
- * Connect audio analysis port to call
- * Allows intercepting audio for analysis/recording
+ * Connect a live analysis port to the call's received audio: the
+ * analyzer (and, with beep_config, the beep detector) runs on each frame
+ * as it arrives, so results are available while the call is up
  */
-vu_error_t vu_media_connect_analysis(vu_call_t *call);
+vu_error_t vu_media_connect_analysis(vu_call_t *call, const vu_beep_config_t *beep_config);
 
 /*
  * Disconnect audio analysis from call
  */
 void vu_media_disconnect_analysis(vu_call_t *call);
 
+/*
+ * Get the call's live analysis port, or NULL if not connected
+ */
+vu_audio_port_t *vu_media_get_analysis(const vu_call_t *call);
+
+/*
+ * Reconnect live analysis after the call's media moved to `conf_slot`
+ * (re-INVITE, hold/unhold)
+ */
+void vu_media_reconnect_analysis(vu_call_t *call, pjsua_conf_port_id conf_slot);
+
 /*
  * Start recording call audio to WAV file
  */
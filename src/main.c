@@ -8,6 +8,12 @@
 #include "util/log.h"
 #include "util/error.h"
 #include "util/json_output.h"
+#include "audio/analysis_cache.h"
+#include "audio/analysis_pool.h"
+#include "audio/recorder.h"
+#ifndef VU_FIXED_POINT
+#include "audio/fft_plan.h"
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <signal.h>
@@ -83,6 +89,29 @@ int main(int argc, char **argv)
         vu_log_set_level(vu_log_level_from_string(config.log_level));
     }
 
+#ifndef VU_FIXED_POINT
+    /* Shared FFT plans: planner rigor and persisted wisdom */
+    vu_fft_plan_init(vu_fft_planner_from_string(config.analysis.fft_planner),
+                     config.analysis.fft_wisdom ? config.analysis.wisdom_file : NULL);
+#endif
+
+    /* Results of unchanged files are reused across `analyze` runs. Other
+     * commands analyze fresh call recordings that would never be replayed. */
+    if (config.analysis.result_cache && args.command == VU_CMD_ANALYZE) {
+        vu_analysis_cache_init(config.analysis.cache_dir,
+                               (uint64_t)config.analysis.cache_max_mb * 1024 * 1024);
+    }
+
+    /* Workers for live call analysis (started with the first call) */
+    vu_analysis_pool_init(config.analysis.live_workers, config.analysis.live_queue_frames);
+
+    /* Recordings share one io_uring when asked for and available */
+    vu_recorder_backend_t backend = vu_recorder_backend_from_string(config.audio.recorder_backend);
+    if (backend != VU_RECORDER_BACKEND_THREAD && vu_recorder_set_backend(backend) != VU_OK) {
+        VU_LOG_WARN("Recorder backend '%s' unavailable, using writer threads: %s",
+                    config.audio.recorder_backend, vu_get_last_error()->message);
+    }
+
     /* Setup signal handlers */
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
@@ -120,6 +149,14 @@ int main(int argc, char **argv)
         exit_code = 1;
     }
 
+#ifndef VU_FIXED_POINT
+    /* Saves newly measured FFTW wisdom */
+    vu_fft_plan_shutdown();
+#endif
+    vu_analysis_cache_shutdown();
+    vu_analysis_pool_shutdown();
+    vu_recorder_shutdown();
+
     VU_LOG_DEBUG("voip-utility exiting with code %d", exit_code);
     return exit_code;
 }
@@ -16,9 +16,17 @@
 #include "util/time_util.h"
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 
 extern int vu_is_running(void);
 
+/* What the live results say about the expectations so far */
+typedef enum {
+    LIVE_UNDECIDED = 0,
+    LIVE_MET,                  /* Every expectation already holds */
+    LIVE_FAILED                /* One can no longer hold */
+} live_verdict_t;
+
 struct vu_test_engine {
     const vu_config_t *config;
     vu_test_definition_t *test_def;
@@ -35,6 +43,13 @@ struct vu_test_engine {
     int caller_action_index;
     int receiver_action_index;
     uint64_t test_start_time_ms;
+
+    bool live_checks;          /* Expectations are decided as events arrive */
+    live_verdict_t verdict;
+
+    /* First beep off expect_beep_freq_hz by more than the tolerance */
+    int off_freq_beep;         /* Its index, or -1 */
+    double off_freq_hz;
 };
 
 const char *vu_test_status_name(vu_test_status_t status)
@@ -93,6 +108,7 @@ vu_test_engine_t *vu_test_engine_create(const vu_config_t *config)
 
     engine->config = config;
     engine->result.status = VU_TEST_PENDING;
+    engine->off_freq_beep = -1;
 
     return engine;
 }
@@ -127,6 +143,172 @@ vu_error_t vu_test_engine_load(vu_test_engine_t *engine, const char *test_file)
     return VU_OK;
 }
 
+/* Streaming analysis consumer: run each frame through the beep detector */
+static bool feed_beep_detector(void *user_data, const vu_analysis_frame_t *frame)
+{
+    vu_beep_detector_t *detector = user_data;
+
+    vu_beep_event_t event;
+    vu_beep_detector_process_frame(detector, frame, &event);
+    return true;
+}
+
+/* Note the first beep that is not at the expected frequency. The detector
+ * is not told that frequency, so a beep at another one is still counted
+ * and fails here instead of silently going missing. */
+static void check_beep_frequencies(vu_test_engine_t *engine, const vu_beep_event_t *beeps,
+                                   int count)
+{
+    double expected = engine->test_def->expect_beep_freq_hz;
+    if (expected <= 0) return;
+
+    for (int i = 0; i < count; i++) {
+        if (fabs(beeps[i].frequency_hz - expected) > engine->config->beep.freq_tolerance_hz) {
+            engine->off_freq_beep = i;
+            engine->off_freq_hz = beeps[i].frequency_hz;
+            return;
+        }
+    }
+}
+
+/* Take the beep results from the receiver's live analysis.
+ * Returns false if none was attached to the call. */
+static bool collect_live_beeps(vu_test_engine_t *engine)
+{
+    vu_audio_port_t *port = vu_media_get_analysis(engine->receiver_call);
+    if (!port) return false;
+
+    vu_audio_port_status_t status;
+    vu_audio_port_get_status(port, &status);
+    engine->result.beeps_detected = status.beep_count;
+
+    vu_beep_event_t *beeps = status.beep_count > 0 ?
+                             malloc((size_t)status.beep_count * sizeof(vu_beep_event_t)) : NULL;
+    if (beeps) {
+        int count = vu_audio_port_get_beeps(port, beeps, status.beep_count);
+        if (count > 0) engine->result.beep_frequency = beeps[0].frequency_hz;
+        check_beep_frequencies(engine, beeps, count);
+        free(beeps);
+    }
+
+    VU_LOG_INFO("Test: Detected %d beeps live (%.1fs of audio analyzed)",
+                engine->result.beeps_detected, status.audio_sec);
+    return true;
+}
+
+/* Analyze the receiver's recording for beeps after the call */
+static void analyze_recorded_beeps(vu_test_engine_t *engine)
+{
+    const vu_test_definition_t *def = engine->test_def;
+
+    /* Find recording path from receiver actions */
+    const char *recording_path = NULL;
+    for (int i = 0; i < def->receiver.action_count; i++) {
+        if (def->receiver.actions[i].type == VU_ACTION_RECORD_AUDIO) {
+            recording_path = def->receiver.actions[i].value;
+            break;
+        }
+    }
+    if (!recording_path || !recording_path[0]) return;
+
+    VU_LOG_INFO("Test: Analyzing recording %s for beeps", recording_path);
+
+    vu_analyzer_config_t analyzer_cfg = vu_analyzer_default_config();
+    vu_beep_config_t beep_cfg = engine->config->beep;
+    vu_beep_detector_configure_analyzer(&beep_cfg, &analyzer_cfg);
+    /* Beeps sit in the telephony band: analyze at 8 kHz */
+    analyzer_cfg.analysis_rate = 8000;
+    /* The recording's rate comes with the analyzed frames */
+    vu_beep_detector_t *detector = vu_beep_detector_create(&beep_cfg, 0);
+    if (!detector) return;
+
+    /* Frames are fed to the detector as the file is analyzed */
+    vu_error_t aerr = vu_analyzer_analyze_file_stream(recording_path, &analyzer_cfg,
+                                                      feed_beep_detector, detector, NULL);
+    if (aerr == VU_OK) {
+        const vu_beep_result_t *beep_result = vu_beep_detector_get_result(detector);
+        engine->result.beeps_detected = beep_result->valid_beep_count;
+
+        if (beep_result->beeps && beep_result->valid_beep_count > 0) {
+            engine->result.beep_frequency = beep_result->beeps[0].frequency_hz;
+            check_beep_frequencies(engine, beep_result->beeps, beep_result->valid_beep_count);
+        }
+
+        VU_LOG_INFO("Test: Detected %d beeps", engine->result.beeps_detected);
+    } else {
+        VU_LOG_WARN("Test: Failed to analyze %s: %s", recording_path,
+                    vu_get_last_error()->message);
+    }
+
+    vu_beep_detector_destroy(detector);
+}
+
+/* Whether every expectation can be judged live: beeps need the live
+ * analysis on the receiver's call (DTMF events always arrive live), and
+ * there must be something to judge */
+static bool live_checks_possible(vu_test_engine_t *engine)
+{
+    const vu_test_definition_t *def = engine->test_def;
+    if (!def->stop_early) return false;
+
+    bool any = false;
+    if (def->expect_beep_count > 0) {
+        if (!vu_media_get_analysis(engine->receiver_call)) return false;
+        any = true;
+    }
+    for (int i = 0; i < def->receiver.action_count; i++) {
+        if (def->receiver.actions[i].type == VU_ACTION_EXPECT_DTMF) any = true;
+    }
+    return any;
+}
+
+/*
+ * Judge the expectations on what has been received so far. Beep counts
+ * must match exactly, so one beep too many fails; expected DTMF must be
+ * a prefix of the received digits, so a wrong digit fails.
+ */
+static live_verdict_t live_verdict(vu_test_engine_t *engine)
+{
+    const vu_test_definition_t *def = engine->test_def;
+    bool all_met = true;
+
+    if (def->expect_beep_count > 0) {
+        vu_audio_port_status_t status;
+        vu_audio_port_get_status(vu_media_get_analysis(engine->receiver_call), &status);
+        if (status.beep_count > def->expect_beep_count) return LIVE_FAILED;
+        if (status.beep_count < def->expect_beep_count) all_met = false;
+    }
+
+    const char *received = vu_call_get_dtmf_digits(engine->receiver_call);
+    size_t received_len = strlen(received);
+    for (int i = 0; i < def->receiver.action_count; i++) {
+        if (def->receiver.actions[i].type != VU_ACTION_EXPECT_DTMF) continue;
+
+        const char *expected = def->receiver.actions[i].value;
+        size_t expected_len = strlen(expected);
+        size_t common = received_len < expected_len ? received_len : expected_len;
+        if (strncmp(received, expected, common) != 0) return LIVE_FAILED;
+        if (received_len < expected_len) all_met = false;
+    }
+
+    return all_met ? LIVE_MET : LIVE_UNDECIDED;
+}
+
+/* Re-judge the live results; true once the test is decided */
+static bool live_decided(vu_test_engine_t *engine)
+{
+    if (!engine->live_checks) return false;
+    if (engine->verdict != LIVE_UNDECIDED) return true;
+
+    engine->verdict = live_verdict(engine);
+    if (engine->verdict == LIVE_UNDECIDED) return false;
+
+    VU_LOG_INFO("Test: Expectations %s after %.2fs, ending early",
+                engine->verdict == LIVE_MET ? "met" : "failed",
+                (double)(vu_time_now_ms() - engine->test_start_time_ms) / 1000.0);
+    return true;
+}
+
 /* Execute a single action */
 static vu_error_t execute_action(vu_test_engine_t *engine, vu_call_t *call,
                                   const vu_action_t *action)
@@ -139,10 +321,11 @@ static vu_error_t execute_action(vu_test_engine_t *engine, vu_call_t *call,
 
     switch (action->type) {
     case VU_ACTION_WAIT:
-        /* Use vu_ua_poll to process PJSIP events while waiting */
+        /* Use vu_ua_poll to process PJSIP events while waiting, and stop
+         * waiting once the live results decide the test */
         {
             int wait_ms = (int)(action->float_value * 1000);
-            while (wait_ms > 0 && vu_is_running()) {
+            while (wait_ms > 0 && vu_is_running() && !live_decided(engine)) {
                 int poll_ms = (wait_ms > 100) ? 100 : wait_ms;
                 vu_ua_poll(poll_ms);
                 wait_ms -= poll_ms;
@@ -157,7 +340,7 @@ static vu_error_t execute_action(vu_test_engine_t *engine, vu_call_t *call,
         break;
 
     case VU_ACTION_EXPECT_DTMF:
-        /* DTMF verification is done post-call - skip during action execution */
+        /* Checked as digits arrive while waiting, and again after the call */
         break;
 
     case VU_ACTION_PLAY_AUDIO:
@@ -173,7 +356,7 @@ static vu_error_t execute_action(vu_test_engine_t *engine, vu_call_t *call,
         break;
 
     case VU_ACTION_EXPECT_BEEPS:
-        /* Beep detection is done post-call on recorded audio */
+        /* Beeps are counted by the live analysis on the receiver's call */
         break;
 
     case VU_ACTION_HANGUP:
@@ -199,6 +382,8 @@ vu_error_t vu_test_engine_run(vu_test_engine_t *engine)
     vu_test_definition_t *def = engine->test_def;
     engine->result.status = VU_TEST_RUNNING;
     engine->test_start_time_ms = vu_time_now_ms();
+    engine->live_checks = false;
+    engine->verdict = LIVE_UNDECIDED;
 
     VU_LOG_INFO("=== Running test: %s ===", def->name);
 
@@ -313,8 +498,23 @@ vu_error_t vu_test_engine_run(vu_test_engine_t *engine)
     engine->result.connected = true;
     VU_LOG_INFO("Test: Call connected");
 
+    /* Count beeps as they are received rather than from the recording
+     * after the call */
+    if (def->expect_beep_count > 0 && engine->receiver_call) {
+        if (vu_media_connect_analysis(engine->receiver_call, &engine->config->beep) != VU_OK) {
+            VU_LOG_WARN("Test: Live analysis unavailable (%s), using the recording",
+                        vu_get_last_error()->message);
+        }
+    }
+
+    /* With every expectation judged live, the script is cut short as soon
+     * as they are all met or one has failed */
+    engine->live_checks = live_checks_possible(engine);
+
     /* Execute receiver actions first (recording, etc.) */
     for (int i = 0; i < def->receiver.action_count; i++) {
+        if (live_decided(engine)) break;
+
         err = execute_action(engine, engine->receiver_call, &def->receiver.actions[i]);
         if (err != VU_OK) {
             engine->result.status = VU_TEST_FAILED;
@@ -324,7 +524,7 @@ vu_error_t vu_test_engine_run(vu_test_engine_t *engine)
 
     /* Execute caller actions */
     for (int i = 0; i < def->caller.action_count; i++) {
-        if (!vu_is_running()) break;
+        if (!vu_is_running() || live_decided(engine)) break;
 
         err = execute_action(engine, engine->caller_call, &def->caller.actions[i]);
         if (err != VU_OK) {
@@ -333,8 +533,10 @@ vu_error_t vu_test_engine_run(vu_test_engine_t *engine)
         }
     }
 
-    /* Wait a moment for things to settle */
-    vu_ua_poll(500);
+    /* Wait a moment for things to settle (live results are final) */
+    if (engine->verdict == LIVE_UNDECIDED) {
+        vu_ua_poll(500);
+    }
 
     /* Collect DTMF results */
     if (engine->receiver_call) {
@@ -346,58 +548,10 @@ vu_error_t vu_test_engine_run(vu_test_engine_t *engine)
         }
     }
 
-    /* Analyze recording for beeps if needed */
-    if (def->expect_beep_count > 0) {
-        /* Find recording path from receiver actions */
-        const char *recording_path = NULL;
-        for (int i = 0; i < def->receiver.action_count; i++) {
-            if (def->receiver.actions[i].type == VU_ACTION_RECORD_AUDIO) {
-                recording_path = def->receiver.actions[i].value;
-                break;
-            }
-        }
-
-        if (recording_path && recording_path[0]) {
-            VU_LOG_INFO("Test: Analyzing recording %s for beeps", recording_path);
-
-            vu_analyzer_config_t analyzer_cfg = vu_analyzer_default_config();
-            size_t frame_count = 0;
-            vu_freq_result_t *results = vu_analyzer_analyze_file(recording_path,
-                                                                  &analyzer_cfg, &frame_count);
-
-            if (results && frame_count > 0) {
-                /* PJSUA is configured for 16kHz, so recordings are 16kHz */
-                const unsigned sample_rate = 16000;
-                vu_beep_config_t beep_cfg = engine->config->beep;
-                vu_beep_detector_t *detector = vu_beep_detector_create(&beep_cfg, sample_rate);
-
-                if (detector) {
-                    double frame_duration = (double)analyzer_cfg.fft_size / 2 / (double)sample_rate;
-                    vu_level_result_t level = {0};
-
-                    for (size_t i = 0; i < frame_count; i++) {
-                        double time = i * frame_duration;
-                        level.rms_db = results[i].magnitude_db;
-                        level.is_silence = !results[i].valid;
-
-                        vu_beep_event_t event;
-                        vu_beep_detector_process(detector, &results[i], &level, time, &event);
-                    }
-
-                    const vu_beep_result_t *beep_result = vu_beep_detector_get_result(detector);
-                    engine->result.beeps_detected = beep_result->valid_beep_count;
-
-                    if (beep_result->beeps && beep_result->valid_beep_count > 0) {
-                        engine->result.beep_frequency = beep_result->beeps[0].frequency_hz;
-                    }
-
-                    VU_LOG_INFO("Test: Detected %d beeps", engine->result.beeps_detected);
-                    vu_beep_detector_destroy(detector);
-                }
-
-                vu_analyzer_free_results(results);
-            }
-        }
+    /* Beeps heard live, or from the recording if live analysis could not
+     * be attached */
+    if (def->expect_beep_count > 0 && !collect_live_beeps(engine)) {
+        analyze_recorded_beeps(engine);
     }
 
 evaluate:
@@ -425,6 +579,13 @@ evaluate:
                 def->expect_beep_count, engine->result.beeps_detected);
     }
 
+    if (test_passed && engine->off_freq_beep >= 0) {
+        test_passed = false;
+        snprintf(engine->result.error_message, sizeof(engine->result.error_message),
+                "Expected beeps at %.1f Hz, beep %d was at %.1f Hz",
+                def->expect_beep_freq_hz, engine->off_freq_beep + 1, engine->off_freq_hz);
+    }
+
     /* Check DTMF expectations from receiver actions */
     for (int i = 0; i < def->receiver.action_count && test_passed; i++) {
         if (def->receiver.actions[i].type == VU_ACTION_EXPECT_DTMF) {
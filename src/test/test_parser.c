@@ -259,8 +259,10 @@ vu_test_definition_t *vu_test_parse_file(const char *path)
         def->expect_connected = json_get_bool(expect, "connected", true);
         def->expect_beep_count = (int)json_get_number(expect, "beep_count", 0);
         def->expect_beep_freq_hz = json_get_number(expect, "beep_frequency", 0);
+        def->stop_early = json_get_bool(expect, "stop_early", true);
     } else {
         def->expect_connected = true;
+        def->stop_early = true;
     }
 
     cJSON_Delete(root);
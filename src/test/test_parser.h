@@ -57,6 +57,7 @@ typedef struct vu_test_definition {
     bool expect_connected;
     int expect_beep_count;
     double expect_beep_freq_hz;
+    bool stop_early;         /* End once live results decide the test (default true) */
 } vu_test_definition_t;
 
 /*
@@ -39,6 +39,8 @@ const char *vu_error_str(vu_error_t err)
         return "Cancelled";
     case VU_ERR_BUSY:
         return "Busy";
+    case VU_ERR_NOT_SUPPORTED:
+        return "Not supported";
 
     /* SIP errors */
     case VU_ERR_SIP_INIT:
@@ -23,6 +23,7 @@ typedef enum {
     VU_ERR_TIMEOUT = -8,
     VU_ERR_CANCELLED = -9,
     VU_ERR_BUSY = -10,
+    VU_ERR_NOT_SUPPORTED = -11,
 
     /* SIP/PJSIP errors (-100 to -199) */
     VU_ERR_SIP_INIT = -100,